@@ -0,0 +1,72 @@
+// Arena.cpp
+#include "Arena.h"
+#include <algorithm>
+#include <cstdint>
+
+Arena::Arena(size_t initialBlockSize)
+    : cursor(nullptr), limit(nullptr), lastAllocation(nullptr), nextBlockSize(std::max<size_t>(initialBlockSize, 64)), used(0) {}
+
+Arena::~Arena() {
+    for (const auto& block : blocks) {
+        ::operator delete(block.data);
+    }
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(cursor);
+    std::uintptr_t aligned = (address + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+    if (!cursor || aligned + bytes > reinterpret_cast<std::uintptr_t>(limit)) {
+        // Blocks double so a query needs O(log size) of them; oversized requests get a block of their own
+        size_t size = std::max(nextBlockSize, bytes + alignment);
+        Block block = {static_cast<char*>(::operator new(size)), size};
+        blocks.push_back(block);
+        nextBlockSize = std::max(nextBlockSize, size) * 2;
+        cursor = block.data;
+        limit = block.data + size;
+        address = reinterpret_cast<std::uintptr_t>(cursor);
+        aligned = (address + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+    }
+    char* result = reinterpret_cast<char*>(aligned);
+    cursor = result + bytes;
+    lastAllocation = result;
+    used += bytes;
+    return result;
+}
+
+void Arena::deallocate(void* pointer, size_t bytes) {
+    if (pointer && pointer == lastAllocation && static_cast<char*>(pointer) + bytes == cursor) {
+        cursor = lastAllocation;
+        lastAllocation = nullptr;
+        used -= bytes;
+    }
+}
+
+void Arena::reset() {
+    if (!blocks.empty()) {
+        auto largest = std::max_element(blocks.begin(), blocks.end(),
+                                        [](const Block& a, const Block& b) { return a.size < b.size; });
+        Block kept = *largest;
+        for (const auto& block : blocks) {
+            if (block.data != kept.data) {
+                ::operator delete(block.data);
+            }
+        }
+        blocks.assign(1, kept);
+        cursor = kept.data;
+        limit = kept.data + kept.size;
+    }
+    lastAllocation = nullptr;
+    used = 0;
+}
+
+size_t Arena::bytesUsed() const {
+    return used;
+}
+
+size_t Arena::bytesReserved() const {
+    size_t total = 0;
+    for (const auto& block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
@@ -0,0 +1,90 @@
+// Arena.h
+#pragma once
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+
+// Arena class that hands out memory by bumping a pointer through large blocks and frees it all at once,
+// for the short-lived buffers of a single query. Memory is reclaimed by reset(); individual deallocations
+// are ignored unless they free the most recent allocation. A growing vector allocates its new buffer
+// before freeing the old one, so its old buffers stay in the arena until reset(). Reserve up front
+// where the size is known.
+class Arena {
+public:
+    explicit Arena(size_t initialBlockSize = 64 * 1024);
+    ~Arena();
+
+    // Returns `bytes` bytes aligned to `alignment` (a power of two), taking a new block when needed.
+    void* allocate(size_t bytes, size_t alignment);
+    // Gives the memory back only if nothing was allocated after it, e.g. a scratch buffer freed right away.
+    void deallocate(void* pointer, size_t bytes);
+    // Releases everything allocated so far. The largest block is kept so a steady workload stops
+    // allocating altogether; all other blocks are freed.
+    void reset();
+    // Bytes handed out since construction or the last reset, and bytes held in blocks.
+    size_t bytesUsed() const;
+    size_t bytesReserved() const;
+private:
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    char* cursor;
+    char* limit;
+    char* lastAllocation;
+    size_t nextBlockSize;
+    size_t used;
+};
+
+// Allocator drawing from an Arena, or from the global heap when constructed without one, so containers
+// can take an arena where one is available without changing their type (like std::pmr, for C++11).
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    ArenaAllocator() : arena(nullptr) {}
+    ArenaAllocator(Arena* arena) : arena(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        if (!arena) {
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+        return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* pointer, size_t count) {
+        if (!arena) {
+            ::operator delete(pointer);
+            return;
+        }
+        arena->deallocate(pointer, count * sizeof(T));
+    }
+
+    Arena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena != b.arena;
+}
+
+// Vector whose buffer lives in an arena (or on the heap for a default-constructed allocator).
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// String whose characters live in an arena, for text built up and thrown away within a query.
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> ArenaString;
@@ -0,0 +1,113 @@
+// BatchCandlesticks.cpp
+#include "BatchCandlesticks.h"
+#include "BucketAggregator.h"
+#include "Parallel.h"
+#include "Timestamp.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Rows per partition; keeps each task large enough to amortize scheduling
+const size_t minRowsPerPartition = 1 << 16;
+
+// Merges one partition's buckets into the running list, both ordered by start.
+void mergeBuckets(std::vector<BucketStats>& totals, const std::vector<BucketStats>& buckets) {
+    for (const auto& bucket : buckets) {
+        auto it = std::lower_bound(totals.begin(), totals.end(), bucket.start,
+                                   [](const BucketStats& b, long long start) { return b.start < start; });
+        if (it != totals.end() && it->start == bucket.start) {
+            mergeBucketStats(*it, bucket);
+        } else {
+            totals.insert(it, bucket);
+        }
+    }
+}
+
+} // namespace
+
+CandlestickMatrix computeAllCandlesticks(const WeatherData& weatherData, const std::map<int, std::string>& countryMenu) {
+    CandlestickMatrix matrix;
+    const std::vector<long long>& timestamps = weatherData.timestamps();
+    std::vector<const std::vector<double>*> values;
+    for (const auto& it : countryMenu) {
+        const std::vector<double>* column = weatherData.column(it.second);
+        if (!column) {
+            throw std::runtime_error("Column not found: " + it.second);
+        }
+        matrix.columns.push_back(it.second);
+        values.push_back(column);
+    }
+    if (timestamps.empty()) {
+        return matrix;
+    }
+
+    // Every column shares the years from the first to the last timestamp
+    auto range = std::minmax_element(timestamps.begin(), timestamps.end());
+    int firstYear = yearOfEpochSeconds(*range.first);
+    int lastYear = yearOfEpochSeconds(*range.second);
+    size_t yearCount = static_cast<size_t>(lastYear - firstYear + 1);
+    for (int year = firstYear; year <= lastYear; ++year) {
+        matrix.years.push_back(year);
+    }
+
+    // Partitions end on year boundaries, so in time-ordered data each year is reduced by one aggregator
+    // exactly as aggregateBuckets reduces it and the closes are bit-identical to the rest of the tree
+    const size_t rows = timestamps.size();
+    size_t partitionCount = std::max<size_t>(1, std::min(workerCount() * 2, rows / minRowsPerPartition));
+    std::vector<size_t> bounds(1, 0);
+    for (size_t partition = 1; partition < partitionCount; ++partition) {
+        size_t bound = std::max(bounds.back(), rows * partition / partitionCount);
+        while (bound > 0 && bound < rows && yearOfEpochSeconds(timestamps[bound]) == yearOfEpochSeconds(timestamps[bound - 1])) {
+            ++bound;
+        }
+        bounds.push_back(bound);
+    }
+    bounds.push_back(rows);
+
+    // Every (column, row partition) pair is an independent task with its own aggregator
+    size_t columnCount = values.size();
+    std::vector<std::vector<BucketStats>> partials(columnCount * partitionCount);
+    parallelFor(columnCount * partitionCount, [&](size_t task) {
+        size_t column = task / partitionCount;
+        size_t partition = task % partitionCount;
+        size_t begin = bounds[partition];
+        size_t end = bounds[partition + 1];
+        if (begin < end) {
+            BucketAggregator aggregator(BucketSize::Year);
+            aggregator.addRange(timestamps.data() + begin, values[column]->data() + begin, end - begin);
+            partials[task].assign(aggregator.buckets().begin(), aggregator.buckets().end());
+        }
+    });
+
+    // Merge the partitions and chain open = previous close per column
+    matrix.candlesticks.resize(columnCount);
+    parallelFor(columnCount, [&](size_t column) {
+        std::vector<BucketStats> totals;
+        for (size_t partition = 0; partition < partitionCount; ++partition) {
+            const std::vector<BucketStats>& buckets = partials[column * partitionCount + partition];
+            if (totals.empty()) {
+                totals = buckets;
+            } else {
+                mergeBuckets(totals, buckets);
+            }
+        }
+
+        std::vector<Candlestick>& candles = matrix.candlesticks[column];
+        candles.reserve(yearCount);
+        double prevClose = 0.0;
+        size_t next = 0;
+        for (size_t y = 0; y < yearCount; ++y) {
+            std::string year = std::to_string(matrix.years[y]);
+            if (next == totals.size() || yearOfEpochSeconds(totals[next].start) != matrix.years[y]) {
+                candles.emplace_back(year, prevClose, prevClose, prevClose, prevClose);
+                continue;
+            }
+            const BucketStats& bucket = totals[next++];
+            candles.emplace_back(year, prevClose, bucket.mean, bucket.high, bucket.low);
+            prevClose = bucket.mean;
+        }
+    });
+
+    return matrix;
+}
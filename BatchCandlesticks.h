@@ -0,0 +1,21 @@
+// BatchCandlesticks.h
+#pragma once
+#include "Candlestick.h"
+#include "WeatherData.h"
+#include <vector>
+#include <string>
+#include <map>
+
+// Yearly candlesticks for several columns over one shared range of years.
+struct CandlestickMatrix {
+    std::vector<std::string> columns;                  // One row per column (e.g. "AT_temperature")
+    std::vector<int> years;                            // Shared year for each position in a row
+    std::vector<std::vector<Candlestick>> candlesticks; // candlesticks[column][year index]
+};
+
+// Computes yearly candlesticks for every column in countryMenu in one pass over the timestamp column,
+// parallelized across columns and row partitions that are reduced with BucketAggregator, so the values
+// are those aggregateCandlesticks gives for years. Candles follow computeCandlesticks: open is the
+// previous year's close (0 for the first year), close is the yearly mean, and missing years repeat
+// the previous close.
+CandlestickMatrix computeAllCandlesticks(const WeatherData& weatherData, const std::map<int, std::string>& countryMenu);
@@ -0,0 +1,614 @@
+// BatchMode.cpp
+#include "BatchMode.h"
+#include "Query.h"
+#include "CandlestickStream.h"
+#include "CandlestickTable.h"
+#include "TemperaturePredictor.h"
+#include "CountryColumns.h"
+#include "ColumnSchema.h"
+#include "ColumnarFile.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include "QueryServer.h"
+#include "Timestamp.h"
+#include "WeatherData.h"
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <utility>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+// One job as written on the command line or one line of a job file; expands to a query per country.
+struct BatchJob {
+    std::vector<std::string> countries;   // Country codes such as "AT", or "all"
+    std::vector<std::string> variables;   // Variables such as "temperature", or "all"
+    WeatherQuery query;                    // Everything but the column
+    OutputFormat format;
+
+    BatchJob() : countries(1, "all"), variables(1, "temperature"), format(OutputFormat::Table) {}
+};
+
+// Settings that apply to the whole run rather than to a single job.
+struct BatchSettings {
+    std::string input;
+    std::string output;                    // Directory, or empty / "-" for stdout
+    std::string jobFile;
+    std::string serveAddress;              // Run the query server instead of jobs when set
+    std::string traceFile;                 // Chrome trace written by --trace, empty for none
+    std::string convertPath;               // Write a columnar file instead of running jobs when set
+    size_t blockRows;                      // Rows per block of the columnar file
+    size_t threads;
+    size_t cacheEntries;
+    double followSeconds;                  // Poll interval of --follow, 0 when not following
+    bool profile;
+
+    BatchSettings()
+        : input("weather_data.csv"), blockRows(defaultColumnarBlockRows), threads(0), cacheEntries(256), followSeconds(0.0), profile(false) {}
+};
+
+void printUsage(std::ostream& out) {
+    out << "Usage: weather_app [options]\n"
+           "  --input FILE            CSV or columnar file to load (default weather_data.csv)\n"
+           "  --countries LIST        Comma-separated country codes, e.g. AT,DE, or 'all' (default all)\n"
+           "  --variable LIST         Comma-separated variables, e.g. radiation_direct_horizontal, or 'all'\n"
+           "                          (default temperature); only the selected columns are loaded\n"
+           "  --aggregate SIZE        hour, day, week, month or year (default year)\n"
+           "  --years A-B             Keep candlesticks from years A to B\n"
+           "  --open/--high/--low/--close MIN:MAX\n"
+           "                          Keep candlesticks whose field lies in [MIN, MAX]\n"
+           "  --where COLUMN:MIN:MAX  Keep candlesticks whose bucket mean of COLUMN lies in [MIN, MAX];\n"
+           "                          COLUMN is another variable of the same country (e.g.\n"
+           "                          radiation_direct_horizontal) or a full column name. Repeatable\n"
+           "  --predict A-B           Predict yearly candlesticks for years A to B (spanning under 1000 years)\n"
+           "  --forecast N            Forecast N buckets past the data, 1 to 100000\n"
+           "  --model NAME            Forecast model: linear, harmonic or holt-winters (default linear)\n"
+           "  --format FORMAT         table, plot, csv or json (default table)\n"
+           "  --output DIR            Write one file per result into DIR instead of stdout\n"
+           "  --jobs FILE             Read one job per line (job options only, '#' starts a comment)\n"
+           "  --threads N             Number of jobs or requests run at once (default: hardware threads)\n"
+           "  --follow SECONDS        Keep running, polling the input for appended rows and printing\n"
+           "                          each candlestick as its bucket is finished\n"
+           "  --serve ADDRESS         Serve JSON queries on unix:PATH or tcp:PORT instead of running jobs\n"
+           "                          (loads the columns --countries and --variable select)\n"
+           "  --cache N               Responses the server keeps in its LRU cache (default 256)\n"
+           "  --convert FILE          Write the columns --countries and --variable select to a compressed\n"
+           "                          columnar file instead of running jobs; use it as --input later\n"
+           "  --block-rows N          Rows per block of the columnar file (default 1024)\n"
+           "  --profile               Print time, allocations and counters per stage to stderr when done\n"
+           "  --trace FILE            Like --profile, and also write a Chrome trace (chrome://tracing) to FILE\n"
+           "  --help                  Show this message\n";
+}
+
+// Splits "A<separator>B" into two numbers, throwing if either half is not one.
+template <typename T>
+void parsePair(const std::string& option, const std::string& text, char separator, T& first, T& second) {
+    size_t split = text.find(separator, 1); // Allow a leading minus on the first number
+    std::istringstream firstStream(split == std::string::npos ? "" : text.substr(0, split));
+    std::istringstream secondStream(split == std::string::npos ? "" : text.substr(split + 1));
+    if (!(firstStream >> first) || !(secondStream >> second) || !firstStream.eof() || !secondStream.eof()) {
+        throw std::runtime_error("Invalid value '" + text + "' for " + option);
+    }
+}
+
+// Parses a whole number in [minimum, maximum], throwing the usage error for anything else (signs,
+// trailing characters, overflow).
+size_t parseCount(const std::string& option, const std::string& text, size_t minimum, size_t maximum) {
+    char* end;
+    errno = 0;
+    unsigned long long count = std::strtoull(text.c_str(), &end, 10);
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0])) || *end != '\0' || errno == ERANGE ||
+        count < minimum || count > maximum) {
+        throw std::runtime_error("Invalid value '" + text + "' for " + option + " (expected " + std::to_string(minimum) +
+                                 " to " + std::to_string(maximum) + ")");
+    }
+    return static_cast<size_t>(count);
+}
+
+// Parses a plain decimal number of seconds in [minimum, maximum], rejecting signs, exponents, trailing
+// characters and non-finite values like parseCount does.
+double parseSeconds(const std::string& option, const std::string& text, double minimum, double maximum) {
+    char* end;
+    errno = 0;
+    double seconds = std::strtod(text.c_str(), &end);
+    bool plain = !text.empty() && text.find_first_not_of("0123456789.") == std::string::npos;
+    if (!plain || *end != '\0' || errno == ERANGE || !(seconds >= minimum && seconds <= maximum)) {
+        std::ostringstream expected;
+        expected << minimum << " to " << maximum;
+        throw std::runtime_error("Invalid value '" + text + "' for " + option + " (expected " + expected.str() + " seconds)");
+    }
+    return seconds;
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Applies one job option; returns false if the option is not a job option.
+bool parseJobOption(const std::string& option, const std::string& value, BatchJob& job) {
+    static const char* fieldOptions[] = {"--open", "--high", "--low", "--close"};
+    WeatherQuery& query = job.query;
+
+    if (option == "--countries") {
+        job.countries = splitList(value);
+        if (job.countries.empty()) {
+            throw std::runtime_error("No countries given for --countries");
+        }
+    } else if (option == "--variable") {
+        job.variables = splitList(value);
+        if (job.variables.empty()) {
+            throw std::runtime_error("No variables given for --variable");
+        }
+    } else if (option == "--aggregate") {
+        if (!parseBucketSize(value, query.bucketSize)) {
+            throw std::runtime_error("Unknown aggregation '" + value + "'");
+        }
+    } else if (option == "--years") {
+        parsePair(option, value, '-', query.startYear, query.endYear);
+        query.hasYearRange = true;
+    } else if (option == "--predict") {
+        parsePair(option, value, '-', query.predictStart, query.predictEnd);
+        query.predict = true;
+        checkQueryLimits(query);
+    } else if (option == "--forecast") {
+        query.forecastPeriods = parseCount(option, value, 1, maxForecastPeriods);
+    } else if (option == "--where") {
+        size_t split = value.find(':');
+        ColumnRange range;
+        range.column = value.substr(0, split);
+        if (split == std::string::npos || range.column.empty()) {
+            throw std::runtime_error("Invalid value '" + value + "' for " + option);
+        }
+        try {
+            parsePair(option, value.substr(split + 1), ':', range.minValue, range.maxValue);
+        } catch (const std::runtime_error&) {
+            throw std::runtime_error("Invalid value '" + value + "' for " + option);
+        }
+        query.where.push_back(range);
+    } else if (option == "--model") {
+        if (!parseForecastModel(value, query.model)) {
+            throw std::runtime_error("Unknown forecast model '" + value + "'");
+        }
+    } else if (option == "--format") {
+        if (!parseOutputFormat(value, job.format)) {
+            throw std::runtime_error("Unknown format '" + value + "'");
+        }
+    } else {
+        for (int f = 0; f < 4; ++f) {
+            if (option == fieldOptions[f]) {
+                parsePair(option, value, ':', query.ranges[f].minValue, query.ranges[f].maxValue);
+                query.ranges[f].enabled = true;
+                return true;
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+// Reads a job file: each non-blank line holds job options separated by whitespace.
+std::vector<BatchJob> readJobFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open job file: " + filename);
+    }
+
+    std::vector<BatchJob> jobs;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string option, value;
+        BatchJob job;
+        bool any = false;
+        while (words >> option) {
+            if (!(words >> value) || !parseJobOption(option, value, job)) {
+                throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": invalid option '" + option + "'");
+            }
+            any = true;
+        }
+        if (any) {
+            jobs.push_back(job);
+        }
+    }
+    return jobs;
+}
+
+// Resolves the job's countries and variables to columns, variable by variable in header order for "all".
+std::vector<std::string> resolveColumns(const BatchJob& job, const ColumnSchema& schema) {
+    std::vector<std::string> variables;
+    for (const auto& variable : job.variables) {
+        if (variable == "all") {
+            variables.insert(variables.end(), schema.variables().begin(), schema.variables().end());
+        } else if (!schema.hasVariable(variable)) {
+            throw std::runtime_error("Unknown variable '" + variable + "'");
+        } else {
+            variables.push_back(variable);
+        }
+    }
+
+    std::vector<std::string> columns;
+    for (const auto& variable : variables) {
+        for (const auto& country : job.countries) {
+            if (country == "all") {
+                for (const auto& spec : schema.columns()) {
+                    if (spec.variable == variable) {
+                        columns.push_back(spec.name);
+                    }
+                }
+                continue;
+            }
+            const ColumnSpec* spec = schema.find(country, variable);
+            if (!spec) {
+                bool known = std::find(schema.countries().begin(), schema.countries().end(), country) != schema.countries().end();
+                throw std::runtime_error(known ? "No " + variable + " column for country '" + country + "'"
+                                               : "Unknown country '" + country + "'");
+            }
+            columns.push_back(spec->name);
+        }
+    }
+    return columns;
+}
+
+// Column a --where predicate reads for a query: the named variable of the query column's country, or
+// else a full column name.
+std::string resolveWhereColumn(const ColumnSchema& schema, const std::string& queryColumn, const std::string& name) {
+    for (const auto& spec : schema.columns()) {
+        if (spec.name == queryColumn) {
+            if (const ColumnSpec* other = schema.find(spec.country, name)) {
+                return other->name;
+            }
+            break;
+        }
+    }
+    for (const auto& spec : schema.columns()) {
+        if (spec.name == name) {
+            return name;
+        }
+    }
+    throw std::runtime_error("No column '" + name + "' for --where on " + queryColumn);
+}
+
+// Menu of the distinct columns the queries read, in first-use order; only these are loaded.
+std::map<int, std::string> projectedColumns(const std::vector<std::string>& columns) {
+    std::map<int, std::string> projection;
+    std::vector<std::string> seen;
+    for (const auto& column : columns) {
+        if (std::find(seen.begin(), seen.end(), column) == seen.end()) {
+            seen.push_back(column);
+            projection[static_cast<int>(seen.size())] = column;
+        }
+    }
+    return projection;
+}
+
+const char* fileExtension(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::Csv: return ".csv";
+        case OutputFormat::Json: return ".json";
+        default: return ".txt";
+    }
+}
+
+// Writes one result to stdout, or to its file in the output directory (appending after the first write).
+bool emitOutput(const BatchSettings& settings, const std::string& name, const std::string& text, bool append) {
+    if (settings.output.empty()) {
+        std::cout << text;
+        return true;
+    }
+    std::string path = settings.output + "/" + name;
+    std::ofstream file(path, append ? std::ios::binary | std::ios::app : std::ios::binary);
+    if (!(file << text)) {
+        std::cerr << "Error: Could not write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Writes the candlesticks sealed since the last update; CSV updates continue the first block without a header.
+void writeFollowUpdate(const QueryResult& result, OutputFormat format, bool first, std::ostream& out) {
+    if (format != OutputFormat::Csv || first) {
+        writeQueryResult(result, format, out);
+        return;
+    }
+    writeCandlesticksAsCsv(result.candlesticks, out, false);
+    if (!result.predictions.empty()) {
+        out << "\n";
+        writeCandlesticksAsCsv(result.predictions, out);
+    }
+}
+
+// Prints the candlesticks each query keeps, then polls the file and prints only those sealed by appended rows.
+// Every per-query structure (buckets, time index, predictor) is updated incrementally, so an update costs
+// O(appended rows) rather than a pass over the history. Runs until the process is stopped.
+int followQueries(WeatherData& weatherData, const std::vector<WeatherQuery>& queries, const std::vector<OutputFormat>& formats,
+                  const std::vector<std::string>& outputNames, const BatchSettings& settings) {
+    std::vector<CandlestickStream> streams;
+    std::vector<CandlestickFilter> filters;
+    std::vector<TimeIndex> indexes;             // Extended with each stream's newly sealed candlesticks
+    std::vector<TemperaturePredictor> predictors(queries.size());
+    for (const auto& query : queries) {
+        if (query.forecastPeriods) {
+            throw std::runtime_error("--forecast cannot be combined with --follow");
+        }
+        if (!query.where.empty()) {
+            throw std::runtime_error("--where cannot be combined with --follow");
+        }
+        streams.emplace_back(weatherData, query.column, query.bucketSize);
+        filters.push_back(queryFilter(query));
+    }
+    for (const auto& stream : streams) {
+        indexes.emplace_back(stream.sealed());
+    }
+
+    const std::chrono::milliseconds interval(static_cast<long long>(settings.followSeconds * 1000));
+    bool first = true;
+    while (true) {
+        std::vector<std::string> outputs(queries.size());
+        parallelFor(queries.size(), [&](size_t i) {
+            const WeatherQuery& query = queries[i];
+            const size_t sealedBefore = streams[i].sealed().size();
+            if (!streams[i].update() && !first) {
+                return;
+            }
+            const std::vector<Candlestick>& sealed = streams[i].sealed();
+            indexes[i].extend(sealed);
+
+            QueryResult result;
+            result.column = query.column;
+            result.candlesticks = filters[i].apply(sealed, indexes[i], sealedBefore);
+            if (result.candlesticks.empty() && !first) {
+                return;
+            }
+            if (query.predict) {
+                for (const auto& candle : result.candlesticks) {
+                    predictors[i].addCandlestick(candle);
+                }
+                if (predictors[i].observationCount() >= 2) {
+                    ArenaVector<Candlestick> predictions = predictors[i].predictTemperatures(query.predictStart, query.predictEnd);
+                    result.predictions.assign(predictions.begin(), predictions.end());
+                }
+            }
+            std::ostringstream out;
+            writeFollowUpdate(result, formats[i], first, out);
+            outputs[i] = out.str();
+        }, settings.threads);
+
+        for (size_t i = 0; i < queries.size(); ++i) {
+            if (!outputs[i].empty() && !emitOutput(settings, outputNames[i], outputs[i], !first)) {
+                return 1;
+            }
+        }
+        std::cout.flush();
+        first = false;
+
+        std::this_thread::sleep_for(interval);
+        weatherData.refresh();
+    }
+}
+
+// Time range [from, to) of the candlesticks the queries keep: the union of their year ranges, or
+// unbounded when any query needs the whole history (no year range, or a forecast).
+std::pair<long long, long long> queriedTimeRange(const std::vector<WeatherQuery>& queries) {
+    long long from = std::numeric_limits<long long>::max();
+    long long to = std::numeric_limits<long long>::min();
+    for (const auto& query : queries) {
+        if (!query.hasYearRange || query.forecastPeriods) {
+            return std::make_pair(std::numeric_limits<long long>::min(), std::numeric_limits<long long>::max());
+        }
+        from = std::min(from, daysFromCivil(query.startYear, 1, 1) * 86400);
+        to = std::max(to, daysFromCivil(static_cast<long long>(query.endYear) + 1, 1, 1) * 86400);
+    }
+    return std::make_pair(from, to);
+}
+
+// Prints the --profile breakdown and writes the --trace file, if either was requested.
+void reportProfile(const BatchSettings& settings) {
+    if (!settings.profile) {
+        return;
+    }
+    setProfilingEnabled(false);
+    writeProfileReport(std::cerr);
+    if (!settings.traceFile.empty()) {
+        std::ofstream trace(settings.traceFile);
+        writeChromeTrace(trace);
+        if (!trace) {
+            std::cerr << "Warning: Unable to write trace file: " << settings.traceFile << std::endl;
+        }
+    }
+}
+
+} // namespace
+
+int runBatchMode(int argc, char* argv[]) {
+    BatchSettings settings;
+    BatchJob commandLineJob;
+    bool haveCommandLineJob = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option == "--help" || option == "-h") {
+                printUsage(std::cout);
+                return 0;
+            }
+            if (option == "--profile") {
+                settings.profile = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for " + option);
+            }
+            std::string value = argv[++i];
+            if (option == "--input") {
+                settings.input = value;
+            } else if (option == "--output") {
+                settings.output = value == "-" ? "" : value;
+            } else if (option == "--jobs") {
+                settings.jobFile = value;
+            } else if (option == "--threads") {
+                settings.threads = parseCount(option, value, 1, 4096);
+            } else if (option == "--follow") {
+                settings.followSeconds = parseSeconds(option, value, 0.001, 86400.0);
+            } else if (option == "--serve") {
+                settings.serveAddress = value;
+            } else if (option == "--trace") {
+                settings.traceFile = value;
+                settings.profile = true;
+            } else if (option == "--convert") {
+                settings.convertPath = value;
+            } else if (option == "--block-rows") {
+                settings.blockRows = parseCount(option, value, 1, std::numeric_limits<uint32_t>::max());
+            } else if (option == "--cache") {
+                settings.cacheEntries = parseCount(option, value, 0, 1 << 20);
+            } else if (parseJobOption(option, value, commandLineJob)) {
+                haveCommandLineJob = true;
+            } else {
+                throw std::runtime_error("Unknown option " + option);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n";
+        printUsage(std::cerr);
+        return 2;
+    }
+
+    if (settings.profile) {
+        if (!profilingCompiledIn()) {
+            std::cerr << "Warning: --profile has no effect, profiling was compiled out of this build." << std::endl;
+        }
+        setProfilingEnabled(true);
+    }
+
+    if (!settings.serveAddress.empty()) {
+        try {
+            // The command-line job's countries and variables select the columns the server loads
+            std::vector<std::string> columnNames = getColumnNames(settings.input);
+            std::vector<std::string> columns = resolveColumns(commandLineJob, ColumnSchema(columnNames));
+            std::map<int, std::string> countryMenu = projectedColumns(columns);
+            WeatherData weatherData(settings.input, columnNames, countryMenu);
+            RollupPyramid rollups = loadRollups(settings.input, weatherData, columns);
+            QueryService service(weatherData, countryMenu, settings.cacheEntries, &rollups);
+            ServerOptions options;
+            options.address = settings.serveAddress;
+            options.threads = settings.threads;
+            runQueryServer(service, options);
+            reportProfile(settings);
+            return 0;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (!settings.convertPath.empty()) {
+        try {
+            std::vector<std::string> columnNames = getColumnNames(settings.input);
+            std::vector<std::string> columns = resolveColumns(commandLineJob, ColumnSchema(columnNames));
+            WeatherData weatherData(settings.input, columnNames, projectedColumns(columns));
+            writeColumnarFile(settings.convertPath, weatherData, columnNames[0], columns, settings.blockRows);
+            std::cerr << "Debug: Wrote " << weatherData.rowCount() << " rows and " << columns.size() << " columns to "
+                      << settings.convertPath << ".\n";
+            reportProfile(settings);
+            return 0;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        std::vector<BatchJob> jobs;
+        if (!settings.jobFile.empty()) {
+            jobs = readJobFile(settings.jobFile);
+        }
+        if (haveCommandLineJob || jobs.empty()) {
+            jobs.insert(jobs.begin(), commandLineJob);
+        }
+
+        std::vector<std::string> columnNames = getColumnNames(settings.input);
+        ColumnSchema schema(columnNames);
+
+        // Expand every job into one query per country before loading, so bad arguments fail fast
+        std::vector<WeatherQuery> queries;
+        std::vector<OutputFormat> formats;
+        std::vector<std::string> outputNames;
+        std::vector<std::string> columns;
+        for (size_t j = 0; j < jobs.size(); ++j) {
+            for (const auto& column : resolveColumns(jobs[j], schema)) {
+                WeatherQuery query = jobs[j].query;
+                query.column = column;
+                for (auto& range : query.where) {
+                    range.column = resolveWhereColumn(schema, column, range.column);
+                    columns.push_back(range.column);
+                }
+                queries.push_back(query);
+                formats.push_back(jobs[j].format);
+                outputNames.push_back("job" + std::to_string(j + 1) + "_" + column + fileExtension(jobs[j].format));
+                columns.push_back(column);
+            }
+        }
+
+        // Load only the columns the queries read, once, and share the read-only dataset between all queries.
+        // From a columnar file only the blocks the queried years depend on are decoded.
+        if (settings.followSeconds > 0.0) {
+            WeatherData weatherData(settings.input, columnNames, projectedColumns(columns));
+            return followQueries(weatherData, queries, formats, outputNames, settings);
+        }
+        std::pair<long long, long long> range = queriedTimeRange(queries);
+        WeatherData weatherData(settings.input, columnNames, projectedColumns(columns), range.first, range.second);
+
+        std::vector<std::string> outputs(queries.size());
+        std::vector<std::string> errors(queries.size());
+        parallelFor(queries.size(), [&](size_t i) {
+            try {
+                std::ostringstream out;
+                writeQueryResult(runQuery(weatherData, queries[i]), formats[i], out);
+                outputs[i] = out.str();
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        }, settings.threads);
+
+        // Emit results in job order regardless of which finished first
+        int status = 0;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            if (!errors[i].empty()) {
+                std::cerr << "Error in " << outputNames[i] << ": " << errors[i] << std::endl;
+                status = 1;
+                continue;
+            }
+            if (!emitOutput(settings, outputNames[i], outputs[i], false)) {
+                status = 1;
+            }
+        }
+        std::cout.flush();
+        reportProfile(settings);
+        return status;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,11 @@
+// BatchMode.h
+#pragma once
+
+// Runs the analysis non-interactively from command-line arguments (and optionally a job file), writing
+// each result to stdout or to files in an output directory, or serves queries with --serve. Returns the process exit code.
+//
+//   weather_app --input weather_data.csv --countries AT,DE --aggregate month --years 1990-2000 --format csv
+//   weather_app --input weather_data.csv --jobs jobs.txt --output results --threads 4
+//   weather_app --input live.csv --countries AT --aggregate hour --format csv --follow 5
+//   weather_app --input weather_data.csv --serve unix:/tmp/weather.sock --cache 1024
+int runBatchMode(int argc, char* argv[]);
@@ -0,0 +1,152 @@
+// BinaryFormat.cpp
+#include "BinaryFormat.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
+namespace {
+
+#ifndef _WIN32
+// Writes the whole buffer to a file descriptor, returning false on failure.
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+#endif
+
+} // namespace
+
+bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+uint64_t payloadChecksum(const char* data, size_t size) {
+    uint64_t hash = 1469598103934665603ULL;
+    size_t words = size / 8;
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t word;
+        std::memcpy(&word, data + i * 8, 8);
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+    for (size_t i = words * 8; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+size_t paddedTo8(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+void appendNames(std::vector<char>& buffer, const std::vector<std::string>& names) {
+    for (const auto& name : names) {
+        uint32_t length = static_cast<uint32_t>(name.size());
+        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&length), reinterpret_cast<const char*>(&length) + 4);
+        buffer.insert(buffer.end(), name.begin(), name.end());
+    }
+    buffer.resize(paddedTo8(buffer.size()), '\0');
+}
+
+bool readNames(const char*& p, const char* end, const char* payloadStart, size_t count, std::vector<std::string>& names) {
+    names.clear();
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t length;
+        if (end - p < 4) return false;
+        std::memcpy(&length, p, 4);
+        p += 4;
+        if (static_cast<size_t>(end - p) < length) {
+            return false;
+        }
+        names.push_back(std::string(p, length));
+        p += length;
+    }
+    p = payloadStart + paddedTo8(static_cast<size_t>(p - payloadStart));
+    return p <= end;
+}
+
+bool matchNames(const char*& p, const char* end, const char* payloadStart, const std::vector<std::string>& expected) {
+    for (const auto& name : expected) {
+        uint32_t length;
+        if (end - p < 4) return false;
+        std::memcpy(&length, p, 4);
+        p += 4;
+        if (static_cast<size_t>(end - p) < length || length != name.size() || name.compare(0, length, p, length) != 0) {
+            return false;
+        }
+        p += length;
+    }
+    p = payloadStart + paddedTo8(static_cast<size_t>(p - payloadStart));
+    return p <= end;
+}
+
+// The temporary gets a unique name in the same directory, so processes writing the same cache at once
+// never share it, and on POSIX rename() swaps it in atomically: readers see the old file or the new one.
+
+void replaceFile(const std::string& path, const void* header, size_t headerSize, const std::vector<char>& payload) {
+#ifndef _WIN32
+    std::string pattern = path + ".tmpXXXXXX";
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+    int fd = ::mkstemp(name.data());
+    if (fd < 0) {
+        throw std::runtime_error("Unable to write " + pattern + ": " + std::strerror(errno));
+    }
+    const std::string temporary(name.data());
+    ::fchmod(fd, 0644); // mkstemp creates the file private to the owner
+    bool written = writeAll(fd, static_cast<const char*>(header), headerSize) && writeAll(fd, payload.data(), payload.size());
+    if (::close(fd) != 0) {
+        written = false;
+    }
+    if (!written) {
+        ::unlink(temporary.c_str());
+        throw std::runtime_error("Unable to write " + temporary);
+    }
+    if (::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        throw std::runtime_error("Unable to replace " + path);
+    }
+#else
+    const std::string temporary = path + ".tmp" + std::to_string(_getpid());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("Unable to write " + temporary);
+        }
+        out.write(static_cast<const char*>(header), static_cast<std::streamsize>(headerSize));
+        out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        if (!out) {
+            out.close();
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Unable to write " + temporary);
+        }
+    }
+    std::remove(path.c_str()); // rename() does not replace existing files on Windows
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Unable to replace " + path);
+    }
+#endif
+}
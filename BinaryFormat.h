@@ -0,0 +1,33 @@
+// BinaryFormat.h
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+
+// Helpers shared by the binary sidecar files (snapshot, rollups, columnar files). Arrays are stored in host byte order,
+// which is only the documented little-endian format on little-endian hosts.
+
+// True when the host stores integers little-endian.
+bool hostIsLittleEndian();
+
+// FNV-1a over 64-bit words, with any trailing bytes hashed one at a time.
+uint64_t payloadChecksum(const char* data, size_t size);
+
+// Rounds a size up to a multiple of eight bytes.
+size_t paddedTo8(size_t size);
+
+// Appends length-prefixed names and pads the buffer so the arrays that follow are 8-byte aligned.
+void appendNames(std::vector<char>& buffer, const std::vector<std::string>& names);
+
+// Reads length-prefixed names written by appendNames, comparing them with the expected list and
+// skipping the padding after them. Returns false on any mismatch.
+bool matchNames(const char*& p, const char* end, const char* payloadStart, const std::vector<std::string>& expected);
+
+// Reads `count` length-prefixed names written by appendNames and skips the padding after them.
+// Returns false if the buffer ends early.
+bool readNames(const char*& p, const char* end, const char* payloadStart, size_t count, std::vector<std::string>& names);
+
+// Writes header and payload to a uniquely named temporary file next to `path` and renames it over
+// `path`, atomically on POSIX. Throws on I/O failure.
+void replaceFile(const std::string& path, const void* header, size_t headerSize, const std::vector<char>& payload);
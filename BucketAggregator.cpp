@@ -0,0 +1,276 @@
+// BucketAggregator.cpp
+#include "BucketAggregator.h"
+#include "CandleSeries.h"
+#include "Timestamp.h"
+#include "Kernels.h"
+#include "FastParse.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Shortest run worth handing to the vector kernels
+const size_t minKernelRun = 16;
+
+} // namespace
+
+long long bucketStart(long long seconds, BucketSize size) {
+    long long days = daysFromEpochSeconds(seconds);
+    long long year;
+    unsigned month, day;
+
+    switch (size) {
+        case BucketSize::Hour:
+            return seconds - (seconds % 3600 + 3600) % 3600;
+        case BucketSize::Day:
+            return days * 86400;
+        case BucketSize::Week:
+            // 1970-01-01 was a Thursday, so Monday is three days behind in the cycle
+            return (days - ((days + 3) % 7 + 7) % 7) * 86400;
+        case BucketSize::Month:
+            civilFromDays(days, year, month, day);
+            return daysFromCivil(year, month, 1) * 86400;
+        case BucketSize::Year:
+            civilFromDays(days, year, month, day);
+            return daysFromCivil(year, 1, 1) * 86400;
+    }
+    return seconds;
+}
+
+long long nextBucketStart(long long start, BucketSize size) {
+    long long year;
+    unsigned month, day;
+
+    switch (size) {
+        case BucketSize::Hour:
+            return start + 3600;
+        case BucketSize::Day:
+            return start + 86400;
+        case BucketSize::Week:
+            return start + 7 * 86400;
+        case BucketSize::Month:
+            civilFromDays(daysFromEpochSeconds(start), year, month, day);
+            return month == 12 ? daysFromCivil(year + 1, 1, 1) * 86400 : daysFromCivil(year, month + 1, 1) * 86400;
+        case BucketSize::Year:
+            civilFromDays(daysFromEpochSeconds(start), year, month, day);
+            return daysFromCivil(year + 1, 1, 1) * 86400;
+    }
+    return start;
+}
+
+std::string bucketLabel(long long start, BucketSize size) {
+    long long year;
+    unsigned month, day;
+    civilFromDays(daysFromEpochSeconds(start), year, month, day);
+
+    char label[32];
+    switch (size) {
+        case BucketSize::Hour:
+            std::snprintf(label, sizeof(label), "%04lld-%02u-%02uT%02u", year, month, day,
+                          static_cast<unsigned>((start - daysFromEpochSeconds(start) * 86400) / 3600));
+            break;
+        case BucketSize::Day:
+        case BucketSize::Week:
+            std::snprintf(label, sizeof(label), "%04lld-%02u-%02u", year, month, day);
+            break;
+        case BucketSize::Month:
+            std::snprintf(label, sizeof(label), "%04lld-%02u", year, month);
+            break;
+        case BucketSize::Year:
+        default:
+            std::snprintf(label, sizeof(label), "%lld", year);
+            break;
+    }
+    return label;
+}
+
+const char* bucketSizeName(BucketSize size) {
+    switch (size) {
+        case BucketSize::Hour: return "hour";
+        case BucketSize::Day: return "day";
+        case BucketSize::Week: return "week";
+        case BucketSize::Month: return "month";
+        case BucketSize::Year: return "year";
+    }
+    return "year";
+}
+
+bool parseBucketSize(const std::string& name, BucketSize& size) {
+    static const BucketSize sizes[] = {BucketSize::Hour, BucketSize::Day, BucketSize::Week, BucketSize::Month, BucketSize::Year};
+    for (BucketSize candidate : sizes) {
+        if (name == bucketSizeName(candidate)) {
+            size = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+double BucketStats::variance() const {
+    return count ? m2 / count : 0.0;
+}
+
+void mergeBucketStats(BucketStats& into, const BucketStats& from) {
+    if (from.count == 0) {
+        return;
+    }
+    if (from.openTime < into.openTime || into.count == 0) {
+        into.openTime = from.openTime;
+        into.open = from.open;
+    }
+    if (from.closeTime >= into.closeTime || into.count == 0) {
+        into.closeTime = from.closeTime;
+        into.close = from.close;
+    }
+    into.high = into.count == 0 ? from.high : std::max(into.high, from.high);
+    into.low = into.count == 0 ? from.low : std::min(into.low, from.low);
+
+    size_t total = into.count + from.count;
+    double delta = from.mean - into.mean;
+    into.mean += delta * from.count / total;
+    into.m2 += from.m2 + delta * delta * (static_cast<double>(into.count) * from.count / total);
+    into.count = total;
+}
+
+BucketAggregator::BucketAggregator(BucketSize size, Arena* arena) : bucketSize(size), stats(ArenaAllocator<BucketStats>(arena)) {}
+
+// Appends to the newest bucket in the common in-order case; out-of-order readings binary-search for theirs.
+
+BucketStats& BucketAggregator::bucketFor(long long start, long long timestamp, double value) {
+    if (!stats.empty() && stats.back().start == start) {
+        return stats.back();
+    }
+    auto it = std::lower_bound(stats.begin(), stats.end(), start,
+                               [](const BucketStats& b, long long s) { return b.start < s; });
+    if (it == stats.end() || it->start != start) {
+        BucketStats fresh;
+        fresh.start = start;
+        fresh.open = fresh.high = fresh.low = fresh.close = value;
+        fresh.count = 0;
+        fresh.mean = 0.0;
+        fresh.m2 = 0.0;
+        fresh.openTime = fresh.closeTime = timestamp;
+        it = stats.insert(it, fresh);
+    }
+    return *it;
+}
+
+void BucketAggregator::add(long long timestamp, double value) {
+    if (std::isnan(value)) {
+        return;
+    }
+
+    BucketStats& bucket = bucketFor(bucketStart(timestamp, bucketSize), timestamp, value);
+    if (timestamp < bucket.openTime) {
+        bucket.openTime = timestamp;
+        bucket.open = value;
+    }
+    if (timestamp >= bucket.closeTime) {
+        bucket.closeTime = timestamp;
+        bucket.close = value;
+    }
+    bucket.high = std::max(bucket.high, value);
+    bucket.low = std::min(bucket.low, value);
+
+    ++bucket.count;
+    double delta = value - bucket.mean;
+    bucket.mean += delta / bucket.count;
+    bucket.m2 += delta * (value - bucket.mean);
+}
+
+// Splits the input into runs of time-ordered readings that share a bucket and reduces each run with the
+// vector kernels, merging its statistics into the bucket.
+
+void BucketAggregator::addRange(const long long* timestamps, const double* values, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        long long start = bucketStart(timestamps[i], bucketSize);
+        long long next = nextBucketStart(start, bucketSize);
+        size_t end = i + 1;
+        while (end < count && timestamps[end] >= timestamps[end - 1] && timestamps[end] < next) {
+            ++end;
+        }
+
+        size_t n = end - i;
+        double sum = n >= minKernelRun ? simdSum(values + i, n) : 0.0;
+        if (n < minKernelRun || std::isnan(sum)) {
+            // Short runs, and runs with missing readings, go through the per-reading path
+            for (size_t k = i; k < end; ++k) {
+                add(timestamps[k], values[k]);
+            }
+            i = end;
+            continue;
+        }
+
+        BucketStats run;
+        run.start = start;
+        run.open = values[i];
+        run.close = values[end - 1];
+        run.high = simdMax(values + i, n);
+        run.low = simdMin(values + i, n);
+        run.count = n;
+        run.mean = sum / n;
+        run.m2 = simdSumSquaredDeviations(values + i, n, run.mean);
+        run.openTime = timestamps[i];
+        run.closeTime = timestamps[end - 1];
+        mergeBucketStats(bucketFor(start, timestamps[i], values[i]), run);
+        i = end;
+    }
+}
+
+const ArenaVector<BucketStats>& BucketAggregator::buckets() const {
+    return stats;
+}
+
+BucketSize BucketAggregator::size() const {
+    return bucketSize;
+}
+
+std::vector<BucketStats> aggregateBuckets(const std::vector<long long>& timestamps, const std::vector<double>& values, BucketSize size) {
+    if (timestamps.size() != values.size()) {
+        throw std::runtime_error("Timestamp and value columns differ in length.");
+    }
+    BucketAggregator aggregator(size);
+    if (!values.empty()) {
+        aggregator.addRange(timestamps.data(), values.data(), values.size());
+    }
+    return std::vector<BucketStats>(aggregator.buckets().begin(), aggregator.buckets().end());
+}
+
+std::vector<Candlestick> bucketsToCandlesticks(const std::vector<BucketStats>& buckets, BucketSize size) {
+    return bucketsToSeries(buckets.data(), buckets.size(), size).toCandlesticks();
+}
+
+std::vector<Candlestick> aggregateCandlesticks(const WeatherData& weatherData, const std::string& column, BucketSize size) {
+    return aggregateSeries(weatherData, column, size).toCandlesticks();
+}
+
+std::vector<double> alignedBucketMeans(const WeatherData& weatherData, const std::string& column, BucketSize size,
+                                       const std::vector<Candlestick>& candlesticks) {
+    const std::vector<double>* values = weatherData.column(column);
+    if (!values) {
+        throw std::runtime_error("Column not found: " + column);
+    }
+    std::vector<BucketStats> buckets = aggregateBuckets(weatherData.timestamps(), *values, size);
+
+    std::vector<double> means;
+    means.reserve(candlesticks.size());
+    for (const auto& candle : candlesticks) {
+        long long start;
+        const char* label = candle.date.c_str();
+        double mean = std::numeric_limits<double>::quiet_NaN();
+        if (parseTimestamp(label, label + candle.date.size(), start)) {
+            start = bucketStart(start, size);
+            auto it = std::lower_bound(buckets.begin(), buckets.end(), start,
+                                       [](const BucketStats& b, long long s) { return b.start < s; });
+            if (it != buckets.end() && it->start == start) {
+                mean = it->mean;
+            }
+        }
+        means.push_back(mean);
+    }
+    return means;
+}
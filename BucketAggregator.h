@@ -0,0 +1,83 @@
+// BucketAggregator.h
+#pragma once
+#include "Candlestick.h"
+#include "WeatherData.h"
+#include "Arena.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// Granularity of the time buckets candlesticks are aggregated into.
+enum class BucketSize { Hour, Day, Week, Month, Year };
+
+// Start (UTC epoch seconds) of the bucket containing a timestamp. Weeks start on Monday.
+long long bucketStart(long long seconds, BucketSize size);
+
+// Start of the bucket that follows the bucket starting at `start`.
+long long nextBucketStart(long long start, BucketSize size);
+
+// Display label of a bucket: "1980", "1980-01", "1980-01-07" (day and week) or "1980-01-01T05".
+std::string bucketLabel(long long start, BucketSize size);
+
+// Lower-case name of a bucket size ("hour", "day", "week", "month", "year").
+const char* bucketSizeName(BucketSize size);
+
+// Parses a bucket size name, returning false if it is not recognised.
+bool parseBucketSize(const std::string& name, BucketSize& size);
+
+// Statistics of the readings that fell into one bucket.
+struct BucketStats {
+    long long start;     // Bucket start (UTC epoch seconds)
+    double open;         // Earliest reading
+    double high;         // Highest reading
+    double low;          // Lowest reading
+    double close;        // Latest reading
+    size_t count;        // Number of readings
+    double mean;         // Running mean (Welford)
+    double m2;           // Sum of squared deviations from the mean (Welford)
+    long long openTime;  // Timestamp of the earliest reading
+    long long closeTime; // Timestamp of the latest reading
+
+    // Population variance of the readings.
+    double variance() const;
+};
+
+// Folds the statistics of `from` into `into` for the same bucket (Chan et al.'s pairwise mean/M2 update).
+void mergeBucketStats(BucketStats& into, const BucketStats& from);
+
+// BucketAggregator class that reduces a stream of (timestamp, value) readings into per-bucket
+// statistics in a single pass, keeping only one BucketStats per bucket.
+class BucketAggregator {
+public:
+    // Constructor for an aggregator whose bucket list lives in `arena` (on the heap when null).
+    explicit BucketAggregator(BucketSize size, Arena* arena = nullptr);
+    // Adds one reading; NaN readings are ignored. Readings may arrive out of order.
+    void add(long long timestamp, double value);
+    // Adds a block of readings; time-ordered runs within one bucket are reduced with the vector kernels.
+    void addRange(const long long* timestamps, const double* values, size_t count);
+    // Buckets seen so far, ordered by start time.
+    const ArenaVector<BucketStats>& buckets() const;
+    BucketSize size() const;
+private:
+    // Bucket starting at `start`, created (seeded with the given reading) if it does not exist yet.
+    BucketStats& bucketFor(long long start, long long timestamp, double value);
+
+    BucketSize bucketSize;
+    ArenaVector<BucketStats> stats;
+};
+
+// Aggregates a timestamp column and a value column of equal length.
+std::vector<BucketStats> aggregateBuckets(const std::vector<long long>& timestamps, const std::vector<double>& values, BucketSize size);
+
+// Converts bucket statistics into candlesticks following computeCandlesticks: open is the previous
+// bucket's mean (0 for the first), close is the bucket mean, and empty buckets in between repeat
+// the previous close.
+std::vector<Candlestick> bucketsToCandlesticks(const std::vector<BucketStats>& buckets, BucketSize size);
+
+// Aggregates one loaded column of the dataset straight into candlesticks.
+std::vector<Candlestick> aggregateCandlesticks(const WeatherData& weatherData, const std::string& column, BucketSize size);
+
+// Mean of another column over the bucket of each candlestick (NaN where that column has no readings),
+// so predicates on the column can be applied to candles aggregated from a different one.
+std::vector<double> alignedBucketMeans(const WeatherData& weatherData, const std::string& column, BucketSize size,
+                                       const std::vector<Candlestick>& candlesticks);
@@ -0,0 +1,24 @@
+// CSVReader.cpp
+#include "CSVReader.h"
+#include "CountryColumns.h"
+#include "Profiler.h"
+#include "WeatherData.h"
+#include <iostream>
+#include <map>
+
+/*Reads temperature data for the specified column (country) from a CSV file, filename Name of the CSV file, 
+column Name of the temperature column (e.g., "GB_temperature") and Vector of pairs (year, temperature)
+Goes through the same mapped, chunk-parallel loader as WeatherData, so both readers parse every field
+identically and share the snapshot (see CSVReader.h); missing values are skipped.
+*/ 
+ArenaVector<std::pair<std::string, double>> CSVReader::readCSV(const std::string& filename, const std::string& column, Arena* arena) {
+    PROFILE_SCOPE("csv read");
+    std::map<int, std::string> projection;
+    projection[1] = column;
+    const WeatherData weatherData(filename, getColumnNames(filename), projection);
+    ArenaVector<std::pair<std::string, double>> data = weatherData.yearlySeries(column, arena);
+
+    // Debug output
+    std::cerr << "Debug: Extracted " << data.size() << " rows of data from CSV.\n";
+    return data;
+}
@@ -0,0 +1,17 @@
+// CSVReader.h
+#pragma once
+#include "Arena.h"
+#include <vector>
+#include <string>
+#include <utility>
+
+// CSVReader class to read temperature data from CSV files
+class CSVReader {
+public:
+    // Loads the column through WeatherData, so like every load it reuses "<filename>.snapshot" when current
+    // and otherwise writes (or adds the column to) that snapshot next to the CSV; a failed write is only
+    // warned about. The pairs are allocated in arena when one is given. Throws if the file cannot be opened
+    // or has no such column.
+    static ArenaVector<std::pair<std::string, double>> readCSV(const std::string& filename, const std::string& column,
+                                                               Arena* arena = nullptr);
+};
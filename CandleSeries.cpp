@@ -0,0 +1,200 @@
+// CandleSeries.cpp
+#include "CandleSeries.h"
+#include "FastParse.h"
+#include "Timestamp.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+CandleSeries::CandleSeries(BucketSize size, Arena* arena)
+    : granularity(size), startColumn(ArenaAllocator<long long>(arena)), openColumn(ArenaAllocator<double>(arena)),
+      highColumn(ArenaAllocator<double>(arena)), lowColumn(ArenaAllocator<double>(arena)), closeColumn(ArenaAllocator<double>(arena)) {}
+
+CandleSeries CandleSeries::fromCandlesticks(const std::vector<Candlestick>& candlesticks, BucketSize size) {
+    CandleSeries series(size);
+    series.reserve(candlesticks.size());
+    for (const auto& candle : candlesticks) {
+        CompactCandle compact;
+        const char* label = candle.date.c_str();
+        if (!parseTimestamp(label, label + candle.date.size(), compact.start)) {
+            throw std::runtime_error("Invalid date in candlestick: " + candle.date);
+        }
+        compact.open = candle.open;
+        compact.high = candle.high;
+        compact.low = candle.low;
+        compact.close = candle.close;
+        series.push_back(compact);
+    }
+    return series;
+}
+
+void CandleSeries::reserve(size_t count) {
+    startColumn.reserve(count);
+    openColumn.reserve(count);
+    highColumn.reserve(count);
+    lowColumn.reserve(count);
+    closeColumn.reserve(count);
+}
+
+void CandleSeries::push_back(const CompactCandle& candle) {
+    startColumn.push_back(candle.start);
+    openColumn.push_back(candle.open);
+    highColumn.push_back(candle.high);
+    lowColumn.push_back(candle.low);
+    closeColumn.push_back(candle.close);
+}
+
+size_t CandleSeries::size() const {
+    return startColumn.size();
+}
+
+bool CandleSeries::empty() const {
+    return startColumn.empty();
+}
+
+BucketSize CandleSeries::bucketSize() const {
+    return granularity;
+}
+
+Arena* CandleSeries::arena() const {
+    return startColumn.get_allocator().arena;
+}
+
+CompactCandle CandleSeries::operator[](size_t i) const {
+    CompactCandle candle = {startColumn[i], openColumn[i], highColumn[i], lowColumn[i], closeColumn[i]};
+    return candle;
+}
+
+const ArenaVector<long long>& CandleSeries::starts() const {
+    return startColumn;
+}
+
+const ArenaVector<double>& CandleSeries::opens() const {
+    return openColumn;
+}
+
+const ArenaVector<double>& CandleSeries::highs() const {
+    return highColumn;
+}
+
+const ArenaVector<double>& CandleSeries::lows() const {
+    return lowColumn;
+}
+
+const ArenaVector<double>& CandleSeries::closes() const {
+    return closeColumn;
+}
+
+std::pair<size_t, size_t> CandleSeries::timeRange(long long from, long long to) const {
+    auto first = std::lower_bound(startColumn.begin(), startColumn.end(), from);
+    auto last = std::lower_bound(first, startColumn.end(), to);
+    return std::make_pair(static_cast<size_t>(first - startColumn.begin()), static_cast<size_t>(last - startColumn.begin()));
+}
+
+std::pair<size_t, size_t> CandleSeries::yearRange(int startYear, int endYear) const {
+    if (startYear > endYear) {
+        return std::make_pair<size_t, size_t>(0, 0);
+    }
+    return timeRange(daysFromCivil(startYear, 1, 1) * 86400, daysFromCivil(static_cast<long long>(endYear) + 1, 1, 1) * 86400);
+}
+
+CandleSeries CandleSeries::select(const ArenaVector<size_t>& indices) const {
+    CandleSeries selected(granularity, arena());
+    selected.reserve(indices.size());
+    for (size_t i : indices) {
+        selected.push_back((*this)[i]);
+    }
+    return selected;
+}
+
+CandleSeries CandleSeries::slice(size_t first, size_t last) const {
+    CandleSeries sliced(granularity, arena());
+    last = std::min(last, size());
+    if (first < last) {
+        sliced.startColumn.assign(startColumn.begin() + first, startColumn.begin() + last);
+        sliced.openColumn.assign(openColumn.begin() + first, openColumn.begin() + last);
+        sliced.highColumn.assign(highColumn.begin() + first, highColumn.begin() + last);
+        sliced.lowColumn.assign(lowColumn.begin() + first, lowColumn.begin() + last);
+        sliced.closeColumn.assign(closeColumn.begin() + first, closeColumn.begin() + last);
+    }
+    return sliced;
+}
+
+Candlestick CandleSeries::candlestick(size_t i) const {
+    return Candlestick(bucketLabel(startColumn[i], granularity), openColumn[i], closeColumn[i], highColumn[i], lowColumn[i]);
+}
+
+std::vector<Candlestick> CandleSeries::toCandlesticks() const {
+    std::vector<Candlestick> candlesticks;
+    candlesticks.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        candlesticks.push_back(candlestick(i));
+    }
+    return candlesticks;
+}
+
+// Follows computeCandlesticks: open is the previous bucket's mean (0 for the first), close is the bucket
+// mean, and empty buckets in between repeat the previous close.
+
+CandleSeries bucketsToSeries(const BucketStats* buckets, size_t count, BucketSize size, Arena* arena) {
+    CandleSeries series(size, arena);
+    series.reserve(count);
+    double prevClose = 0.0;
+
+    for (size_t i = 0; i < count; ++i) {
+        // Fill gaps since the previous bucket with flat candles, as computeCandlesticks does for missing years
+        if (i > 0) {
+            for (long long start = nextBucketStart(buckets[i - 1].start, size); start < buckets[i].start; start = nextBucketStart(start, size)) {
+                CompactCandle flat = {start, prevClose, prevClose, prevClose, prevClose};
+                series.push_back(flat);
+            }
+        }
+        const BucketStats& bucket = buckets[i];
+        CompactCandle candle = {bucket.start, prevClose, bucket.high, bucket.low, bucket.mean};
+        series.push_back(candle);
+        prevClose = bucket.mean;
+    }
+    return series;
+}
+
+CandleSeries aggregateSeries(const WeatherData& weatherData, const std::string& column, BucketSize size, Arena* arena) {
+    PROFILE_SCOPE("aggregate");
+    const std::vector<double>* values = weatherData.column(column);
+    if (!values) {
+        throw std::runtime_error("Column not found: " + column);
+    }
+    BucketAggregator aggregator(size, arena);
+    if (!values->empty()) {
+        aggregator.addRange(weatherData.timestamps().data(), values->data(), values->size());
+    }
+    const ArenaVector<BucketStats>& buckets = aggregator.buckets();
+    PROFILE_COUNT("candles produced", buckets.size());
+    return bucketsToSeries(buckets.data(), buckets.size(), size, arena);
+}
+
+std::vector<double> alignedBucketMeans(const WeatherData& weatherData, const std::string& column, const CandleSeries& candles) {
+    const std::vector<double>* values = weatherData.column(column);
+    if (!values) {
+        throw std::runtime_error("Column not found: " + column);
+    }
+    BucketAggregator aggregator(candles.bucketSize(), candles.arena());
+    if (!values->empty()) {
+        aggregator.addRange(weatherData.timestamps().data(), values->data(), values->size());
+    }
+    const ArenaVector<BucketStats>& buckets = aggregator.buckets();
+
+    // Both are sorted by bucket start, so one merge pass lines them up
+    std::vector<double> means(candles.size(), std::numeric_limits<double>::quiet_NaN());
+    const ArenaVector<long long>& starts = candles.starts();
+    size_t b = 0;
+    for (size_t i = 0; i < candles.size(); ++i) {
+        while (b < buckets.size() && buckets[b].start < starts[i]) {
+            ++b;
+        }
+        if (b < buckets.size() && buckets[b].start == starts[i]) {
+            means[i] = buckets[b].mean;
+        }
+    }
+    return means;
+}
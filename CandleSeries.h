@@ -0,0 +1,74 @@
+// CandleSeries.h
+#pragma once
+#include "Candlestick.h"
+#include "BucketAggregator.h"
+#include "WeatherData.h"
+#include "Arena.h"
+#include <vector>
+#include <string>
+#include <utility>
+#include <cstddef>
+
+// Candlestick keyed by the start of its bucket instead of a date string, so it is trivially copyable.
+struct CompactCandle {
+    long long start;   // Bucket start (UTC epoch seconds)
+    double open;
+    double high;
+    double low;
+    double close;
+};
+
+// CandleSeries class that stores candlesticks of one bucket size as parallel arrays, one per field.
+// Copies are plain memcpys, range queries binary-search integer keys, and date strings are only built
+// when converting to Candlestick for display. The columns live in an arena when one is given, and
+// series derived from this one (select, copies) share it.
+class CandleSeries {
+public:
+    explicit CandleSeries(BucketSize size, Arena* arena = nullptr);
+    // Converts display candlesticks, parsing each date once; throws if a date cannot be parsed.
+    static CandleSeries fromCandlesticks(const std::vector<Candlestick>& candlesticks, BucketSize size);
+
+    void reserve(size_t count);
+    void push_back(const CompactCandle& candle);
+    size_t size() const;
+    bool empty() const;
+    BucketSize bucketSize() const;
+    Arena* arena() const;
+    CompactCandle operator[](size_t i) const;
+
+    // Field columns, for scans that only need some of the fields.
+    const ArenaVector<long long>& starts() const;
+    const ArenaVector<double>& opens() const;
+    const ArenaVector<double>& highs() const;
+    const ArenaVector<double>& lows() const;
+    const ArenaVector<double>& closes() const;
+
+    // Index range [first, second) of the candles whose bucket starts in [from, to); the series must be sorted.
+    std::pair<size_t, size_t> timeRange(long long from, long long to) const;
+    // Same for buckets starting within the years [startYear, endYear].
+    std::pair<size_t, size_t> yearRange(int startYear, int endYear) const;
+    // The candles at the given indices, or in [first, last), as a new series.
+    CandleSeries select(const ArenaVector<size_t>& indices) const;
+    CandleSeries slice(size_t first, size_t last) const;
+
+    // Display form of one candle, or of the whole series.
+    Candlestick candlestick(size_t i) const;
+    std::vector<Candlestick> toCandlesticks() const;
+private:
+    BucketSize granularity;
+    ArenaVector<long long> startColumn;
+    ArenaVector<double> openColumn;
+    ArenaVector<double> highColumn;
+    ArenaVector<double> lowColumn;
+    ArenaVector<double> closeColumn;
+};
+
+// Converts bucket statistics into a series with the same values bucketsToCandlesticks produces.
+CandleSeries bucketsToSeries(const BucketStats* buckets, size_t count, BucketSize size, Arena* arena = nullptr);
+
+// Aggregates one loaded column of the dataset straight into a series, with every buffer in `arena` if given.
+CandleSeries aggregateSeries(const WeatherData& weatherData, const std::string& column, BucketSize size, Arena* arena = nullptr);
+
+// Mean of another loaded column over the bucket of each candle in the series (NaN where that column has no
+// readings), matched on integer bucket starts; pass it to CandlestickFilter::seriesRange.
+std::vector<double> alignedBucketMeans(const WeatherData& weatherData, const std::string& column, const CandleSeries& candles);
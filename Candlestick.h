@@ -0,0 +1,16 @@
+// Candlestick.h
+#pragma once
+#include <string>
+
+class Candlestick {
+public:
+    std::string date;  // Year (e.g., "1980")
+    double open;       // Opening average temperature
+    double close;      // Closing average temperature
+    double high;       // Highest temperature
+    double low;        // Lowest temperature
+
+    // Constructor
+    Candlestick(const std::string& d, double o, double c, double h, double l)
+        : date(d), open(o), close(c), high(h), low(l) {}
+};
@@ -0,0 +1,210 @@
+// CandlestickFilter.cpp
+#include "CandlestickFilter.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+std::vector<Candlestick> copySelected(const std::vector<Candlestick>& candlesticks, const std::vector<size_t>& selected) {
+    std::vector<Candlestick> filtered;
+    filtered.reserve(selected.size());
+    for (size_t i : selected) {
+        filtered.push_back(candlesticks[i]);
+    }
+    return filtered;
+}
+
+} // namespace
+
+CandlestickFilter::CandlestickFilter() : hasYearRange(false), startYear(0), endYear(0) {
+    for (int i = 0; i < 4; ++i) {
+        hasField[i] = false;
+        fieldMin[i] = 0.0;
+        fieldMax[i] = 0.0;
+    }
+}
+
+CandlestickFilter& CandlestickFilter::yearRange(int start, int end) {
+    if (hasYearRange) {
+        startYear = std::max(startYear, start);
+        endYear = std::min(endYear, end);
+    } else {
+        hasYearRange = true;
+        startYear = start;
+        endYear = end;
+    }
+    return *this;
+}
+
+CandlestickFilter& CandlestickFilter::fieldRange(CandleField field, double minValue, double maxValue) {
+    int f = static_cast<int>(field);
+    if (hasField[f]) {
+        fieldMin[f] = std::max(fieldMin[f], minValue);
+        fieldMax[f] = std::min(fieldMax[f], maxValue);
+    } else {
+        hasField[f] = true;
+        fieldMin[f] = minValue;
+        fieldMax[f] = maxValue;
+    }
+    return *this;
+}
+
+CandlestickFilter& CandlestickFilter::openRange(double minValue, double maxValue) {
+    return fieldRange(CandleField::Open, minValue, maxValue);
+}
+
+CandlestickFilter& CandlestickFilter::highRange(double minValue, double maxValue) {
+    return fieldRange(CandleField::High, minValue, maxValue);
+}
+
+CandlestickFilter& CandlestickFilter::lowRange(double minValue, double maxValue) {
+    return fieldRange(CandleField::Low, minValue, maxValue);
+}
+
+CandlestickFilter& CandlestickFilter::closeRange(double minValue, double maxValue) {
+    return fieldRange(CandleField::Close, minValue, maxValue);
+}
+
+CandlestickFilter& CandlestickFilter::seriesRange(const std::vector<double>& values, double minValue, double maxValue) {
+    SeriesPredicate predicate = {&values, minValue, maxValue};
+    series.push_back(predicate);
+    return *this;
+}
+
+bool CandlestickFilter::empty() const {
+    return !hasYearRange && !hasField[0] && !hasField[1] && !hasField[2] && !hasField[3] && series.empty();
+}
+
+void CandlestickFilter::checkSeries(size_t count) const {
+    for (const auto& predicate : series) {
+        if (predicate.values->size() != count) {
+            throw std::runtime_error("Filter series does not have one value per candlestick.");
+        }
+    }
+}
+
+template <typename Keep>
+void CandlestickFilter::scan(const std::vector<Candlestick>& candlesticks, size_t begin, size_t end, Keep keep) const {
+    PROFILE_SCOPE("filter");
+    PROFILE_COUNT("candles filtered", candlesticks.size());
+    checkSeries(candlesticks.size());
+
+    size_t kept = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const Candlestick& candle = candlesticks[i];
+        const double fields[4] = {candle.open, candle.high, candle.low, candle.close};
+        bool match = true;
+        for (int f = 0; f < 4 && match; ++f) {
+            match = !hasField[f] || (fields[f] >= fieldMin[f] && fields[f] <= fieldMax[f]);
+        }
+        for (size_t s = 0; s < series.size() && match; ++s) {
+            double value = (*series[s].values)[i];
+            match = value >= series[s].minValue && value <= series[s].maxValue;
+        }
+        if (match) {
+            keep(i);
+            ++kept;
+        }
+    }
+    PROFILE_COUNT("candles kept", kept);
+}
+
+std::pair<size_t, size_t> CandlestickFilter::scanRange(const std::vector<Candlestick>& candlesticks, const TimeIndex& index, size_t first) const {
+    size_t begin = std::min(first, candlesticks.size()), end = candlesticks.size();
+    if (hasYearRange) {
+        CandlestickRange range = index.yearRange(startYear, endYear);
+        size_t rangeBegin = range.empty() ? 0 : static_cast<size_t>(range.begin() - candlesticks.data());
+        end = rangeBegin + range.size();
+        begin = std::min(std::max(begin, rangeBegin), end);
+    }
+    return std::make_pair(begin, end);
+}
+
+std::vector<size_t> CandlestickFilter::select(const std::vector<Candlestick>& candlesticks, const TimeIndex& index, size_t first) const {
+    std::pair<size_t, size_t> range = scanRange(candlesticks, index, first);
+    std::vector<size_t> selected;
+    scan(candlesticks, range.first, range.second, [&selected](size_t i) { selected.push_back(i); });
+    return selected;
+}
+
+std::vector<size_t> CandlestickFilter::select(const std::vector<Candlestick>& candlesticks) const {
+    if (!hasYearRange) {
+        std::vector<size_t> selected;
+        scan(candlesticks, 0, candlesticks.size(), [&selected](size_t i) { selected.push_back(i); });
+        return selected;
+    }
+    TimeIndex index(candlesticks);
+    return select(candlesticks, index);
+}
+
+std::vector<unsigned char> CandlestickFilter::mask(const std::vector<Candlestick>& candlesticks, const TimeIndex& index) const {
+    std::pair<size_t, size_t> range = scanRange(candlesticks, index, 0);
+    std::vector<unsigned char> bits(candlesticks.size(), 0);
+    scan(candlesticks, range.first, range.second, [&bits](size_t i) { bits[i] = 1; });
+    return bits;
+}
+
+std::vector<unsigned char> CandlestickFilter::mask(const std::vector<Candlestick>& candlesticks) const {
+    if (!hasYearRange) {
+        std::vector<unsigned char> bits(candlesticks.size(), 0);
+        scan(candlesticks, 0, candlesticks.size(), [&bits](size_t i) { bits[i] = 1; });
+        return bits;
+    }
+    TimeIndex index(candlesticks);
+    return mask(candlesticks, index);
+}
+
+std::vector<Candlestick> CandlestickFilter::apply(const std::vector<Candlestick>& candlesticks, const TimeIndex& index, size_t first) const {
+    return copySelected(candlesticks, select(candlesticks, index, first));
+}
+
+std::vector<Candlestick> CandlestickFilter::apply(const std::vector<Candlestick>& candlesticks) const {
+    return copySelected(candlesticks, select(candlesticks));
+}
+
+ArenaVector<Candlestick> CandlestickFilter::apply(const std::vector<Candlestick>& candlesticks, const TimeIndex& index, Arena& arena) const {
+    std::pair<size_t, size_t> range = scanRange(candlesticks, index, 0);
+    ArenaVector<Candlestick> filtered{ArenaAllocator<Candlestick>(&arena)};
+    filtered.reserve(range.second - range.first);
+    scan(candlesticks, range.first, range.second, [&](size_t i) { filtered.push_back(candlesticks[i]); });
+    return filtered;
+}
+
+// Reads only the field columns that carry a predicate.
+
+void CandlestickFilter::scan(const CandleSeries& candles, size_t begin, size_t end, ArenaVector<size_t>& out) const {
+    PROFILE_SCOPE("filter");
+    PROFILE_COUNT("candles filtered", candles.size());
+    checkSeries(candles.size());
+    const ArenaVector<double>* columns[4] = {&candles.opens(), &candles.highs(), &candles.lows(), &candles.closes()};
+
+    for (size_t i = begin; i < end; ++i) {
+        bool keep = true;
+        for (int f = 0; f < 4 && keep; ++f) {
+            keep = !hasField[f] || ((*columns[f])[i] >= fieldMin[f] && (*columns[f])[i] <= fieldMax[f]);
+        }
+        for (size_t s = 0; s < series.size() && keep; ++s) {
+            double value = (*series[s].values)[i];
+            keep = value >= series[s].minValue && value <= series[s].maxValue;
+        }
+        if (keep) {
+            out.push_back(i);
+        }
+    }
+    PROFILE_COUNT("candles kept", out.size());
+}
+
+ArenaVector<size_t> CandlestickFilter::select(const CandleSeries& candles) const {
+    std::pair<size_t, size_t> range(0, candles.size());
+    if (hasYearRange) {
+        range = candles.yearRange(startYear, endYear);
+    }
+    ArenaVector<size_t> selected{ArenaAllocator<size_t>(candles.arena())};
+    scan(candles, range.first, range.second, selected);
+    return selected;
+}
+
+CandleSeries CandlestickFilter::apply(const CandleSeries& candles) const {
+    return candles.select(select(candles));
+}
@@ -0,0 +1,78 @@
+// CandlestickFilter.h
+#pragma once
+#include "Candlestick.h"
+#include "TimeIndex.h"
+#include "CandleSeries.h"
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+// Candlestick field a value predicate tests.
+enum class CandleField { Open, High, Low, Close };
+
+// CandlestickFilter class that collects predicates without evaluating them, then applies all of them
+// in one fused pass that produces an index list or bitmask instead of intermediate copies.
+// Predicates combine with AND; repeated ranges on the same field intersect.
+class CandlestickFilter {
+public:
+    CandlestickFilter();
+
+    // Keeps candlesticks whose period starts within the years [startYear, endYear].
+    CandlestickFilter& yearRange(int startYear, int endYear);
+    // Keeps candlesticks whose field lies within [minValue, maxValue].
+    CandlestickFilter& fieldRange(CandleField field, double minValue, double maxValue);
+    CandlestickFilter& openRange(double minValue, double maxValue);
+    CandlestickFilter& highRange(double minValue, double maxValue);
+    CandlestickFilter& lowRange(double minValue, double maxValue);
+    CandlestickFilter& closeRange(double minValue, double maxValue);
+    // Keeps candlesticks whose value in another per-candle series (e.g. the same buckets aggregated from
+    // a radiation column) lies within [minValue, maxValue]. The series must outlive the filter and have
+    // one value per candlestick.
+    CandlestickFilter& seriesRange(const std::vector<double>& values, double minValue, double maxValue);
+
+    // True when no predicate has been added.
+    bool empty() const;
+
+    // Indices of the matching candlesticks from position `first` on, in order. The year range is resolved by
+    // binary search on the index, which must cover the same vector; a non-zero `first` filters only the
+    // candlesticks appended since then.
+    std::vector<size_t> select(const std::vector<Candlestick>& candlesticks, const TimeIndex& index, size_t first = 0) const;
+    // Same, building a throwaway index when a year range is present. Callers that filter the same
+    // candlesticks more than once keep a TimeIndex next to them and use the overload above.
+    std::vector<size_t> select(const std::vector<Candlestick>& candlesticks) const;
+    // One byte per candlestick, non-zero where it matches, filled during the scan.
+    std::vector<unsigned char> mask(const std::vector<Candlestick>& candlesticks, const TimeIndex& index) const;
+    std::vector<unsigned char> mask(const std::vector<Candlestick>& candlesticks) const;
+    // Copies of the matching candlesticks, for display.
+    std::vector<Candlestick> apply(const std::vector<Candlestick>& candlesticks, const TimeIndex& index, size_t first = 0) const;
+    std::vector<Candlestick> apply(const std::vector<Candlestick>& candlesticks) const;
+    // Copies the matches into arena during the scan, for results that live until the arena is reset.
+    ArenaVector<Candlestick> apply(const std::vector<Candlestick>& candlesticks, const TimeIndex& index, Arena& arena) const;
+    // Same over a compact series, where the year range is a binary search on integer bucket starts.
+    // The index list and the filtered series are allocated in the series' arena.
+    ArenaVector<size_t> select(const CandleSeries& series) const;
+    CandleSeries apply(const CandleSeries& series) const;
+private:
+    struct SeriesPredicate {
+        const std::vector<double>* values;
+        double minValue;
+        double maxValue;
+    };
+
+    // Scans [begin, end) once, testing every predicate per candlestick and passing each match's position to `keep`.
+    template <typename Keep>
+    void scan(const std::vector<Candlestick>& candlesticks, size_t begin, size_t end, Keep keep) const;
+    // Positions from `first` on that the year range leaves to scan.
+    std::pair<size_t, size_t> scanRange(const std::vector<Candlestick>& candlesticks, const TimeIndex& index, size_t first) const;
+    void scan(const CandleSeries& candles, size_t begin, size_t end, ArenaVector<size_t>& out) const;
+    // Throws unless every series predicate has one value per candlestick.
+    void checkSeries(size_t count) const;
+
+    bool hasYearRange;
+    int startYear;
+    int endYear;
+    bool hasField[4];
+    double fieldMin[4];
+    double fieldMax[4];
+    std::vector<SeriesPredicate> series;
+};
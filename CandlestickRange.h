@@ -0,0 +1,30 @@
+// CandlestickRange.h
+#pragma once
+#include "Candlestick.h"
+#include "Arena.h"
+#include <vector>
+#include <cstddef>
+
+// Non-owning view over a contiguous run of candlesticks; valid while the underlying vector is unchanged.
+// Converts from either vector type, so functions taking a range accept heap- and arena-backed results alike.
+class CandlestickRange {
+public:
+    CandlestickRange() : first(nullptr), last(nullptr) {}
+    CandlestickRange(const Candlestick* begin, const Candlestick* end) : first(begin), last(end) {}
+    CandlestickRange(const std::vector<Candlestick>& candlesticks)
+        : first(candlesticks.data()), last(candlesticks.data() + candlesticks.size()) {}
+    CandlestickRange(const ArenaVector<Candlestick>& candlesticks)
+        : first(candlesticks.data()), last(candlesticks.data() + candlesticks.size()) {}
+
+    const Candlestick* begin() const { return first; }
+    const Candlestick* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+    const Candlestick& operator[](size_t i) const { return first[i]; }
+
+    // Copies the viewed candlesticks, for callers that need to own them.
+    std::vector<Candlestick> toVector() const { return std::vector<Candlestick>(first, last); }
+private:
+    const Candlestick* first;
+    const Candlestick* last;
+};
@@ -0,0 +1,85 @@
+// CandlestickStream.cpp
+#include "CandlestickStream.h"
+#include <stdexcept>
+
+CandlestickStream::CandlestickStream(const WeatherData& weatherData, const std::string& column, BucketSize size)
+    : weatherData(weatherData), columnName(column), bucketSize(size), consumedRows(0), haveOpen(false),
+      previousClose(0.0), late(0) {
+    if (!weatherData.column(column)) {
+        throw std::runtime_error("Column not found: " + column);
+    }
+}
+
+// Reduces the new rows with the same BucketAggregator the batch path uses, then merges its first bucket
+// into the open one and seals every bucket but the last.
+
+size_t CandlestickStream::update() {
+    const size_t committed = weatherData.committedRowCount();
+    if (committed <= consumedRows) {
+        return 0;
+    }
+    const std::vector<long long>& timestamps = weatherData.timestamps();
+    const std::vector<double>& values = *weatherData.column(columnName);
+
+    BucketAggregator aggregator(bucketSize);
+    aggregator.addRange(timestamps.data() + consumedRows, values.data() + consumedRows, committed - consumedRows);
+    consumedRows = committed;
+
+    const size_t sealedBefore = sealedCandles.size();
+    for (const BucketStats& bucket : aggregator.buckets()) {
+        if (haveOpen && bucket.start < openBucket.start) {
+            late += bucket.count;
+            continue;
+        }
+        if (haveOpen && bucket.start == openBucket.start) {
+            mergeBucketStats(openBucket, bucket);
+            continue;
+        }
+        if (haveOpen) {
+            seal(bucket.start);
+        }
+        openBucket = bucket;
+        haveOpen = true;
+    }
+    return sealedCandles.size() - sealedBefore;
+}
+
+void CandlestickStream::seal(long long nextStart) {
+    sealedCandles.emplace_back(bucketLabel(openBucket.start, bucketSize), previousClose, openBucket.mean, openBucket.high, openBucket.low);
+    previousClose = openBucket.mean;
+    // Fill gaps with flat candles, as bucketsToCandlesticks does
+    for (long long start = nextBucketStart(openBucket.start, bucketSize); start < nextStart; start = nextBucketStart(start, bucketSize)) {
+        sealedCandles.emplace_back(bucketLabel(start, bucketSize), previousClose, previousClose, previousClose, previousClose);
+    }
+}
+
+const std::vector<Candlestick>& CandlestickStream::sealed() const {
+    return sealedCandles;
+}
+
+bool CandlestickStream::hasOpenBucket() const {
+    return haveOpen;
+}
+
+Candlestick CandlestickStream::openCandlestick() const {
+    if (!haveOpen) {
+        throw std::runtime_error("No open bucket for " + columnName);
+    }
+    return Candlestick(bucketLabel(openBucket.start, bucketSize), previousClose, openBucket.mean, openBucket.high, openBucket.low);
+}
+
+std::vector<Candlestick> CandlestickStream::candlesticks() const {
+    std::vector<Candlestick> all(sealedCandles);
+    if (haveOpen) {
+        all.push_back(openCandlestick());
+    }
+    return all;
+}
+
+size_t CandlestickStream::lateReadings() const {
+    return late;
+}
+
+BucketSize CandlestickStream::size() const {
+    return bucketSize;
+}
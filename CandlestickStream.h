@@ -0,0 +1,43 @@
+// CandlestickStream.h
+#pragma once
+#include "Candlestick.h"
+#include "BucketAggregator.h"
+#include "WeatherData.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// CandlestickStream class that keeps one column's candlesticks current while rows are appended to the
+// dataset. Finished buckets are sealed into candlesticks once; only the newest (open) bucket keeps running
+// statistics, so each update costs O(new rows) however long the history is.
+class CandlestickStream {
+public:
+    // Constructor for a stream over a loaded column; call update() to fold in the rows loaded so far.
+    CandlestickStream(const WeatherData& weatherData, const std::string& column, BucketSize size);
+    // Folds the committed rows added since the last update and returns how many candlesticks were sealed.
+    // Readings older than the open bucket can no longer be placed and are counted as late instead.
+    size_t update();
+    // Finished candlesticks in time order, including flat candles for empty buckets. Sealed candles never change.
+    const std::vector<Candlestick>& sealed() const;
+    // Whether the newest bucket has readings, and its candlestick so far.
+    bool hasOpenBucket() const;
+    Candlestick openCandlestick() const;
+    // Sealed candlesticks followed by the open one, the same as aggregateCandlesticks over the same rows.
+    std::vector<Candlestick> candlesticks() const;
+    // Readings skipped because they arrived after their bucket was sealed.
+    size_t lateReadings() const;
+    BucketSize size() const;
+private:
+    // Seals the open bucket and the empty buckets up to `nextStart`.
+    void seal(long long nextStart);
+
+    const WeatherData& weatherData;
+    std::string columnName;
+    BucketSize bucketSize;
+    size_t consumedRows;
+    bool haveOpen;
+    BucketStats openBucket;
+    double previousClose;    // Close of the last sealed bucket with readings, the open of the next
+    size_t late;
+    std::vector<Candlestick> sealedCandles;
+};
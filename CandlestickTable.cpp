@@ -0,0 +1,87 @@
+// CandlestickTable.cpp
+#include "CandlestickTable.h"
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <string>
+
+namespace {
+
+// Formats a number for CSV/JSON output; NaN becomes the given placeholder.
+std::string formatNumber(double value, const char* missing) {
+    if (std::isnan(value) || std::isinf(value)) {
+        return missing;
+    }
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.6f", value);
+    return buffer;
+}
+
+} // namespace
+
+void displayCandlesticksAsTable(CandlestickRange candlesticks, std::ostream& out) {
+    // Print header
+    out << std::setw(15) << "Year"
+        << std::setw(10) << "Open"
+        << std::setw(10) << "High"
+        << std::setw(10) << "Low"
+        << std::setw(10) << "Close" << std::endl;
+
+    // Print separator line
+    out << std::string(55, '-') << std::endl;
+
+    // Print each candlestick row
+    for (const auto& candle : candlesticks) {
+        out << std::setw(15) << candle.date
+            << std::setw(10) << std::fixed << std::setprecision(3) << candle.open
+            << std::setw(10) << candle.high
+            << std::setw(10) << candle.low
+            << std::setw(10) << candle.close << std::endl;
+    }
+}
+
+void writeCandlesticksAsCsv(CandlestickRange candlesticks, std::ostream& out, bool header) {
+    if (header) {
+        out << "date,open,high,low,close\n";
+    }
+    for (const auto& candle : candlesticks) {
+        out << candle.date << ',' << formatNumber(candle.open, "") << ',' << formatNumber(candle.high, "") << ','
+            << formatNumber(candle.low, "") << ',' << formatNumber(candle.close, "") << '\n';
+    }
+}
+
+void writeJsonString(const std::string& text, std::ostream& out) {
+    out << '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out << escaped;
+                } else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+}
+
+void writeCandlesticksAsJson(CandlestickRange candlesticks, std::ostream& out) {
+    out << '[';
+    for (size_t i = 0; i < candlesticks.size(); ++i) {
+        const Candlestick& candle = candlesticks[i];
+        out << (i ? ",{\"date\":" : "{\"date\":");
+        writeJsonString(candle.date, out);
+        out << ",\"open\":" << formatNumber(candle.open, "null")
+            << ",\"high\":" << formatNumber(candle.high, "null")
+            << ",\"low\":" << formatNumber(candle.low, "null")
+            << ",\"close\":" << formatNumber(candle.close, "null") << '}';
+    }
+    out << ']';
+}
@@ -0,0 +1,18 @@
+// CandlestickTable.h
+#pragma once
+#include "Candlestick.h"
+#include "CandlestickRange.h"
+#include <vector>
+#include <iostream>
+
+// Displays candlestick data in a tabular format.
+void displayCandlesticksAsTable(CandlestickRange candlesticks, std::ostream& out = std::cout);
+
+// Writes candlesticks as CSV, after a "date,open,high,low,close" header unless `header` is false.
+void writeCandlesticksAsCsv(CandlestickRange candlesticks, std::ostream& out, bool header = true);
+
+// Writes candlesticks as a JSON array of {"date", "open", "high", "low", "close"} objects on one line.
+void writeCandlesticksAsJson(CandlestickRange candlesticks, std::ostream& out);
+
+// Writes a string as a quoted JSON string literal.
+void writeJsonString(const std::string& text, std::ostream& out);
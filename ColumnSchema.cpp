@@ -0,0 +1,233 @@
+// ColumnSchema.cpp
+#include "ColumnSchema.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+const int maxDecimals = 6;
+const double powersOfTen[maxDecimals + 1] = {1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 1000000.0};
+const int16_t missing16 = std::numeric_limits<int16_t>::min();
+const int32_t missing32 = std::numeric_limits<int32_t>::min();
+
+// Largest |round(value * scale)| over the column, or a negative number if some value does not survive
+// the round trip through an integer of at most 31 bits (less the two reserved codes).
+double scaledMagnitude(const std::vector<double>& values, double scale) {
+    double largest = 0.0;
+    for (double value : values) {
+        if (std::isnan(value)) {
+            continue;
+        }
+        double scaled = std::nearbyint(value * scale);
+        if (!(std::fabs(scaled) <= 2147483646.0) || scaled / scale != value) {
+            return -1.0;
+        }
+        largest = std::max(largest, std::fabs(scaled));
+    }
+    return largest;
+}
+
+// The two most negative codes stand for NaN and for -0.0 (which the CSV does contain as "-0.000").
+template <typename T>
+void appendScaled(const std::vector<double>& values, double scale, T missing, std::vector<char>& out) {
+    const T negativeZero = missing + 1;
+    size_t start = out.size();
+    out.resize(start + values.size() * sizeof(T));
+    char* p = &out[start];
+    for (double value : values) {
+        T raw = std::isnan(value) ? missing
+              : value == 0.0 && std::signbit(value) ? negativeZero
+              : static_cast<T>(std::nearbyint(value * scale));
+        std::memcpy(p, &raw, sizeof(T));
+        p += sizeof(T);
+    }
+}
+
+template <typename T>
+void readScaled(const char* data, size_t count, double scale, T missing, std::vector<double>& values) {
+    const T negativeZero = missing + 1;
+    values.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        T raw;
+        std::memcpy(&raw, data + i * sizeof(T), sizeof(T));
+        values[i] = raw == missing ? std::numeric_limits<double>::quiet_NaN() : raw == negativeZero ? -0.0 : raw / scale;
+    }
+}
+
+} // namespace
+
+ColumnSchema::ColumnSchema(const std::vector<std::string>& columnNames) {
+    for (size_t i = 1; i < columnNames.size(); ++i) {
+        const std::string& name = columnNames[i];
+        size_t split = name.find('_');
+        if (split == std::string::npos || split == 0 || split + 1 == name.size()) {
+            continue;
+        }
+        ColumnSpec spec;
+        spec.name = name;
+        spec.country = name.substr(0, split);
+        spec.variable = name.substr(split + 1);
+        spec.position = i;
+        if (std::find(countryCodes.begin(), countryCodes.end(), spec.country) == countryCodes.end()) {
+            countryCodes.push_back(spec.country);
+        }
+        if (std::find(variableNames.begin(), variableNames.end(), spec.variable) == variableNames.end()) {
+            variableNames.push_back(spec.variable);
+        }
+        specs.push_back(spec);
+    }
+}
+
+const std::vector<ColumnSpec>& ColumnSchema::columns() const {
+    return specs;
+}
+
+const std::vector<std::string>& ColumnSchema::countries() const {
+    return countryCodes;
+}
+
+const std::vector<std::string>& ColumnSchema::variables() const {
+    return variableNames;
+}
+
+bool ColumnSchema::hasVariable(const std::string& variable) const {
+    return std::find(variableNames.begin(), variableNames.end(), variable) != variableNames.end();
+}
+
+const ColumnSpec* ColumnSchema::find(const std::string& country, const std::string& variable) const {
+    for (const auto& spec : specs) {
+        if (spec.country == country && spec.variable == variable) {
+            return &spec;
+        }
+    }
+    return nullptr;
+}
+
+std::map<int, std::string> ColumnSchema::menu(const std::string& variable) const {
+    std::map<int, std::string> columnMenu;
+    int index = 1;
+    for (const auto& spec : specs) {
+        if (spec.variable == variable) {
+            columnMenu[index++] = spec.name;
+        }
+    }
+    if (columnMenu.empty()) {
+        throw std::runtime_error("No country " + variable + " columns found in the CSV file.");
+    }
+    return columnMenu;
+}
+
+std::string formatVariableName(const std::string& variable) {
+    std::string name = variable;
+    bool wordStart = true;
+    for (auto& c : name) {
+        if (c == '_') {
+            c = ' ';
+            wordStart = true;
+        } else {
+            if (wordStart) {
+                c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            }
+            wordStart = false;
+        }
+    }
+    return name;
+}
+
+std::string storageTypeName(const ColumnStorage& storage) {
+    switch (storage.type) {
+        case StorageType::Float32: return "float32";
+        case StorageType::Int32: return "int32 x10^-" + std::to_string(storage.decimals);
+        case StorageType::Int16: return "int16 x10^-" + std::to_string(storage.decimals);
+        default: return "float64";
+    }
+}
+
+size_t storageWidth(StorageType type) {
+    switch (type) {
+        case StorageType::Float32: return 4;
+        case StorageType::Int32: return 4;
+        case StorageType::Int16: return 2;
+        default: return 8;
+    }
+}
+
+// Tries the fewest decimals first, so a column printed with one decimal becomes int16 x10^-1 even
+// though x10^-2 would also round-trip. Each failing scale usually stops at the first few values.
+
+ColumnStorage chooseColumnStorage(const std::vector<double>& values) {
+    ColumnStorage storage;
+    for (int decimals = 0; decimals <= maxDecimals; ++decimals) {
+        double largest = scaledMagnitude(values, powersOfTen[decimals]);
+        if (largest >= 0.0) {
+            storage.type = largest <= 32766.0 ? StorageType::Int16 : StorageType::Int32;
+            storage.decimals = decimals;
+            return storage;
+        }
+    }
+    for (double value : values) {
+        if (!std::isnan(value) && static_cast<double>(static_cast<float>(value)) != value) {
+            return storage; // Float64
+        }
+    }
+    storage.type = StorageType::Float32;
+    return storage;
+}
+
+void encodeColumn(const std::vector<double>& values, const ColumnStorage& storage, std::vector<char>& out) {
+    const double scale = powersOfTen[storage.decimals];
+    switch (storage.type) {
+        case StorageType::Int16:
+            appendScaled<int16_t>(values, scale, missing16, out);
+            break;
+        case StorageType::Int32:
+            appendScaled<int32_t>(values, scale, missing32, out);
+            break;
+        case StorageType::Float32: {
+            size_t start = out.size();
+            out.resize(start + values.size() * 4);
+            for (size_t i = 0; i < values.size(); ++i) {
+                float narrow = static_cast<float>(values[i]);
+                std::memcpy(&out[start + i * 4], &narrow, 4);
+            }
+            break;
+        }
+        default:
+            if (!values.empty()) {
+                const char* bytes = reinterpret_cast<const char*>(values.data());
+                out.insert(out.end(), bytes, bytes + values.size() * 8);
+            }
+            break;
+    }
+}
+
+void decodeColumn(const char* data, size_t count, const ColumnStorage& storage, std::vector<double>& values) {
+    if (storage.decimals < 0 || storage.decimals > maxDecimals) {
+        throw std::runtime_error("Invalid column scale: " + std::to_string(storage.decimals));
+    }
+    const double scale = powersOfTen[storage.decimals];
+    switch (storage.type) {
+        case StorageType::Int16:
+            readScaled<int16_t>(data, count, scale, missing16, values);
+            break;
+        case StorageType::Int32:
+            readScaled<int32_t>(data, count, scale, missing32, values);
+            break;
+        case StorageType::Float32:
+            values.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                float narrow;
+                std::memcpy(&narrow, data + i * 4, 4);
+                values[i] = narrow;
+            }
+            break;
+        default:
+            values.resize(count);
+            if (count) std::memcpy(&values[0], data, count * 8);
+            break;
+    }
+}
@@ -0,0 +1,68 @@
+// ColumnSchema.h
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <map>
+
+// One value column of the CSV, split into the country it belongs to and the variable it measures.
+struct ColumnSpec {
+    std::string name;        // e.g. "AT_radiation_direct_horizontal"
+    std::string country;     // e.g. "AT"
+    std::string variable;    // e.g. "radiation_direct_horizontal"
+    size_t position;         // Index in the CSV header
+};
+
+// Groups the header of a weather export by country and variable. Every column after the timestamp whose
+// name has the form COUNTRY_variable is a value column; anything else is ignored.
+class ColumnSchema {
+public:
+    explicit ColumnSchema(const std::vector<std::string>& columnNames);
+
+    // Value columns in header order.
+    const std::vector<ColumnSpec>& columns() const;
+    // Country codes and variables in order of first appearance.
+    const std::vector<std::string>& countries() const;
+    const std::vector<std::string>& variables() const;
+    bool hasVariable(const std::string& variable) const;
+    // Column holding a country's variable, or nullptr if the export has none.
+    const ColumnSpec* find(const std::string& country, const std::string& variable) const;
+    // Menu indices (from 1) mapped to the columns of one variable, in header order. Throws if there are none.
+    std::map<int, std::string> menu(const std::string& variable) const;
+
+private:
+    std::vector<ColumnSpec> specs;
+    std::vector<std::string> countryCodes;
+    std::vector<std::string> variableNames;
+};
+
+// Converts a variable into a display name, e.g. "radiation_direct_horizontal" -> "Radiation Direct Horizontal".
+std::string formatVariableName(const std::string& variable);
+
+// How a column is stored in the binary snapshot. The scaled integer types hold round(value * 10^decimals),
+// with the two most negative codes reserved for NaN and -0.0, so a reading printed with a few decimals
+// takes 2 or 4 bytes instead of 8 and still decodes to exactly the double the CSV parser produced.
+enum class StorageType : uint8_t { Float64, Float32, Int32, Int16 };
+
+struct ColumnStorage {
+    StorageType type;
+    int decimals;            // Scale exponent of the integer types, 0 otherwise
+
+    ColumnStorage() : type(StorageType::Float64), decimals(0) {}
+};
+
+// Name used in debug output, e.g. "int16 x10^-1".
+std::string storageTypeName(const ColumnStorage& storage);
+
+// Bytes one value takes in the given storage type.
+size_t storageWidth(StorageType type);
+
+// Picks the narrowest type that reproduces every value of the column exactly.
+ColumnStorage chooseColumnStorage(const std::vector<double>& values);
+
+// Appends the column in the given storage (which must come from chooseColumnStorage for these values).
+void encodeColumn(const std::vector<double>& values, const ColumnStorage& storage, std::vector<char>& out);
+
+// Decodes `count` values written by encodeColumn.
+void decodeColumn(const char* data, size_t count, const ColumnStorage& storage, std::vector<double>& values);
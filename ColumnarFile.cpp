@@ -0,0 +1,776 @@
+// ColumnarFile.cpp
+#include "ColumnarFile.h"
+#include "BinaryFormat.h"
+#include "BucketAggregator.h"
+#include "ColumnSchema.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+const char columnarMagic[8] = {'W', 'D', 'C', 'O', 'L', 'S', '0', '1'};
+const uint32_t columnarVersion = 1;
+
+// Fixed-size header at the start of every columnar file.
+struct ColumnarHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockRows;           // Rows per block; the last block may hold fewer
+    uint32_t columnNameCount;     // Timestamp column plus the value columns
+    uint32_t reserved;
+    uint64_t rowCount;
+    uint64_t blockCount;
+    uint64_t payloadSize;         // Bytes following the header
+    uint64_t checksum;            // Checksum of the names and the block directory
+};
+
+// Block directory entry: the block's time range and its timestamp chunk.
+struct BlockEntry {
+    int64_t minTime;
+    int64_t maxTime;
+    uint64_t offset;              // From the start of the payload
+    uint32_t rows;
+    uint32_t size;
+    uint64_t checksum;
+};
+
+enum ChunkEncoding : uint8_t {
+    ScaledDeltaEncoding = 0,      // Bit-packed deltas of round(value * 10^decimals)
+    XorEncoding = 1               // Gorilla XOR of consecutive IEEE bit patterns
+};
+
+const uint8_t hasNegativeZeros = 1;
+
+// Scales of the decimal counts chooseColumnStorage picks from, as exact constants
+const int maxDecimals = 6;
+const double powersOfTen[maxDecimals + 1] = {1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 1000000.0};
+
+// Column directory entry: the zone map and location of one column's chunk in one block.
+struct ChunkEntry {
+    double minValue;
+    double maxValue;
+    uint64_t offset;              // From the start of the payload
+    uint32_t size;
+    uint32_t missing;             // NaN readings
+    uint8_t encoding;             // ChunkEncoding
+    uint8_t decimals;
+    uint8_t flags;
+    uint8_t reserved[5];
+    uint64_t checksum;            // Of the chunk bytes
+    uint64_t entryChecksum;       // Of this entry up to here
+};
+
+std::runtime_error corruptFile(const std::string& what) {
+    return std::runtime_error("Corrupt columnar file: " + what);
+}
+
+unsigned bitWidth(uint64_t value) {
+    unsigned width = 0;
+    while (value) {
+        ++width;
+        value >>= 1;
+    }
+    return width;
+}
+
+unsigned leadingZeros(uint64_t value) {
+    unsigned count = 0;
+    for (uint64_t bit = 1ULL << 63; bit && !(value & bit); bit >>= 1) {
+        ++count;
+    }
+    return count;
+}
+
+unsigned trailingZeros(uint64_t value) {
+    unsigned count = 0;
+    for (uint64_t bit = 1; bit && !(value & bit); bit <<= 1) {
+        ++count;
+    }
+    return count;
+}
+
+// Appends bit fields least significant bit first.
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<char>& out) : out(out), buffer(0), used(0) {}
+
+    void write(uint64_t value, unsigned count) {
+        if (count < 64) {
+            value &= (1ULL << count) - 1;
+        }
+        buffer |= value << used;
+        if (used + count >= 64) {
+            flushWord();
+            unsigned consumed = 64 - used;
+            buffer = consumed < 64 ? value >> consumed : 0;
+            used = used + count - 64;
+        } else {
+            used += count;
+        }
+    }
+
+    // Writes the partly filled last word.
+    void finish() {
+        for (unsigned i = 0; i < used; i += 8) {
+            out.push_back(static_cast<char>(buffer >> i));
+        }
+        buffer = 0;
+        used = 0;
+    }
+
+private:
+    void flushWord() {
+        char bytes[8];
+        std::memcpy(bytes, &buffer, 8);
+        out.insert(out.end(), bytes, bytes + 8);
+    }
+
+    std::vector<char>& out;
+    uint64_t buffer;
+    unsigned used;
+};
+
+// Reads the fields BitWriter wrote, throwing if a field runs past the end of the chunk.
+class BitReader {
+public:
+    BitReader(const char* data, size_t size) : data(data), size(size), position(0) {}
+
+    uint64_t read(unsigned count) {
+        if (count == 0) {
+            return 0;
+        }
+        if (count > 56) {
+            uint64_t low = read(32);
+            return low | (read(count - 32) << 32);
+        }
+        if (position + count > size * 8) {
+            throw corruptFile("a chunk ends early.");
+        }
+        size_t byte = position / 8;
+        uint64_t word = 0;
+        std::memcpy(&word, data + byte, std::min<size_t>(8, size - byte));
+        word >>= position % 8;
+        position += count;
+        return word & ((1ULL << count) - 1);
+    }
+
+    // Bytes consumed so far, counting a partly read byte.
+    size_t bytesRead() const {
+        return (position + 7) / 8;
+    }
+
+private:
+    const char* data;
+    size_t size;
+    uint64_t position;
+};
+
+// Frame-of-reference over the deltas: the first value, the smallest delta, then every delta minus the
+// smallest in just enough bits. A steady hourly clock packs into zero bits per row.
+void appendDeltaPacked(const int64_t* values, size_t count, std::vector<char>& out) {
+    if (count == 0) {
+        return;
+    }
+    uint64_t minDelta = 0, maxDelta = 0;
+    for (size_t i = 1; i < count; ++i) {
+        int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(values[i - 1]));
+        if (i == 1 || delta < static_cast<int64_t>(minDelta)) {
+            minDelta = static_cast<uint64_t>(delta);
+        }
+        if (i == 1 || delta > static_cast<int64_t>(maxDelta)) {
+            maxDelta = static_cast<uint64_t>(delta);
+        }
+    }
+    const unsigned width = bitWidth(maxDelta - minDelta);
+    char head[17];
+    std::memcpy(head, &values[0], 8);
+    std::memcpy(head + 8, &minDelta, 8);
+    head[16] = static_cast<char>(width);
+    out.insert(out.end(), head, head + sizeof(head));
+
+    BitWriter bits(out);
+    for (size_t i = 1; i < count; ++i) {
+        bits.write(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(values[i - 1]) - minDelta, width);
+    }
+    bits.finish();
+}
+
+// Decodes `count` values written by appendDeltaPacked, returning the bytes consumed.
+size_t readDeltaPacked(const char* data, size_t size, size_t count, int64_t* values) {
+    if (count == 0) {
+        return 0;
+    }
+    if (size < 17) {
+        throw corruptFile("a chunk ends early.");
+    }
+    uint64_t current, minDelta;
+    std::memcpy(&current, data, 8);
+    std::memcpy(&minDelta, data + 8, 8);
+    const unsigned width = static_cast<unsigned char>(data[16]);
+    if (width > 64) {
+        throw corruptFile("invalid delta width.");
+    }
+    values[0] = static_cast<int64_t>(current);
+    BitReader bits(data + 17, size - 17);
+    for (size_t i = 1; i < count; ++i) {
+        current += minDelta + bits.read(width);
+        values[i] = static_cast<int64_t>(current);
+    }
+    return 17 + bits.bytesRead();
+}
+
+// Gorilla float compression: each value is XORed with the one before it. An unchanged value takes one
+// bit; otherwise the meaningful bits are stored, reusing the previous leading/trailing zero window when
+// they fit in it. NaN and -0.0 keep their exact bit patterns.
+void appendXor(const double* values, size_t count, std::vector<char>& out) {
+    BitWriter bits(out);
+    uint64_t previous = 0;
+    unsigned previousLeading = 65, previousTrailing = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t current;
+        std::memcpy(&current, &values[i], 8);
+        if (i == 0) {
+            bits.write(current, 64);
+            previous = current;
+            continue;
+        }
+        uint64_t delta = current ^ previous;
+        previous = current;
+        if (delta == 0) {
+            bits.write(0, 1);
+            continue;
+        }
+        unsigned leading = std::min(leadingZeros(delta), 31u);
+        unsigned trailing = trailingZeros(delta);
+        if (previousLeading <= 64 && leading >= previousLeading && trailing >= previousTrailing) {
+            bits.write(1, 1);
+            bits.write(0, 1);
+            bits.write(delta >> previousTrailing, 64 - previousLeading - previousTrailing);
+            continue;
+        }
+        unsigned length = 64 - leading - trailing;
+        bits.write(1, 1);
+        bits.write(1, 1);
+        bits.write(leading, 5);
+        bits.write(length - 1, 6);
+        bits.write(delta >> trailing, length);
+        previousLeading = leading;
+        previousTrailing = trailing;
+    }
+    bits.finish();
+}
+
+void readXor(const char* data, size_t size, size_t count, double* values) {
+    BitReader bits(data, size);
+    uint64_t previous = 0;
+    unsigned previousLeading = 65, previousTrailing = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (i == 0) {
+            previous = bits.read(64);
+        } else if (bits.read(1)) {
+            unsigned length;
+            if (bits.read(1) == 0) {
+                if (previousLeading > 64) {
+                    throw corruptFile("invalid XOR window.");
+                }
+                length = 64 - previousLeading - previousTrailing;
+            } else {
+                previousLeading = static_cast<unsigned>(bits.read(5));
+                length = static_cast<unsigned>(bits.read(6)) + 1;
+                if (previousLeading + length > 64) {
+                    throw corruptFile("invalid XOR window.");
+                }
+                previousTrailing = 64 - previousLeading - length;
+            }
+            previous ^= bits.read(length) << previousTrailing;
+        }
+        std::memcpy(&values[i], &previous, 8);
+    }
+}
+
+void appendBitmap(const std::vector<bool>& bits, std::vector<char>& out) {
+    size_t start = out.size();
+    out.resize(start + (bits.size() + 7) / 8, '\0');
+    for (size_t i = 0; i < bits.size(); ++i) {
+        if (bits[i]) {
+            out[start + i / 8] |= static_cast<char>(1 << (i % 8));
+        }
+    }
+}
+
+bool bitmapAt(const char* bitmap, size_t i) {
+    return (static_cast<unsigned char>(bitmap[i / 8]) >> (i % 8)) & 1;
+}
+
+// Encodes one column of one block, filling in the zone map and encoding of its directory entry. Scaled
+// deltas skip the missing readings (a bitmap marks them) and flag -0.0 separately so every value
+// decodes exactly; the XOR form is kept instead when it is smaller or the readings are not decimal.
+void encodeValueChunk(const double* values, size_t count, ChunkEntry& entry, std::vector<char>& out) {
+    std::memset(&entry, 0, sizeof(entry));
+    entry.minValue = std::numeric_limits<double>::quiet_NaN();
+    entry.maxValue = std::numeric_limits<double>::quiet_NaN();
+    std::vector<bool> missing(count, false), negativeZero(count, false);
+    bool anyNegativeZero = false;
+    for (size_t i = 0; i < count; ++i) {
+        double value = values[i];
+        if (std::isnan(value)) {
+            missing[i] = true;
+            ++entry.missing;
+            continue;
+        }
+        if (value == 0.0 && std::signbit(value)) {
+            negativeZero[i] = anyNegativeZero = true;
+        }
+        if (!(value >= entry.minValue)) entry.minValue = value;
+        if (!(value <= entry.maxValue)) entry.maxValue = value;
+    }
+
+    std::vector<char> xorChunk;
+    appendXor(values, count, xorChunk);
+
+    ColumnStorage storage = chooseColumnStorage(std::vector<double>(values, values + count));
+    if (storage.type == StorageType::Int16 || storage.type == StorageType::Int32) {
+        const double scale = powersOfTen[storage.decimals];
+        std::vector<int64_t> codes;
+        codes.reserve(count - entry.missing);
+        for (size_t i = 0; i < count; ++i) {
+            if (!missing[i]) {
+                codes.push_back(static_cast<int64_t>(std::nearbyint(values[i] * scale)));
+            }
+        }
+        std::vector<char> deltaChunk;
+        if (entry.missing) {
+            appendBitmap(missing, deltaChunk);
+        }
+        if (anyNegativeZero) {
+            appendBitmap(negativeZero, deltaChunk);
+        }
+        appendDeltaPacked(codes.data(), codes.size(), deltaChunk);
+        if (deltaChunk.size() <= xorChunk.size()) {
+            entry.encoding = ScaledDeltaEncoding;
+            entry.decimals = static_cast<uint8_t>(storage.decimals);
+            entry.flags = anyNegativeZero ? hasNegativeZeros : 0;
+            out.swap(deltaChunk);
+            return;
+        }
+    }
+    entry.encoding = XorEncoding;
+    out.swap(xorChunk);
+}
+
+void decodeValueChunk(const char* data, size_t size, const ChunkEntry& entry, size_t count, double* values) {
+    if (entry.encoding == XorEncoding) {
+        readXor(data, size, count, values);
+        return;
+    }
+    if (entry.encoding != ScaledDeltaEncoding || entry.decimals > maxDecimals || entry.missing > count) {
+        throw corruptFile("unknown chunk encoding.");
+    }
+    const size_t bitmapBytes = (count + 7) / 8;
+    const char* missing = nullptr;
+    const char* negativeZero = nullptr;
+    const char* p = data;
+    const char* end = data + size;
+    if (entry.missing) {
+        missing = p;
+        p += bitmapBytes;
+    }
+    if (entry.flags & hasNegativeZeros) {
+        negativeZero = p;
+        p += bitmapBytes;
+    }
+    if (p > end) {
+        throw corruptFile("a chunk ends early.");
+    }
+    std::vector<int64_t> codes(count - entry.missing);
+    readDeltaPacked(p, static_cast<size_t>(end - p), codes.size(), codes.data());
+
+    // The same division the snapshot decoder uses, so both give identical doubles
+    const double scale = powersOfTen[entry.decimals];
+    size_t next = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (missing && bitmapAt(missing, i)) {
+            values[i] = std::numeric_limits<double>::quiet_NaN();
+        } else if (negativeZero && bitmapAt(negativeZero, i)) {
+            values[i] = -0.0;
+            ++next;
+        } else {
+            values[i] = static_cast<double>(codes[next++]) / scale;
+        }
+    }
+}
+
+BlockEntry blockEntryAt(const char* directory, size_t block) {
+    BlockEntry entry;
+    std::memcpy(&entry, directory + block * sizeof(BlockEntry), sizeof(entry));
+    return entry;
+}
+
+} // namespace
+
+ColumnarFile::ColumnarFile(const std::string& path)
+    : file(path), payload(nullptr), payloadSize(0), rows(0), blocks(0), blockDirectory(nullptr), columnDirectories(nullptr) {
+    if (!hostIsLittleEndian()) {
+        throw std::runtime_error("Columnar files are only supported on little-endian hosts.");
+    }
+    ColumnarHeader header;
+    if (file.size() < sizeof(header)) {
+        throw std::runtime_error("Not a columnar weather file: " + path);
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, columnarMagic, sizeof(columnarMagic)) != 0) {
+        throw std::runtime_error("Not a columnar weather file: " + path);
+    }
+    if (header.version != columnarVersion) {
+        throw std::runtime_error("Unsupported columnar file version " + std::to_string(header.version) + ": " + path);
+    }
+    if (header.payloadSize != file.size() - sizeof(header) || header.columnNameCount == 0) {
+        throw corruptFile(path);
+    }
+
+    payload = file.data() + sizeof(header);
+    payloadSize = static_cast<size_t>(header.payloadSize);
+    const char* end = payload + payloadSize;
+    const char* p = payload;
+    blocks = static_cast<size_t>(header.blockCount);
+    if (!readNames(p, end, payload, header.columnNameCount, names) || static_cast<size_t>(end - p) / sizeof(BlockEntry) < blocks) {
+        throw corruptFile(path);
+    }
+    blockDirectory = p;
+    p += blocks * sizeof(BlockEntry);
+    if (payloadChecksum(payload, static_cast<size_t>(p - payload)) != header.checksum) {
+        throw corruptFile(path);
+    }
+    const size_t valueColumns = names.size() - 1;
+    if (valueColumns && static_cast<size_t>(end - p) / sizeof(ChunkEntry) / valueColumns < blocks) {
+        throw corruptFile(path);
+    }
+    columnDirectories = p;
+
+    for (size_t b = 0; b < blocks; ++b) {
+        BlockEntry entry = blockEntryAt(blockDirectory, b);
+        if (entry.rows == 0 || entry.offset > payloadSize || entry.size > payloadSize - entry.offset) {
+            throw corruptFile(path);
+        }
+        rows += entry.rows;
+    }
+    if (rows != header.rowCount) {
+        throw corruptFile(path);
+    }
+}
+
+const std::vector<std::string>& ColumnarFile::columnNames() const {
+    return names;
+}
+
+size_t ColumnarFile::rowCount() const {
+    return rows;
+}
+
+size_t ColumnarFile::blockCount() const {
+    return blocks;
+}
+
+size_t ColumnarFile::blockRowCount(size_t block) const {
+    if (block >= blocks) {
+        throw std::runtime_error("Columnar block index out of range.");
+    }
+    return blockEntryAt(blockDirectory, block).rows;
+}
+
+long long ColumnarFile::blockMinTime(size_t block) const {
+    if (block >= blocks) {
+        throw std::runtime_error("Columnar block index out of range.");
+    }
+    return blockEntryAt(blockDirectory, block).minTime;
+}
+
+long long ColumnarFile::blockMaxTime(size_t block) const {
+    if (block >= blocks) {
+        throw std::runtime_error("Columnar block index out of range.");
+    }
+    return blockEntryAt(blockDirectory, block).maxTime;
+}
+
+int ColumnarFile::columnIndex(const std::string& name) const {
+    for (size_t i = 1; i < names.size(); ++i) {
+        if (names[i] == name) {
+            return static_cast<int>(i - 1);
+        }
+    }
+    return -1;
+}
+
+const char* ColumnarFile::chunkEntryAt(size_t block, size_t column) const {
+    if (block >= blocks || column + 1 >= names.size()) {
+        throw std::runtime_error("Columnar block index out of range.");
+    }
+    const char* at = columnDirectories + (column * blocks + block) * sizeof(ChunkEntry);
+    ChunkEntry entry;
+    std::memcpy(&entry, at, sizeof(entry));
+    if (payloadChecksum(at, offsetof(ChunkEntry, entryChecksum)) != entry.entryChecksum || entry.offset > payloadSize ||
+        entry.size > payloadSize - entry.offset) {
+        throw corruptFile("directory of " + names[column + 1]);
+    }
+    return at;
+}
+
+BlockZone ColumnarFile::zone(size_t block, size_t column) const {
+    ChunkEntry entry;
+    std::memcpy(&entry, chunkEntryAt(block, column), sizeof(entry));
+    BlockEntry blockEntry = blockEntryAt(blockDirectory, block);
+    BlockZone zone;
+    zone.minTime = blockEntry.minTime;
+    zone.maxTime = blockEntry.maxTime;
+    zone.minValue = entry.minValue;
+    zone.maxValue = entry.maxValue;
+    zone.rows = blockEntry.rows;
+    zone.missing = entry.missing;
+    return zone;
+}
+
+std::vector<size_t> ColumnarFile::blocksInTimeRange(long long from, long long to) const {
+    std::vector<size_t> selected;
+    for (size_t b = 0; b < blocks; ++b) {
+        BlockEntry entry = blockEntryAt(blockDirectory, b);
+        if (entry.maxTime >= from && entry.minTime < to) {
+            selected.push_back(b);
+        }
+    }
+    return selected;
+}
+
+std::vector<size_t> ColumnarFile::blocksInValueRange(size_t column, double minValue, double maxValue) const {
+    std::vector<size_t> selected;
+    for (size_t b = 0; b < blocks; ++b) {
+        BlockZone blockZone = zone(b, column);
+        if (blockZone.maxValue >= minValue && blockZone.minValue <= maxValue) {
+            selected.push_back(b);
+        }
+    }
+    return selected;
+}
+
+void ColumnarFile::readTimestamps(size_t block, long long* out) const {
+    if (block >= blocks) {
+        throw std::runtime_error("Columnar block index out of range.");
+    }
+    BlockEntry entry = blockEntryAt(blockDirectory, block);
+    const char* data = payload + entry.offset;
+    if (payloadChecksum(data, entry.size) != entry.checksum) {
+        throw corruptFile("timestamps of block " + std::to_string(block));
+    }
+    std::vector<int64_t> decoded(entry.rows);
+    readDeltaPacked(data, entry.size, decoded.size(), decoded.data());
+    std::copy(decoded.begin(), decoded.end(), out);
+}
+
+void ColumnarFile::readColumn(size_t block, size_t column, double* out) const {
+    ChunkEntry entry;
+    std::memcpy(&entry, chunkEntryAt(block, column), sizeof(entry));
+    const char* data = payload + entry.offset;
+    if (payloadChecksum(data, entry.size) != entry.checksum) {
+        throw corruptFile(names[column + 1] + " in block " + std::to_string(block));
+    }
+    decodeValueChunk(data, entry.size, entry, blockEntryAt(blockDirectory, block).rows, out);
+}
+
+size_t ColumnarFile::timestampChunkSize(size_t block) const {
+    if (block >= blocks) {
+        throw std::runtime_error("Columnar block index out of range.");
+    }
+    return blockEntryAt(blockDirectory, block).size;
+}
+
+size_t ColumnarFile::columnChunkSize(size_t block, size_t column) const {
+    ChunkEntry entry;
+    std::memcpy(&entry, chunkEntryAt(block, column), sizeof(entry));
+    return entry.size;
+}
+
+bool isColumnarFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(columnarMagic)];
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, columnarMagic, sizeof(magic)) == 0;
+}
+
+// Encodes every chunk on worker threads, then lays them out column by column so reading one column
+// touches one contiguous stretch of the file.
+
+void writeColumnarFile(const std::string& path, const WeatherData& weatherData, const std::string& timestampName,
+                       const std::vector<std::string>& columns, size_t blockRows) {
+    PROFILE_SCOPE("columnar write");
+    if (!hostIsLittleEndian()) {
+        throw std::runtime_error("Columnar files are only supported on little-endian hosts.");
+    }
+    if (blockRows == 0 || blockRows > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Invalid columnar block size: " + std::to_string(blockRows));
+    }
+    std::vector<const std::vector<double>*> values;
+    for (const auto& name : columns) {
+        const std::vector<double>* column = weatherData.column(name);
+        if (!column) {
+            throw std::runtime_error("Column not found: " + name);
+        }
+        values.push_back(column);
+    }
+
+    const std::vector<long long>& timestamps = weatherData.timestamps();
+    const size_t rows = timestamps.size();
+    const size_t blocks = (rows + blockRows - 1) / blockRows;
+    std::vector<BlockEntry> blockEntries(blocks);
+    std::vector<ChunkEntry> chunkEntries(blocks * values.size());
+    std::vector<std::vector<char>> chunks(blocks * (values.size() + 1));
+    parallelFor(chunks.size(), [&](size_t task) {
+        const size_t c = task / blocks, b = task % blocks;
+        const size_t first = b * blockRows;
+        const size_t count = std::min(blockRows, rows - first);
+        if (c == 0) {
+            BlockEntry& entry = blockEntries[b];
+            std::memset(&entry, 0, sizeof(entry));
+            std::vector<int64_t> block(timestamps.begin() + first, timestamps.begin() + first + count);
+            entry.minTime = *std::min_element(block.begin(), block.end());
+            entry.maxTime = *std::max_element(block.begin(), block.end());
+            entry.rows = static_cast<uint32_t>(count);
+            appendDeltaPacked(block.data(), count, chunks[task]);
+        } else {
+            encodeValueChunk(values[c - 1]->data() + first, count, chunkEntries[(c - 1) * blocks + b], chunks[task]);
+        }
+    });
+
+    std::vector<std::string> names(1, timestampName);
+    names.insert(names.end(), columns.begin(), columns.end());
+    std::vector<char> payload;
+    appendNames(payload, names);
+    const size_t blockDirectoryStart = payload.size();
+    const size_t columnDirectoryStart = blockDirectoryStart + blocks * sizeof(BlockEntry);
+    payload.resize(columnDirectoryStart + chunkEntries.size() * sizeof(ChunkEntry));
+
+    for (size_t task = 0; task < chunks.size(); ++task) {
+        const size_t c = task / blocks, b = task % blocks;
+        std::vector<char>& chunk = chunks[task];
+        if (chunk.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("Columnar block too large; use fewer rows per block.");
+        }
+        uint64_t offset = payload.size();
+        uint32_t size = static_cast<uint32_t>(chunk.size());
+        uint64_t checksum = payloadChecksum(chunk.data(), chunk.size());
+        if (c == 0) {
+            blockEntries[b].offset = offset;
+            blockEntries[b].size = size;
+            blockEntries[b].checksum = checksum;
+        } else {
+            ChunkEntry& entry = chunkEntries[(c - 1) * blocks + b];
+            entry.offset = offset;
+            entry.size = size;
+            entry.checksum = checksum;
+            entry.entryChecksum = payloadChecksum(reinterpret_cast<const char*>(&entry), offsetof(ChunkEntry, entryChecksum));
+        }
+        payload.insert(payload.end(), chunk.begin(), chunk.end());
+        std::vector<char>().swap(chunk);
+    }
+    if (!blockEntries.empty()) {
+        std::memcpy(&payload[blockDirectoryStart], blockEntries.data(), blockEntries.size() * sizeof(BlockEntry));
+    }
+    if (!chunkEntries.empty()) {
+        std::memcpy(&payload[columnDirectoryStart], chunkEntries.data(), chunkEntries.size() * sizeof(ChunkEntry));
+    }
+
+    ColumnarHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, columnarMagic, sizeof(columnarMagic));
+    header.version = columnarVersion;
+    header.blockRows = static_cast<uint32_t>(blockRows);
+    header.columnNameCount = static_cast<uint32_t>(names.size());
+    header.rowCount = rows;
+    header.blockCount = blocks;
+    header.payloadSize = payload.size();
+    header.checksum = payloadChecksum(payload.data(), columnDirectoryStart);
+
+    replaceFile(path, &header, sizeof(header), payload);
+}
+
+// Blocks are normally in time order; if they are not, nothing before the range can be ruled out and
+// loading starts at the first block. An unbounded range selects every block.
+
+std::vector<size_t> blocksForCandles(const ColumnarFile& file, const std::vector<size_t>& columns, long long from, long long to) {
+    const long long lowest = std::numeric_limits<long long>::min();
+    const long long highest = std::numeric_limits<long long>::max();
+    const size_t blocks = file.blockCount();
+
+    // The weeks and years cut by the end of the range still need all of their readings
+    long long end = to;
+    if (to != highest && to != lowest) {
+        end = std::max(nextBucketStart(bucketStart(to - 1, BucketSize::Year), BucketSize::Year),
+                       nextBucketStart(bucketStart(to - 1, BucketSize::Week), BucketSize::Week));
+    }
+
+    // Each column's last block that ends before the range and has a reading holds the start of the
+    // previous bucket or an earlier time, so the widest bucket around that block's first row covers it
+    long long begin = from;
+    bool ordered = true;
+    for (size_t b = 1; b < blocks && ordered; ++b) {
+        ordered = file.blockMinTime(b) >= file.blockMaxTime(b - 1);
+    }
+    for (size_t c = 0; c < columns.size() && begin != lowest; ++c) {
+        size_t b = ordered ? blocks : 0;
+        while (b > 0 && !(file.blockMaxTime(b - 1) < from && file.zone(b - 1, columns[c]).missing < file.blockRowCount(b - 1))) {
+            --b;
+        }
+        if (b == 0) {
+            begin = lowest;
+            break;
+        }
+        long long first = file.blockMinTime(b - 1);
+        begin = std::min(begin, std::min(bucketStart(first, BucketSize::Year), bucketStart(first, BucketSize::Week)));
+    }
+
+    std::vector<size_t> selected;
+    for (size_t b = 0; b < blocks; ++b) {
+        if (file.blockMaxTime(b) >= begin && file.blockMinTime(b) < end) {
+            selected.push_back(b);
+        }
+    }
+    return selected;
+}
+
+std::vector<ColumnarReading> selectReadings(const ColumnarFile& file, const std::string& column, double minValue, double maxValue,
+                                            long long from, long long to) {
+    PROFILE_SCOPE("columnar scan");
+    int index = file.columnIndex(column);
+    if (index < 0) {
+        throw std::runtime_error("Column not found: " + column);
+    }
+    std::vector<ColumnarReading> readings;
+    std::vector<long long> timestamps;
+    std::vector<double> values;
+    size_t blocksRead = 0;
+    for (size_t b = 0; b < file.blockCount(); ++b) {
+        BlockZone zone = file.zone(b, static_cast<size_t>(index));
+        if (zone.maxTime < from || zone.minTime >= to || !(zone.maxValue >= minValue && zone.minValue <= maxValue)) {
+            continue;
+        }
+        ++blocksRead;
+        timestamps.resize(zone.rows);
+        values.resize(zone.rows);
+        file.readTimestamps(b, timestamps.data());
+        file.readColumn(b, static_cast<size_t>(index), values.data());
+        for (size_t i = 0; i < zone.rows; ++i) {
+            if (timestamps[i] >= from && timestamps[i] < to && values[i] >= minValue && values[i] <= maxValue) {
+                ColumnarReading reading = {timestamps[i], values[i]};
+                readings.push_back(reading);
+            }
+        }
+    }
+    PROFILE_COUNT("blocks read", blocksRead);
+    PROFILE_COUNT("blocks skipped", file.blockCount() - blocksRead);
+    return readings;
+}
@@ -0,0 +1,106 @@
+// ColumnarFile.h
+#pragma once
+#include "WeatherData.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <vector>
+#include <string>
+
+// Native columnar weather file, a compressed alternative to the CSV export ("weather.wcol").
+// Rows are split into fixed-size blocks and every column of a block is compressed on its own:
+// timestamps as bit-packed deltas, value columns either as bit-packed deltas of their scaled integer
+// codes (when every reading has a few decimals, see ColumnStorage) or with Gorilla-style XOR float
+// encoding, whichever is smaller. Both decode to exactly the doubles the CSV parser produced.
+//
+// Layout, little-endian: fixed header, column names, the block directory (row count, time range and
+// timestamp chunk of each block), one directory per value column (value range, missing readings,
+// encoding, offset and checksum of each of its chunks), then the chunks. Every directory entry carries
+// its own checksum, so using a few columns never reads the directories of the others. The directories
+// are the zone maps: time and value predicates pick blocks from them without decoding any chunk.
+
+// Rows per block unless the writer is told otherwise: about six weeks of hourly readings, small enough
+// for value ranges to skip the other seasons.
+const size_t defaultColumnarBlockRows = 1024;
+
+// Time span of one block and value range of one of its columns. The value range ignores missing
+// readings, and both bounds are NaN when the block holds none.
+struct BlockZone {
+    long long minTime;
+    long long maxTime;
+    double minValue;
+    double maxValue;
+    size_t rows;
+    size_t missing;
+};
+
+// One reading returned by a value-range scan.
+struct ColumnarReading {
+    long long timestamp;
+    double value;
+};
+
+// ColumnarFile class that maps a columnar file and decodes single blocks on demand. Opening it reads the
+// header and block directory only; a column's directory and chunks are read when that column is used.
+class ColumnarFile {
+public:
+    // Constructor that maps and validates the file, throwing if it is not a readable columnar file.
+    explicit ColumnarFile(const std::string& path);
+    // Names in CSV header order: the timestamp column, then every stored value column.
+    const std::vector<std::string>& columnNames() const;
+    size_t rowCount() const;
+    size_t blockCount() const;
+    size_t blockRowCount(size_t block) const;
+    // Earliest and latest timestamp in a block.
+    long long blockMinTime(size_t block) const;
+    long long blockMaxTime(size_t block) const;
+    // Index among the value columns (columnNames() without the timestamp), or -1 if it is not stored.
+    int columnIndex(const std::string& name) const;
+    // Zone map of one column in one block. Throws if the column directory is corrupt.
+    BlockZone zone(size_t block, size_t column) const;
+    // Blocks with a timestamp in [from, to) (UTC epoch seconds).
+    std::vector<size_t> blocksInTimeRange(long long from, long long to) const;
+    // Blocks in which the column has a reading in [minValue, maxValue].
+    std::vector<size_t> blocksInValueRange(size_t column, double minValue, double maxValue) const;
+    // Decode one block into `out`, which must have room for blockRowCount(block) values. Both throw if
+    // the chunk fails its checksum.
+    void readTimestamps(size_t block, long long* out) const;
+    void readColumn(size_t block, size_t column, double* out) const;
+    // Compressed size of a chunk, for I/O accounting.
+    size_t timestampChunkSize(size_t block) const;
+    size_t columnChunkSize(size_t block, size_t column) const;
+
+private:
+    ColumnarFile(const ColumnarFile&);
+    ColumnarFile& operator=(const ColumnarFile&);
+
+    // Directory entry of one column in one block, throwing if it is out of range or corrupt.
+    const char* chunkEntryAt(size_t block, size_t column) const;
+
+    MappedFile file;
+    std::vector<std::string> names;
+    const char* payload;
+    size_t payloadSize;
+    size_t rows;
+    size_t blocks;
+    const char* blockDirectory;
+    const char* columnDirectories;      // Column-major: every block of the first column, then the next
+};
+
+// True if the file starts with the columnar file signature.
+bool isColumnarFile(const std::string& path);
+
+// Writes the timestamps and the listed loaded columns of weatherData as a columnar file, atomically.
+// `timestampName` becomes the first column name, as in the CSV header. Throws on I/O failure.
+void writeColumnarFile(const std::string& path, const WeatherData& weatherData, const std::string& timestampName,
+                       const std::vector<std::string>& columns, size_t blockRows = defaultColumnarBlockRows);
+
+// Blocks to load so that every candlestick (hourly to yearly) whose bucket starts in [from, to) comes out
+// exactly as it would from the whole file: the blocks overlapping the range widened to the end of the
+// buckets it cuts, back to the last bucket before it that holds a reading of one of the columns, whose
+// close the first candle opens from.
+std::vector<size_t> blocksForCandles(const ColumnarFile& file, const std::vector<size_t>& columns, long long from, long long to);
+
+// Readings of a column that lie in [minValue, maxValue] and were taken in [from, to), in row order.
+// Blocks whose zone map rules out either range are skipped without being decoded.
+std::vector<ColumnarReading> selectReadings(const ColumnarFile& file, const std::string& column, double minValue, double maxValue,
+                                            long long from, long long to);
@@ -0,0 +1,66 @@
+// ComputeCandlesticks.cpp
+#include "ComputeCandlesticks.h"
+#include "Profiler.h"
+#include <map>
+#include <functional>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+
+ArenaVector<Candlestick> computeCandlesticks(const ArenaVector<std::pair<std::string, double>>& entries, Arena* arena) {
+    PROFILE_SCOPE("compute candlesticks");
+    typedef std::pair<const std::string, ArenaVector<double>> Group;
+    std::map<std::string, ArenaVector<double>, std::less<std::string>, ArenaAllocator<Group>> groupedData{
+        std::less<std::string>(), ArenaAllocator<Group>(arena)};
+
+    // Group temperatures by year (YYYY)
+    for (const auto& entry : entries) {
+        if (entry.first.length() < 4) {
+            std::cerr << "Warning: Invalid date format '" << entry.first << "'" << std::endl;
+            continue;
+        }
+        std::string year = entry.first.substr(0, 4);  // Extract YYYY
+        auto group = groupedData.find(year);
+        if (group == groupedData.end()) {
+            group = groupedData.emplace(year, ArenaVector<double>(ArenaAllocator<double>(arena))).first;
+        }
+        group->second.push_back(entry.second);
+    }
+
+    ArenaVector<Candlestick> candlesticks{ArenaAllocator<Candlestick>(arena)};
+    if (groupedData.empty()) {
+        return candlesticks;
+    }
+    double prevClose = 0.000; // Initialize to 0.000 for the first year
+
+    // Compute candlestick data for each year from the first to the last one in the data
+    const int firstYear = std::atoi(groupedData.begin()->first.c_str());
+    const int lastYear = std::atoi(groupedData.rbegin()->first.c_str());
+    candlesticks.reserve(lastYear - firstYear + 1);
+    for (int year = firstYear; year <= lastYear; ++year) {
+        std::string yearStr = std::to_string(year);
+
+        auto group = groupedData.find(yearStr);
+        if (group != groupedData.end()) {
+            const ArenaVector<double>& temperatures = group->second;
+            double open = prevClose;
+            double close = std::accumulate(temperatures.begin(), temperatures.end(), 0.0) / temperatures.size();
+            double high = *std::max_element(temperatures.begin(), temperatures.end());
+            double low = *std::min_element(temperatures.begin(), temperatures.end());
+
+            candlesticks.emplace_back(yearStr, open, close, high, low);
+            prevClose = close;
+        } else {
+            std::cerr << "Warning: Missing data for year " << yearStr << std::endl;
+            candlesticks.emplace_back(yearStr, prevClose, prevClose, prevClose, prevClose);
+        }
+    }
+
+    PROFILE_COUNT("candles produced", candlesticks.size());
+
+    std::cerr << "Debug: Computed " << candlesticks.size() << " candlesticks.\n";
+
+    return candlesticks;
+}
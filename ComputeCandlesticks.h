@@ -0,0 +1,11 @@
+// ComputeCandlesticks.h
+#pragma once
+#include "Candlestick.h"
+#include "Arena.h"
+#include <vector>
+#include <string>
+#include <utility>
+
+//Compute yearly candlestick data from the first to the last year in the entries, Vector of pairs (year, temperature) and Vector of Candlestick objects
+// The grouping buffers and the result are allocated in arena when one is given.
+ArenaVector<Candlestick> computeCandlesticks(const ArenaVector<std::pair<std::string, double>>& entries, Arena* arena = nullptr);
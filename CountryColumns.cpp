@@ -0,0 +1,92 @@
+// CountryColumns.cpp
+#include "CountryColumns.h"
+#include "ColumnSchema.h"
+#include "ColumnarFile.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// Reads the header line of the CSV file and splits it into column names. Columnar files list the
+// same names in their header.
+
+std::vector<std::string> getColumnNames(const std::string& filename) {
+    if (isColumnarFile(filename)) {
+        return ColumnarFile(filename).columnNames();
+    }
+    std::ifstream file(filename);
+    std::vector<std::string> columnNames;
+
+    if (file.is_open()) {
+        std::string headerLine;
+        std::getline(file, headerLine); // Read the first line
+        std::stringstream ss(headerLine);
+        std::string column;
+
+        while (std::getline(ss, column, ',')) {
+            columnNames.push_back(column);
+        }
+    } else {
+        throw std::runtime_error("Unable to open file: " + filename);
+    }
+
+    return columnNames;
+}
+
+//  Dynamically extracts country columns from the dataset.
+//  Vector of column names from the dataset.
+//   Map of menu index to column name (e.g., "AT_temperature").
+
+std::map<int, std::string> extractCountryColumns(const std::vector<std::string>& columnNames) {
+    return ColumnSchema(columnNames).menu("temperature");
+}
+
+// Converts a column name into a user-friendly country name.
+//  Column name from the dataset (e.g., "AT_temperature").
+//  Formatted country name (e.g., "Austria Temperature").
+
+std::string formatCountryName(const std::string& columnName) {
+    size_t split = columnName.find("_");
+    std::string countryCode = columnName.substr(0, split);
+    std::string countryName = countryCode; // Default to code if not mapped
+
+    // Example map of country codes to full names (add more if needed)
+    static std::map<std::string, std::string> countryNameMap = {
+        {"AT", "Austria"},
+        {"BE", "Belgium"},
+        {"BG", "Bulgaria"},
+        {"CH", "Switzerland"},
+        {"CZ", "Czech Republic"},
+        {"DE", "Germany"},
+        {"DK", "Denmark"},
+        {"EE", "Estonia"},
+        {"ES", "Spain"},
+        {"FI", "Finland"},
+        {"FR", "France"},
+        {"GB", "United Kingdom"},
+        {"GR", "Greece"},
+        {"HR", "Croatia"},
+        {"HU", "Hungary"},
+        {"IE", "Ireland"},
+        {"IT", "Italy"},
+        {"LT", "Lithuania"},
+        {"LU", "Luxembourg"},
+        {"LV", "Latvia"},
+        {"NL", "Netherlands"},
+        {"NO", "Norway"},
+        {"PL", "Poland"},
+        {"PT", "Portugal"},
+        {"RO", "Romania"},
+        {"SE", "Sweden"},
+        {"SI", "Slovenia"},
+        {"SK", "Slovakia"}
+    };
+
+    if (countryNameMap.find(countryCode) != countryNameMap.end()) {
+        countryName = countryNameMap[countryCode];
+    }
+
+    if (split == std::string::npos) {
+        return countryName;
+    }
+    return countryName + " " + formatVariableName(columnName.substr(split + 1));
+}
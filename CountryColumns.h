@@ -0,0 +1,15 @@
+// CountryColumns.h
+#pragma once
+#include <vector>
+#include <string>
+#include <map>
+
+// Reads the column names from the header line of a CSV file.
+std::vector<std::string> getColumnNames(const std::string& filename);
+
+// Maps menu indices (from 1) to the country temperature columns, e.g. 1 -> "AT_temperature".
+std::map<int, std::string> extractCountryColumns(const std::vector<std::string>& columnNames);
+
+// Converts a column name into a user-friendly name, e.g. "AT_temperature" -> "Austria Temperature"
+// or "DE_radiation_diffuse_horizontal" -> "Germany Radiation Diffuse Horizontal".
+std::string formatCountryName(const std::string& columnName);
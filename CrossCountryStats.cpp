@@ -0,0 +1,237 @@
+// CrossCountryStats.cpp
+#include "CrossCountryStats.h"
+#include "Kernels.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Rows per tile: the tile's transformed columns (three arrays per column) stay within L2
+const size_t tileRows = 1024;
+
+// Fixed number of row partitions, so partial sums are always added in the same order
+const size_t partitionCount = 64;
+
+// Per-pair sums over the rows where both columns have readings, in centered units.
+struct PairSums {
+    double count;
+    double sumX;      // Sum of x over rows where y is present
+    double sumY;
+    double sumXX;
+    double sumYY;
+    double sumXY;
+};
+
+std::vector<const std::vector<double>*> lookupColumns(const WeatherData& weatherData, const std::vector<std::string>& columns) {
+    std::vector<const std::vector<double>*> data;
+    for (const auto& name : columns) {
+        const std::vector<double>* values = weatherData.column(name);
+        if (!values) {
+            throw std::runtime_error("Column not found: " + name);
+        }
+        data.push_back(values);
+    }
+    return data;
+}
+
+// Accumulates the pair sums of rows [begin, end) tile by tile. Each column is centered by its mean and
+// split into x (0 where missing), x^2 and a 0/1 presence mask, which turns every sum over "rows where
+// both are present" into a plain dot product: sum x_i*m_j, sum x_i^2*m_j, sum x_i*x_j, sum m_i*m_j.
+void accumulatePairs(const std::vector<const std::vector<double>*>& data, const std::vector<double>& means,
+                     size_t begin, size_t end, std::vector<PairSums>& sums) {
+    const size_t k = data.size();
+    std::vector<double> centered(k * tileRows), squared(k * tileRows), present(k * tileRows);
+
+    for (size_t tile = begin; tile < end; tile += tileRows) {
+        const size_t n = std::min(tileRows, end - tile);
+        for (size_t c = 0; c < k; ++c) {
+            const double* source = data[c]->data() + tile;
+            double* x = &centered[c * tileRows];
+            double* xx = &squared[c * tileRows];
+            double* m = &present[c * tileRows];
+            for (size_t r = 0; r < n; ++r) {
+                bool valid = !std::isnan(source[r]);
+                double value = valid ? source[r] - means[c] : 0.0;
+                x[r] = value;
+                xx[r] = value * value;
+                m[r] = valid ? 1.0 : 0.0;
+            }
+        }
+        for (size_t i = 0; i < k; ++i) {
+            const double* xi = &centered[i * tileRows];
+            const double* xxi = &squared[i * tileRows];
+            const double* mi = &present[i * tileRows];
+            for (size_t j = i; j < k; ++j) {
+                const double* xj = &centered[j * tileRows];
+                const double* xxj = &squared[j * tileRows];
+                const double* mj = &present[j * tileRows];
+                PairSums& pair = sums[i * k + j];
+                pair.count += simdDot(mi, mj, n);
+                pair.sumX += simdDot(xi, mj, n);
+                pair.sumY += simdDot(mi, xj, n);
+                pair.sumXX += simdDot(xxi, mj, n);
+                pair.sumYY += simdDot(mi, xxj, n);
+                pair.sumXY += simdDot(xi, xj, n);
+            }
+        }
+    }
+}
+
+} // namespace
+
+CorrelationMatrix correlationMatrix(const WeatherData& weatherData, const std::vector<std::string>& columns) {
+    PROFILE_SCOPE("correlation");
+    std::vector<const std::vector<double>*> data = lookupColumns(weatherData, columns);
+    const size_t k = data.size();
+    const size_t rows = weatherData.rowCount();
+
+    // Column means first, so the pair sums are taken around them and do not cancel catastrophically
+    std::vector<double> means(k, 0.0);
+    parallelFor(k, [&](size_t c) {
+        double sum = 0.0;
+        size_t count = 0;
+        for (double value : *data[c]) {
+            if (!std::isnan(value)) {
+                sum += value;
+                ++count;
+            }
+        }
+        means[c] = count ? sum / count : 0.0;
+    });
+
+    // Partition boundaries are multiples of the tile size, independent of the thread count
+    size_t tilesTotal = (rows + tileRows - 1) / tileRows;
+    size_t partitions = std::max<size_t>(1, std::min(partitionCount, tilesTotal));
+    std::vector<std::vector<PairSums>> partials(partitions, std::vector<PairSums>(k * k, PairSums()));
+    parallelFor(partitions, [&](size_t p) {
+        size_t begin = std::min(rows, tilesTotal * p / partitions * tileRows);
+        size_t end = std::min(rows, tilesTotal * (p + 1) / partitions * tileRows);
+        accumulatePairs(data, means, begin, end, partials[p]);
+    });
+
+    CorrelationMatrix matrix;
+    matrix.columns = columns;
+    matrix.values.assign(k * k, std::numeric_limits<double>::quiet_NaN());
+    matrix.counts.assign(k * k, 0);
+    for (size_t i = 0; i < k; ++i) {
+        for (size_t j = i; j < k; ++j) {
+            PairSums total = PairSums();
+            for (const auto& partial : partials) {
+                const PairSums& pair = partial[i * k + j];
+                total.count += pair.count;
+                total.sumX += pair.sumX;
+                total.sumY += pair.sumY;
+                total.sumXX += pair.sumXX;
+                total.sumYY += pair.sumYY;
+                total.sumXY += pair.sumXY;
+            }
+            double n = total.count;
+            double covariance = n * total.sumXY - total.sumX * total.sumY;
+            double varianceX = n * total.sumXX - total.sumX * total.sumX;
+            double varianceY = n * total.sumYY - total.sumY * total.sumY;
+            double r = std::numeric_limits<double>::quiet_NaN();
+            if (n >= 2 && varianceX > 0 && varianceY > 0) {
+                r = std::max(-1.0, std::min(1.0, covariance / std::sqrt(varianceX * varianceY)));
+            }
+            matrix.values[i * k + j] = matrix.values[j * k + i] = r;
+            matrix.counts[i * k + j] = matrix.counts[j * k + i] = static_cast<size_t>(n);
+        }
+    }
+    return matrix;
+}
+
+// Welford add/remove over the window, so each row costs O(1) whatever the window length.
+
+RollingStats rollingStats(const std::vector<double>& values, size_t window) {
+    if (window == 0) {
+        throw std::runtime_error("Rolling window must hold at least one row.");
+    }
+    const double missing = std::numeric_limits<double>::quiet_NaN();
+    RollingStats stats;
+    stats.mean.resize(values.size());
+    stats.stddev.resize(values.size());
+
+    size_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        double value = values[i];
+        if (!std::isnan(value)) {
+            ++count;
+            double delta = value - mean;
+            mean += delta / count;
+            m2 += delta * (value - mean);
+        }
+        if (i >= window && !std::isnan(values[i - window])) {
+            double old = values[i - window];
+            if (count == 1) {
+                count = 0;
+                mean = m2 = 0.0;
+            } else {
+                double previousMean = mean - (old - mean) / (count - 1);
+                m2 -= (old - previousMean) * (old - mean);
+                mean = previousMean;
+                --count;
+                // Removal cancels rather than reaching zero: a single reading has no spread
+                if (count == 1) {
+                    m2 = 0.0;
+                }
+            }
+        }
+        if (count == 0) {
+            stats.mean[i] = stats.stddev[i] = missing;
+        } else {
+            stats.mean[i] = mean;
+            stats.stddev[i] = std::sqrt(std::max(0.0, m2 / count));
+        }
+    }
+    return stats;
+}
+
+std::vector<RollingStats> rollingStatsAll(const WeatherData& weatherData, const std::vector<std::string>& columns, size_t window) {
+    PROFILE_SCOPE("rolling stats");
+    std::vector<const std::vector<double>*> data = lookupColumns(weatherData, columns);
+    std::vector<RollingStats> stats(columns.size());
+    parallelFor(columns.size(), [&](size_t c) {
+        stats[c] = rollingStats(*data[c], window);
+    });
+    return stats;
+}
+
+// A row is scored against the window ending at the row before it, so a spike does not dilute its own score.
+
+std::vector<Anomaly> findAnomalies(const WeatherData& weatherData, const std::vector<std::string>& columns,
+                                   size_t window, double threshold) {
+    std::vector<const std::vector<double>*> data = lookupColumns(weatherData, columns);
+    const std::vector<long long>& timestamps = weatherData.timestamps();
+    std::vector<std::vector<Anomaly>> found(columns.size());
+
+    parallelFor(columns.size(), [&](size_t c) {
+        const std::vector<double>& values = *data[c];
+        RollingStats stats = rollingStats(values, window);
+        for (size_t i = 1; i < values.size(); ++i) {
+            double sigma = stats.stddev[i - 1];
+            if (std::isnan(values[i]) || std::isnan(sigma) || sigma <= 0.0) {
+                continue;
+            }
+            double z = (values[i] - stats.mean[i - 1]) / sigma;
+            if (std::fabs(z) >= threshold) {
+                Anomaly anomaly = {c, i, timestamps[i], values[i], z};
+                found[c].push_back(anomaly);
+            }
+        }
+    });
+
+    std::vector<Anomaly> anomalies;
+    for (const auto& column : found) {
+        anomalies.insert(anomalies.end(), column.begin(), column.end());
+    }
+    std::sort(anomalies.begin(), anomalies.end(), [](const Anomaly& a, const Anomaly& b) {
+        return a.row != b.row ? a.row < b.row : a.column < b.column;
+    });
+    return anomalies;
+}
@@ -0,0 +1,48 @@
+// CrossCountryStats.h
+#pragma once
+#include "WeatherData.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// Pearson correlations between every pair of columns, each over the rows where both have a reading.
+struct CorrelationMatrix {
+    std::vector<std::string> columns;
+    std::vector<double> values;   // columns.size() squared, row-major; NaN where a pair has no spread
+    std::vector<size_t> counts;   // Rows both columns have readings for, same layout
+
+    double at(size_t i, size_t j) const { return values[i * columns.size() + j]; }
+    size_t countAt(size_t i, size_t j) const { return counts[i * columns.size() + j]; }
+};
+
+// Computes the full matrix in one pass over the rows: row tiles small enough to stay in cache are
+// centered once, then every pair's sums are vector dot products over the tile. Tiles are spread over
+// worker threads in a fixed partition, so the result does not depend on the thread count.
+CorrelationMatrix correlationMatrix(const WeatherData& weatherData, const std::vector<std::string>& columns);
+
+// Mean and population standard deviation of the readings in the trailing window of rows ending at each
+// row (NaN while the window holds no reading). Missing readings are skipped, not counted.
+struct RollingStats {
+    std::vector<double> mean;
+    std::vector<double> stddev;
+};
+
+// Rolling statistics of one column over a window of `window` rows, in O(rows).
+RollingStats rollingStats(const std::vector<double>& values, size_t window);
+
+// Rolling statistics of every column, computed in parallel.
+std::vector<RollingStats> rollingStatsAll(const WeatherData& weatherData, const std::vector<std::string>& columns, size_t window);
+
+// A reading that lies far from the rows before it.
+struct Anomaly {
+    size_t column;        // Index into the column list
+    size_t row;
+    long long timestamp;
+    double value;
+    double zScore;        // Distance from the preceding window's mean in its standard deviations
+};
+
+// Readings whose z-score against the preceding `window` rows is at least `threshold` in magnitude,
+// in row order (then column). Windows with fewer than two readings or no spread are skipped.
+std::vector<Anomaly> findAnomalies(const WeatherData& weatherData, const std::vector<std::string>& columns,
+                                   size_t window, double threshold);
@@ -0,0 +1,35 @@
+// DataFilter.cpp
+#include "DataFilter.h"
+#include "Profiler.h"
+#include <algorithm>
+
+//  Filters candlesticks based on a year range.
+
+ArenaVector<Candlestick> filterByYearRange(CandlestickRange candlesticks, int startYear, int endYear, Arena* arena) {
+    PROFILE_SCOPE("filter year range");
+    ArenaVector<Candlestick> filtered{ArenaAllocator<Candlestick>(arena)};
+    for (const auto& candle : candlesticks) {
+        int year = std::stoi(candle.date);
+        if (year >= startYear && year <= endYear) {
+            filtered.push_back(candle);
+        }
+    }
+    PROFILE_COUNT("candles filtered", candlesticks.size());
+    PROFILE_COUNT("candles kept", filtered.size());
+    return filtered;
+}
+
+// Filters candlesticks based on a closing temperature range.
+
+ArenaVector<Candlestick> filterByClosingTemperatureRange(CandlestickRange candlesticks, double minTemp, double maxTemp, Arena* arena) {
+    PROFILE_SCOPE("filter close range");
+    ArenaVector<Candlestick> filtered{ArenaAllocator<Candlestick>(arena)};
+    for (const auto& candle : candlesticks) {
+        if (candle.close >= minTemp && candle.close <= maxTemp) {
+            filtered.push_back(candle);
+        }
+    }
+    PROFILE_COUNT("candles filtered", candlesticks.size());
+    PROFILE_COUNT("candles kept", filtered.size());
+    return filtered;
+}
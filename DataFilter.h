@@ -1,11 +1,15 @@
 // DataFilter.h
 #pragma once
 #include "Candlestick.h"
+#include "CandlestickRange.h"
+#include "Arena.h"
 #include <vector>
 #include <string>
 
+// Both filters copy the kept candlesticks into arena when one is given, and onto the heap otherwise.
+
 // Filtering by the range of the year from 1980 to 2019
-std::vector<Candlestick> filterByYearRange(const std::vector<Candlestick>& candlesticks, int startYear, int endYear);
+ArenaVector<Candlestick> filterByYearRange(CandlestickRange candlesticks, int startYear, int endYear, Arena* arena = nullptr);
 
 // Filtering by the opening and closing temperature
-std::vector<Candlestick> filterByClosingTemperatureRange(const std::vector<Candlestick>& candlesticks, double minTemp, double maxTemp);
\ No newline at end of file
+ArenaVector<Candlestick> filterByClosingTemperatureRange(CandlestickRange candlesticks, double minTemp, double maxTemp, Arena* arena = nullptr);
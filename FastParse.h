@@ -0,0 +1,133 @@
+// FastParse.h
+#pragma once
+#include "Timestamp.h"
+#include <cstdlib>
+#include <cstring>
+
+// Allocation-free parsers for CSV fields, working on [begin, end) character ranges.
+
+// Parses a decimal number (optional sign, fraction and exponent) in the style of std::from_chars.
+// Returns the position after the number, or begin if no number was found.
+inline const char* parseDouble(const char* begin, const char* end, double& out) {
+    static const double powersOf10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* p = begin;
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    unsigned long long mantissa = 0;
+    int digits = 0;      // Significant digits kept in mantissa
+    int exponent = 0;    // Decimal exponent applied to mantissa
+    bool sawDigit = false;
+
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+        sawDigit = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+            if (mantissa) ++digits;
+        } else {
+            ++exponent; // Digit dropped beyond 19 significant ones
+        }
+    }
+    if (p != end && *p == '.') {
+        ++p;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+            sawDigit = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+                if (mantissa) ++digits;
+                --exponent;
+            }
+        }
+    }
+    if (!sawDigit) {
+        return begin;
+    }
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (q != end && (*q == '-' || *q == '+')) {
+            negativeExponent = *q == '-';
+            ++q;
+        }
+        if (q != end && *q >= '0' && *q <= '9') {
+            int value = 0;
+            for (; q != end && *q >= '0' && *q <= '9'; ++q) {
+                if (value < 10000) value = value * 10 + (*q - '0');
+            }
+            exponent += negativeExponent ? -value : value;
+            p = q;
+        }
+    }
+
+    // Fast path: mantissa and power of ten are both exact doubles, so one operation rounds correctly
+    if (mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double value = static_cast<double>(mantissa);
+        value = exponent < 0 ? value / powersOf10[-exponent] : value * powersOf10[exponent];
+        out = negative ? -value : value;
+        return p;
+    }
+
+    // Rare long or extreme inputs fall back to the C library on a bounded local copy
+    char buffer[128];
+    size_t length = static_cast<size_t>(p - begin);
+    if (length >= sizeof(buffer)) {
+        return begin;
+    }
+    std::memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+    out = std::strtod(buffer, nullptr);
+    return p;
+}
+
+// Parses exactly `count` decimal digits at p; out is left untouched on failure.
+inline bool parseFixedDigits(const char* p, const char* end, int count, unsigned& out) {
+    if (end - p < count) {
+        return false;
+    }
+    unsigned value = 0;
+    for (int i = 0; i < count; ++i) {
+        if (p[i] < '0' || p[i] > '9') return false;
+        value = value * 10 + static_cast<unsigned>(p[i] - '0');
+    }
+    out = value;
+    return true;
+}
+
+// Parses an ISO 8601 UTC timestamp such as "1980-01-01T00:00:00Z" into seconds since the epoch.
+// Trailing fields may be omitted ("1980", "1980-01-01"); a time zone suffix is ignored.
+inline bool parseTimestamp(const char* begin, const char* end, long long& out) {
+    unsigned year, month = 1, day = 1, hour = 0, minute = 0, second = 0;
+    const char* p = begin;
+    if (!parseFixedDigits(p, end, 4, year)) {
+        return false;
+    }
+    p += 4;
+    if (p != end && *p == '-' && parseFixedDigits(p + 1, end, 2, month)) {
+        p += 3;
+        if (p != end && *p == '-' && parseFixedDigits(p + 1, end, 2, day)) {
+            p += 3;
+            if (p != end && (*p == 'T' || *p == ' ') && parseFixedDigits(p + 1, end, 2, hour)) {
+                p += 3;
+                if (p != end && *p == ':' && parseFixedDigits(p + 1, end, 2, minute)) {
+                    p += 3;
+                    if (p != end && *p == ':') {
+                        parseFixedDigits(p + 1, end, 2, second);
+                    }
+                }
+            }
+        }
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    out = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    return true;
+}
@@ -0,0 +1,294 @@
+// Forecaster.cpp
+#include "Forecaster.h"
+#include "FastParse.h"
+#include "Kernels.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+const double twoPi = 6.283185307179586;
+
+// Least-squares projection shared by every series of one length: coefficients = rows . y.
+struct Projection {
+    size_t terms;
+    std::vector<std::vector<double>> rows; // terms x length
+};
+
+// Trend term rescaled to about [-1, 1] so the normal equations stay well conditioned.
+double scaledTrend(double t, size_t length) {
+    double half = std::max(1.0, length / 2.0);
+    return (t - (length - 1) / 2.0) / half;
+}
+
+// Sine/cosine pairs that stay below the Nyquist limit of the season.
+size_t usableHarmonics(const ForecastOptions& options, double season) {
+    if (options.model != ForecastModel::Harmonic || season < 2.0) {
+        return 0;
+    }
+    size_t limit = static_cast<size_t>(std::ceil(season / 2.0)) - 1;
+    return std::min(options.harmonics, limit);
+}
+
+// Design row for bucket t: [1, trend, sin(2 pi k t / s), cos(2 pi k t / s) ...].
+void designRow(double t, size_t length, double season, size_t harmonics, std::vector<double>& row) {
+    row.clear();
+    row.push_back(1.0);
+    row.push_back(scaledTrend(t, length));
+    for (size_t k = 1; k <= harmonics; ++k) {
+        double angle = twoPi * k * t / season;
+        row.push_back(std::sin(angle));
+        row.push_back(std::cos(angle));
+    }
+}
+
+// Builds (X^T X)^-1 X^T through a Cholesky factorization of the normal matrix.
+Projection buildProjection(size_t length, double season, size_t harmonics) {
+    size_t p = 2 + 2 * harmonics;
+    if (length < p) {
+        throw std::runtime_error("Not enough data to fit the forecast model.");
+    }
+
+    std::vector<double> row;
+    std::vector<double> normal(p * p, 0.0);
+    for (size_t t = 0; t < length; ++t) {
+        designRow(static_cast<double>(t), length, season, harmonics, row);
+        for (size_t i = 0; i < p; ++i) {
+            for (size_t j = 0; j <= i; ++j) {
+                normal[i * p + j] += row[i] * row[j];
+            }
+        }
+    }
+
+    // In-place Cholesky: lower triangle of normal becomes L with normal = L L^T
+    for (size_t j = 0; j < p; ++j) {
+        double diagonal = normal[j * p + j];
+        for (size_t k = 0; k < j; ++k) {
+            diagonal -= normal[j * p + k] * normal[j * p + k];
+        }
+        if (diagonal <= 1e-12 * length) {
+            throw std::runtime_error("Forecast design matrix is singular.");
+        }
+        normal[j * p + j] = std::sqrt(diagonal);
+        for (size_t i = j + 1; i < p; ++i) {
+            double value = normal[i * p + j];
+            for (size_t k = 0; k < j; ++k) {
+                value -= normal[i * p + k] * normal[j * p + k];
+            }
+            normal[i * p + j] = value / normal[j * p + j];
+        }
+    }
+
+    Projection projection;
+    projection.terms = p;
+    projection.rows.assign(p, std::vector<double>(length));
+    std::vector<double> z(p);
+    for (size_t t = 0; t < length; ++t) {
+        designRow(static_cast<double>(t), length, season, harmonics, row);
+        // Solve L L^T z = row
+        for (size_t i = 0; i < p; ++i) {
+            double value = row[i];
+            for (size_t k = 0; k < i; ++k) value -= normal[i * p + k] * z[k];
+            z[i] = value / normal[i * p + i];
+        }
+        for (size_t i = p; i-- > 0;) {
+            double value = z[i];
+            for (size_t k = i + 1; k < p; ++k) value -= normal[k * p + i] * z[k];
+            z[i] = value / normal[i * p + i];
+        }
+        for (size_t i = 0; i < p; ++i) {
+            projection.rows[i][t] = z[i];
+        }
+    }
+    return projection;
+}
+
+// Predicted means for buckets length-1+h of one series under the least-squares models.
+std::vector<double> leastSquaresForecast(const std::vector<double>& closes, const Projection& projection, double season,
+                                         size_t harmonics, const std::vector<size_t>& horizons) {
+    size_t length = closes.size();
+    std::vector<double> coefficients(projection.terms);
+    for (size_t i = 0; i < projection.terms; ++i) {
+        coefficients[i] = simdDot(projection.rows[i].data(), closes.data(), length);
+    }
+
+    std::vector<double> forecasts, row;
+    for (size_t h : horizons) {
+        designRow(static_cast<double>(length - 1 + h), length, season, harmonics, row);
+        double value = 0.0;
+        for (size_t i = 0; i < row.size(); ++i) value += coefficients[i] * row[i];
+        forecasts.push_back(value);
+    }
+    return forecasts;
+}
+
+// Additive Holt-Winters; degrades to Holt's linear method without a usable season.
+std::vector<double> holtWintersForecast(const std::vector<double>& closes, const ForecastOptions& options, double season,
+                                        const std::vector<size_t>& horizons) {
+    size_t length = closes.size();
+    size_t s = static_cast<size_t>(std::lround(season));
+    if (s < 2 || length < 2 * s) {
+        s = 0;
+    }
+
+    double level, trend;
+    std::vector<double> seasonal(s, 0.0);
+    size_t first;
+    if (s) {
+        double firstMean = 0.0, secondMean = 0.0;
+        for (size_t i = 0; i < s; ++i) {
+            firstMean += closes[i];
+            secondMean += closes[s + i];
+        }
+        firstMean /= s;
+        secondMean /= s;
+        level = firstMean;
+        trend = (secondMean - firstMean) / s;
+        for (size_t i = 0; i < s; ++i) {
+            seasonal[i] = closes[i] - firstMean;
+        }
+        first = s;
+    } else {
+        level = closes[0];
+        trend = length > 1 ? closes[1] - closes[0] : 0.0;
+        first = 1;
+    }
+
+    for (size_t t = first; t < length; ++t) {
+        double seasonTerm = s ? seasonal[t % s] : 0.0;
+        double previousLevel = level;
+        level = options.alpha * (closes[t] - seasonTerm) + (1.0 - options.alpha) * (level + trend);
+        trend = options.beta * (level - previousLevel) + (1.0 - options.beta) * trend;
+        if (s) {
+            seasonal[t % s] = options.gamma * (closes[t] - level) + (1.0 - options.gamma) * seasonal[t % s];
+        }
+    }
+
+    std::vector<double> forecasts;
+    for (size_t h : horizons) {
+        forecasts.push_back(level + h * trend + (s ? seasonal[(length - 1 + h) % s] : 0.0));
+    }
+    return forecasts;
+}
+
+} // namespace
+
+const char* forecastModelName(ForecastModel model) {
+    switch (model) {
+        case ForecastModel::Linear: return "linear";
+        case ForecastModel::Harmonic: return "harmonic";
+        case ForecastModel::HoltWinters: return "holt-winters";
+    }
+    return "linear";
+}
+
+bool parseForecastModel(const std::string& name, ForecastModel& model) {
+    static const ForecastModel models[] = {ForecastModel::Linear, ForecastModel::Harmonic, ForecastModel::HoltWinters};
+    for (ForecastModel candidate : models) {
+        if (name == forecastModelName(candidate)) {
+            model = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+double defaultSeasonLength(BucketSize size) {
+    switch (size) {
+        case BucketSize::Hour: return 24.0;
+        case BucketSize::Day: return 365.25;
+        case BucketSize::Week: return 365.25 / 7.0;
+        case BucketSize::Month: return 12.0;
+        case BucketSize::Year: return 0.0;
+    }
+    return 0.0;
+}
+
+std::vector<ForecastResult> forecastAll(const std::vector<ForecastSeries>& series, const std::vector<size_t>& horizons,
+                                        const ForecastOptions& options) {
+    double season = options.seasonLength > 0.0 ? options.seasonLength : defaultSeasonLength(options.bucketSize);
+    size_t harmonics = usableHarmonics(options, season);
+
+    // One projection per distinct series length, built before the parallel fits
+    std::map<size_t, Projection> projections;
+    for (const auto& s : series) {
+        if (!s.candlesticks || s.candlesticks->empty()) {
+            throw std::runtime_error("No data available for prediction: " + s.name);
+        }
+        if (options.model != ForecastModel::HoltWinters && projections.find(s.candlesticks->size()) == projections.end()) {
+            projections[s.candlesticks->size()] = buildProjection(s.candlesticks->size(), season, harmonics);
+        }
+    }
+
+    std::vector<size_t> sortedHorizons(horizons);
+    std::sort(sortedHorizons.begin(), sortedHorizons.end());
+    sortedHorizons.erase(std::unique(sortedHorizons.begin(), sortedHorizons.end()), sortedHorizons.end());
+    if (!sortedHorizons.empty() && sortedHorizons.front() == 0) {
+        throw std::runtime_error("Forecast horizons start at 1.");
+    }
+
+    std::vector<ForecastResult> results(series.size());
+    parallelFor(series.size(), [&](size_t index) {
+        const std::vector<Candlestick>& candles = *series[index].candlesticks;
+        size_t length = candles.size();
+
+        std::vector<double> closes(length);
+        for (size_t t = 0; t < length; ++t) {
+            closes[t] = candles[t].close;
+        }
+
+        // Every bucket up to the furthest horizon, so open can chain from the previous forecast
+        std::vector<size_t> steps;
+        for (size_t h = 1; !sortedHorizons.empty() && h <= sortedHorizons.back(); ++h) {
+            steps.push_back(h);
+        }
+        std::vector<double> means = options.model == ForecastModel::HoltWinters
+            ? holtWintersForecast(closes, options, season, steps)
+            : leastSquaresForecast(closes, projections.find(length)->second, season, harmonics, steps);
+
+        // Average distance of high and low from the close, per season slot
+        size_t slots = season >= 2.0 ? static_cast<size_t>(std::ceil(season)) : 1;
+        std::vector<double> highOffset(slots, 0.0), lowOffset(slots, 0.0);
+        std::vector<size_t> slotCount(slots, 0);
+        for (size_t t = 0; t < length; ++t) {
+            size_t slot = slots > 1 ? static_cast<size_t>(std::fmod(static_cast<double>(t), season)) % slots : 0;
+            highOffset[slot] += candles[t].high - candles[t].close;
+            lowOffset[slot] += candles[t].low - candles[t].close;
+            ++slotCount[slot];
+        }
+        for (size_t slot = 0; slot < slots; ++slot) {
+            if (slotCount[slot]) {
+                highOffset[slot] /= slotCount[slot];
+                lowOffset[slot] /= slotCount[slot];
+            }
+        }
+
+        long long start;
+        const std::string& lastLabel = candles.back().date;
+        if (!parseTimestamp(lastLabel.c_str(), lastLabel.c_str() + lastLabel.size(), start)) {
+            throw std::runtime_error("Invalid date in candlestick: " + lastLabel);
+        }
+        start = bucketStart(start, options.bucketSize);
+
+        ForecastResult& result = results[index];
+        result.name = series[index].name;
+        size_t next = 0;
+        double previousClose = candles.back().close;
+        for (size_t h = 1; h <= steps.size(); ++h) {
+            start = nextBucketStart(start, options.bucketSize);
+            double close = means[h - 1];
+            if (next < sortedHorizons.size() && sortedHorizons[next] == h) {
+                size_t t = length - 1 + h;
+                size_t slot = slots > 1 ? static_cast<size_t>(std::fmod(static_cast<double>(t), season)) % slots : 0;
+                result.forecasts.emplace_back(bucketLabel(start, options.bucketSize), previousClose, close,
+                                              close + highOffset[slot], close + lowOffset[slot]);
+                ++next;
+            }
+            previousClose = close;
+        }
+    });
+    return results;
+}
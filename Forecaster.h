@@ -0,0 +1,57 @@
+// Forecaster.h
+#pragma once
+#include "Candlestick.h"
+#include "BucketAggregator.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// Model fitted to each series by forecastAll.
+enum class ForecastModel {
+    Linear,      // Least-squares straight line through the bucket means
+    Harmonic,    // Line plus sine/cosine terms of the seasonal period, by least squares
+    HoltWinters  // Additive triple exponential smoothing
+};
+
+// Printable name of a model ("linear", "harmonic", "holt-winters").
+const char* forecastModelName(ForecastModel model);
+
+// Parses a model name, returning false if it is not recognised.
+bool parseForecastModel(const std::string& name, ForecastModel& model);
+
+// Settings shared by every series in a batch.
+struct ForecastOptions {
+    ForecastModel model;
+    BucketSize bucketSize;   // Granularity of the input candlesticks and of the forecasts
+    double seasonLength;     // Buckets per season; 0 picks a default for the bucket size
+    size_t harmonics;        // Sine/cosine pairs for the harmonic model
+    double alpha;            // Holt-Winters level smoothing
+    double beta;             // Holt-Winters trend smoothing
+    double gamma;            // Holt-Winters seasonal smoothing
+
+    ForecastOptions()
+        : model(ForecastModel::Linear), bucketSize(BucketSize::Year), seasonLength(0.0), harmonics(2),
+          alpha(0.3), beta(0.05), gamma(0.2) {}
+};
+
+// One series to forecast: consecutive candlesticks of options.bucketSize, oldest first.
+struct ForecastSeries {
+    std::string name;
+    const std::vector<Candlestick>* candlesticks;
+};
+
+// Forecasts of one series, one candlestick per requested horizon.
+struct ForecastResult {
+    std::string name;
+    std::vector<Candlestick> forecasts;
+};
+
+// Default season length of a bucket size: 24 hours, 365.25 days, 52.18 weeks, 12 months, none for years.
+double defaultSeasonLength(BucketSize size);
+
+// Fits every series in parallel and forecasts each horizon (in buckets after the last candlestick).
+// Least-squares models share one projection matrix per series length, so the design matrix is built
+// and factorized once for all countries. Forecast candles chain open = previous close, and their
+// high/low keep the average distance of historical highs/lows from the close in the same season slot.
+std::vector<ForecastResult> forecastAll(const std::vector<ForecastSeries>& series, const std::vector<size_t>& horizons,
+                                        const ForecastOptions& options);
@@ -0,0 +1,409 @@
+// Kernels.cpp
+#include "Kernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define WEATHER_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const double positiveInfinity = std::numeric_limits<double>::infinity();
+const double negativeInfinity = -std::numeric_limits<double>::infinity();
+
+// One implementation of every kernel for a given instruction set.
+struct KernelTable {
+    SimdLevel level;
+    double (*min)(const double*, size_t);
+    double (*max)(const double*, size_t);
+    double (*sum)(const double*, size_t);
+    double (*dot)(const double*, const double*, size_t);
+    double (*sumSquaredDeviations)(const double*, size_t, double);
+    double (*maskedMin)(const double*, const unsigned char*, size_t);
+    double (*maskedMax)(const double*, const unsigned char*, size_t);
+    double (*maskedSum)(const double*, const unsigned char*, size_t);
+};
+
+// Scalar fallbacks, also used for the tails of the vector loops.
+
+double scalarMin(const double* values, size_t count) {
+    double result = positiveInfinity;
+    for (size_t i = 0; i < count; ++i) result = std::min(result, values[i]);
+    return result;
+}
+
+double scalarMax(const double* values, size_t count) {
+    double result = negativeInfinity;
+    for (size_t i = 0; i < count; ++i) result = std::max(result, values[i]);
+    return result;
+}
+
+double scalarSum(const double* values, size_t count) {
+    double result = 0.0;
+    for (size_t i = 0; i < count; ++i) result += values[i];
+    return result;
+}
+
+double scalarDot(const double* a, const double* b, size_t count) {
+    double result = 0.0;
+    for (size_t i = 0; i < count; ++i) result += a[i] * b[i];
+    return result;
+}
+
+double scalarSumSquaredDeviations(const double* values, size_t count, double center) {
+    double result = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        double d = values[i] - center;
+        result += d * d;
+    }
+    return result;
+}
+
+double scalarMaskedMin(const double* values, const unsigned char* mask, size_t count) {
+    double result = positiveInfinity;
+    for (size_t i = 0; i < count; ++i) if (mask[i]) result = std::min(result, values[i]);
+    return result;
+}
+
+double scalarMaskedMax(const double* values, const unsigned char* mask, size_t count) {
+    double result = negativeInfinity;
+    for (size_t i = 0; i < count; ++i) if (mask[i]) result = std::max(result, values[i]);
+    return result;
+}
+
+double scalarMaskedSum(const double* values, const unsigned char* mask, size_t count) {
+    double result = 0.0;
+    for (size_t i = 0; i < count; ++i) if (mask[i]) result += values[i];
+    return result;
+}
+
+const KernelTable scalarKernels = {
+    SimdLevel::Scalar, scalarMin, scalarMax, scalarSum, scalarDot, scalarSumSquaredDeviations,
+    scalarMaskedMin, scalarMaskedMax, scalarMaskedSum
+};
+
+#ifdef WEATHER_SIMD_X86
+
+// AVX2: four doubles per register, two independent accumulators per loop to hide latency.
+
+__attribute__((target("avx2"))) double horizontalMin(__m256d v) {
+    double lanes[4];
+    _mm256_storeu_pd(lanes, v);
+    return std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+}
+
+__attribute__((target("avx2"))) double horizontalMax(__m256d v) {
+    double lanes[4];
+    _mm256_storeu_pd(lanes, v);
+    return std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+}
+
+__attribute__((target("avx2"))) double horizontalSum(__m256d v) {
+    double lanes[4];
+    _mm256_storeu_pd(lanes, v);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+// Lanes whose mask byte is zero, widened from four mask bytes.
+__attribute__((target("avx2"))) __m256d avx2DroppedLanes(const unsigned char* mask) {
+    int bytes;
+    std::memcpy(&bytes, mask, 4);
+    __m256i wide = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(bytes));
+    return _mm256_castsi256_pd(_mm256_cmpeq_epi64(wide, _mm256_setzero_si256()));
+}
+
+__attribute__((target("avx2"))) double avx2Min(const double* values, size_t count) {
+    __m256d a = _mm256_set1_pd(positiveInfinity), b = a;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        a = _mm256_min_pd(a, _mm256_loadu_pd(values + i));
+        b = _mm256_min_pd(b, _mm256_loadu_pd(values + i + 4));
+    }
+    return std::min(horizontalMin(_mm256_min_pd(a, b)), scalarMin(values + i, count - i));
+}
+
+__attribute__((target("avx2"))) double avx2Max(const double* values, size_t count) {
+    __m256d a = _mm256_set1_pd(negativeInfinity), b = a;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        a = _mm256_max_pd(a, _mm256_loadu_pd(values + i));
+        b = _mm256_max_pd(b, _mm256_loadu_pd(values + i + 4));
+    }
+    return std::max(horizontalMax(_mm256_max_pd(a, b)), scalarMax(values + i, count - i));
+}
+
+__attribute__((target("avx2"))) double avx2Sum(const double* values, size_t count) {
+    __m256d a = _mm256_setzero_pd(), b = a;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        a = _mm256_add_pd(a, _mm256_loadu_pd(values + i));
+        b = _mm256_add_pd(b, _mm256_loadu_pd(values + i + 4));
+    }
+    return horizontalSum(_mm256_add_pd(a, b)) + scalarSum(values + i, count - i);
+}
+
+__attribute__((target("avx2,fma"))) double avx2Dot(const double* x, const double* y, size_t count) {
+    __m256d a = _mm256_setzero_pd(), b = a;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        a = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), a);
+        b = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), b);
+    }
+    return horizontalSum(_mm256_add_pd(a, b)) + scalarDot(x + i, y + i, count - i);
+}
+
+__attribute__((target("avx2,fma"))) double avx2SumSquaredDeviations(const double* values, size_t count, double center) {
+    const __m256d c = _mm256_set1_pd(center);
+    __m256d a = _mm256_setzero_pd(), b = a;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(values + i), c);
+        __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(values + i + 4), c);
+        a = _mm256_fmadd_pd(d0, d0, a);
+        b = _mm256_fmadd_pd(d1, d1, b);
+    }
+    return horizontalSum(_mm256_add_pd(a, b)) + scalarSumSquaredDeviations(values + i, count - i, center);
+}
+
+__attribute__((target("avx2"))) double avx2MaskedMin(const double* values, const unsigned char* mask, size_t count) {
+    const __m256d fill = _mm256_set1_pd(positiveInfinity);
+    __m256d a = fill;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        a = _mm256_min_pd(a, _mm256_blendv_pd(_mm256_loadu_pd(values + i), fill, avx2DroppedLanes(mask + i)));
+    }
+    return std::min(horizontalMin(a), scalarMaskedMin(values + i, mask + i, count - i));
+}
+
+__attribute__((target("avx2"))) double avx2MaskedMax(const double* values, const unsigned char* mask, size_t count) {
+    const __m256d fill = _mm256_set1_pd(negativeInfinity);
+    __m256d a = fill;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        a = _mm256_max_pd(a, _mm256_blendv_pd(_mm256_loadu_pd(values + i), fill, avx2DroppedLanes(mask + i)));
+    }
+    return std::max(horizontalMax(a), scalarMaskedMax(values + i, mask + i, count - i));
+}
+
+__attribute__((target("avx2"))) double avx2MaskedSum(const double* values, const unsigned char* mask, size_t count) {
+    const __m256d fill = _mm256_setzero_pd();
+    __m256d a = fill;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        a = _mm256_add_pd(a, _mm256_blendv_pd(_mm256_loadu_pd(values + i), fill, avx2DroppedLanes(mask + i)));
+    }
+    return horizontalSum(a) + scalarMaskedSum(values + i, mask + i, count - i);
+}
+
+const KernelTable avx2Kernels = {
+    SimdLevel::Avx2, avx2Min, avx2Max, avx2Sum, avx2Dot, avx2SumSquaredDeviations,
+    avx2MaskedMin, avx2MaskedMax, avx2MaskedSum
+};
+
+// AVX-512: eight doubles per register; masks map directly onto k-registers.
+// GCC's AVX-512 headers seed results with _mm512_undefined_*(), which -Wmaybe-uninitialized flags.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// Horizontal reductions through memory; GCC's _mm512_reduce_* helpers trip -Wuninitialized.
+__attribute__((target("avx512f"))) double horizontalMin512(__m512d v) {
+    double lanes[8];
+    _mm512_storeu_pd(lanes, v);
+    return scalarMin(lanes, 8);
+}
+
+__attribute__((target("avx512f"))) double horizontalMax512(__m512d v) {
+    double lanes[8];
+    _mm512_storeu_pd(lanes, v);
+    return scalarMax(lanes, 8);
+}
+
+__attribute__((target("avx512f"))) double horizontalSum512(__m512d v) {
+    double lanes[8];
+    _mm512_storeu_pd(lanes, v);
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+// Lanes whose mask byte is non-zero, from eight mask bytes.
+__attribute__((target("avx512f"))) __mmask8 avx512KeptLanes(const unsigned char* mask) {
+    __m512i wide = _mm512_cvtepu8_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask)));
+    return _mm512_test_epi64_mask(wide, wide);
+}
+
+__attribute__((target("avx512f"))) double avx512Min(const double* values, size_t count) {
+    __m512d a = _mm512_set1_pd(positiveInfinity), b = a;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        a = _mm512_min_pd(a, _mm512_loadu_pd(values + i));
+        b = _mm512_min_pd(b, _mm512_loadu_pd(values + i + 8));
+    }
+    return std::min(horizontalMin512(_mm512_min_pd(a, b)), scalarMin(values + i, count - i));
+}
+
+__attribute__((target("avx512f"))) double avx512Max(const double* values, size_t count) {
+    __m512d a = _mm512_set1_pd(negativeInfinity), b = a;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        a = _mm512_max_pd(a, _mm512_loadu_pd(values + i));
+        b = _mm512_max_pd(b, _mm512_loadu_pd(values + i + 8));
+    }
+    return std::max(horizontalMax512(_mm512_max_pd(a, b)), scalarMax(values + i, count - i));
+}
+
+__attribute__((target("avx512f"))) double avx512Sum(const double* values, size_t count) {
+    __m512d a = _mm512_setzero_pd(), b = a;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        a = _mm512_add_pd(a, _mm512_loadu_pd(values + i));
+        b = _mm512_add_pd(b, _mm512_loadu_pd(values + i + 8));
+    }
+    return horizontalSum512(_mm512_add_pd(a, b)) + scalarSum(values + i, count - i);
+}
+
+__attribute__((target("avx512f"))) double avx512Dot(const double* x, const double* y, size_t count) {
+    __m512d a = _mm512_setzero_pd(), b = a;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        a = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), a);
+        b = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), b);
+    }
+    return horizontalSum512(_mm512_add_pd(a, b)) + scalarDot(x + i, y + i, count - i);
+}
+
+__attribute__((target("avx512f"))) double avx512SumSquaredDeviations(const double* values, size_t count, double center) {
+    const __m512d c = _mm512_set1_pd(center);
+    __m512d a = _mm512_setzero_pd(), b = a;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(values + i), c);
+        __m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(values + i + 8), c);
+        a = _mm512_fmadd_pd(d0, d0, a);
+        b = _mm512_fmadd_pd(d1, d1, b);
+    }
+    return horizontalSum512(_mm512_add_pd(a, b)) + scalarSumSquaredDeviations(values + i, count - i, center);
+}
+
+__attribute__((target("avx512f"))) double avx512MaskedMin(const double* values, const unsigned char* mask, size_t count) {
+    __m512d a = _mm512_set1_pd(positiveInfinity);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        a = _mm512_mask_min_pd(a, avx512KeptLanes(mask + i), a, _mm512_loadu_pd(values + i));
+    }
+    return std::min(horizontalMin512(a), scalarMaskedMin(values + i, mask + i, count - i));
+}
+
+__attribute__((target("avx512f"))) double avx512MaskedMax(const double* values, const unsigned char* mask, size_t count) {
+    __m512d a = _mm512_set1_pd(negativeInfinity);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        a = _mm512_mask_max_pd(a, avx512KeptLanes(mask + i), a, _mm512_loadu_pd(values + i));
+    }
+    return std::max(horizontalMax512(a), scalarMaskedMax(values + i, mask + i, count - i));
+}
+
+__attribute__((target("avx512f"))) double avx512MaskedSum(const double* values, const unsigned char* mask, size_t count) {
+    __m512d a = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        a = _mm512_mask_add_pd(a, avx512KeptLanes(mask + i), a, _mm512_loadu_pd(values + i));
+    }
+    return horizontalSum512(a) + scalarMaskedSum(values + i, mask + i, count - i);
+}
+
+const KernelTable avx512Kernels = {
+    SimdLevel::Avx512, avx512Min, avx512Max, avx512Sum, avx512Dot, avx512SumSquaredDeviations,
+    avx512MaskedMin, avx512MaskedMax, avx512MaskedSum
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+// Best table the CPU supports at or below the requested level.
+const KernelTable* kernelsFor(SimdLevel requested) {
+#ifdef WEATHER_SIMD_X86
+    __builtin_cpu_init();
+    if (requested == SimdLevel::Avx512 && __builtin_cpu_supports("avx512f")) {
+        return &avx512Kernels;
+    }
+    if (requested != SimdLevel::Scalar && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return &avx2Kernels;
+    }
+#else
+    (void)requested;
+#endif
+    return &scalarKernels;
+}
+
+std::atomic<const KernelTable*>& activeKernels() {
+    static std::atomic<const KernelTable*> table(kernelsFor(SimdLevel::Avx512));
+    return table;
+}
+
+const KernelTable& kernels() {
+    return *activeKernels().load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+SimdLevel simdLevel() {
+    return kernels().level;
+}
+
+void setSimdLevel(SimdLevel level) {
+    activeKernels().store(kernelsFor(level));
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Avx512: return "avx512";
+        case SimdLevel::Avx2: return "avx2";
+        case SimdLevel::Scalar: return "scalar";
+    }
+    return "scalar";
+}
+
+double simdMin(const double* values, size_t count) {
+    return kernels().min(values, count);
+}
+
+double simdMax(const double* values, size_t count) {
+    return kernels().max(values, count);
+}
+
+double simdSum(const double* values, size_t count) {
+    return kernels().sum(values, count);
+}
+
+double simdDot(const double* a, const double* b, size_t count) {
+    return kernels().dot(a, b, count);
+}
+
+double simdSumSquares(const double* values, size_t count) {
+    return kernels().dot(values, values, count);
+}
+
+double simdSumSquaredDeviations(const double* values, size_t count, double center) {
+    return kernels().sumSquaredDeviations(values, count, center);
+}
+
+double simdMaskedMin(const double* values, const unsigned char* mask, size_t count) {
+    return kernels().maskedMin(values, mask, count);
+}
+
+double simdMaskedMax(const double* values, const unsigned char* mask, size_t count) {
+    return kernels().maskedMax(values, mask, count);
+}
+
+double simdMaskedSum(const double* values, const unsigned char* mask, size_t count) {
+    return kernels().maskedSum(values, mask, count);
+}
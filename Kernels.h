@@ -0,0 +1,42 @@
+// Kernels.h
+#pragma once
+#include <cstddef>
+
+// Vectorized reductions over contiguous double arrays. The widest instruction set the CPU
+// supports (AVX-512, AVX2, or plain scalar code) is picked once at runtime.
+// Inputs are expected to be free of NaN; callers with missing readings use the masked variants.
+
+// Instruction set used by the kernels.
+enum class SimdLevel { Scalar, Avx2, Avx512 };
+
+// Level currently in use.
+SimdLevel simdLevel();
+
+// Forces a level (e.g. for benchmarking); levels the CPU lacks fall back to the best supported one.
+void setSimdLevel(SimdLevel level);
+
+// Printable name of a level ("scalar", "avx2", "avx512").
+const char* simdLevelName(SimdLevel level);
+
+// Smallest value (+infinity for an empty range).
+double simdMin(const double* values, size_t count);
+
+// Largest value (-infinity for an empty range).
+double simdMax(const double* values, size_t count);
+
+// Sum of the values.
+double simdSum(const double* values, size_t count);
+
+// Sum of a[i] * b[i].
+double simdDot(const double* a, const double* b, size_t count);
+
+// Sum of values[i] * values[i].
+double simdSumSquares(const double* values, size_t count);
+
+// Sum of (values[i] - center)^2, for two-pass variance.
+double simdSumSquaredDeviations(const double* values, size_t count, double center);
+
+// Masked variants consider only elements whose mask byte is non-zero.
+double simdMaskedMin(const double* values, const unsigned char* mask, size_t count);
+double simdMaskedMax(const double* values, const unsigned char* mask, size_t count);
+double simdMaskedSum(const double* values, const unsigned char* mask, size_t count);
@@ -0,0 +1,79 @@
+// LruCache.h
+#pragma once
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+// Thread-safe map holding at most `capacity` entries, evicting the least recently used one first.
+template <typename Key, typename Value>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) : capacity(capacity), hitCount(0), missCount(0) {}
+
+    // Copies the cached value into `value` and marks it most recently used; false on a miss.
+    bool lookup(const Key& key, Value& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            ++missCount;
+            return false;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        value = it->second->second;
+        ++hitCount;
+        return true;
+    }
+
+    // Inserts or replaces a value, evicting the oldest entry when full.
+    void insert(const Key& key, const Value& value) {
+        if (capacity == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = value;
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+        if (entries.size() >= capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        entries.emplace_front(key, value);
+        index[key] = entries.begin();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+        index.clear();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    size_t hits() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return hitCount;
+    }
+
+    size_t misses() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return missCount;
+    }
+
+private:
+    typedef std::list<std::pair<Key, Value>> EntryList;
+
+    size_t capacity;
+    EntryList entries; // Most recently used first
+    std::unordered_map<Key, typename EntryList::iterator> index;
+    size_t hitCount;
+    size_t missCount;
+    mutable std::mutex mutex;
+};
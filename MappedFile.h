@@ -0,0 +1,26 @@
+// MappedFile.h
+#pragma once
+#include <string>
+#include <cstddef>
+
+// MappedFile class that maps a whole file read-only into memory so it can be scanned without copying.
+class MappedFile {
+public:
+    // Constructor that opens and maps the file, throwing if it cannot be read.
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+    // Start of the mapped bytes (nullptr for an empty file).
+    const char* data() const;
+    // Number of mapped bytes.
+    size_t size() const;
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* bytes;
+    size_t length;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
@@ -0,0 +1,59 @@
+// Parallel.h
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of worker threads to use, never less than one.
+inline size_t workerCount() {
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware == 0 ? 1 : hardware;
+}
+
+// Runs body(i) for every i in [0, count) on a pool of worker threads and waits for all of them.
+// The first exception thrown by any task is rethrown on the calling thread.
+template <typename Body>
+void parallelFor(size_t count, Body body, size_t maxWorkers = 0) {
+    size_t workers = std::min(count, maxWorkers ? maxWorkers : workerCount());
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> nextIndex(0);
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+
+    auto worker = [&]() {
+        for (size_t i = nextIndex++; i < count; i = nextIndex++) {
+            try {
+                body(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t t = 1; t < workers; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker(); // The calling thread takes a share of the work too
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
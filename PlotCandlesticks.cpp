@@ -1,24 +1,47 @@
 // PlotCandlesticks.cpp
 #include "PlotCandlesticks.h"
 #include "Utils.h" // For clamp and normalize
+#include "Profiler.h"
 #include <iostream>
-#include <iomanip>
+#include <cstdio>
 #include <cmath>
 #include <algorithm>
 #include <limits>
+#include <string>
 
-//Plots candlestick data in a text-based format with spacing aligned to x-axis labels.
+namespace {
+
+// Scaled row of each part of one candlestick, computed once per plot instead of once per cell.
+struct CandleRows {
+    int high;
+    int low;
+    int open;
+    int close;
+};
 
-void plotCandlesticks(const std::vector<Candlestick>& candlesticks, int scaleHeight) {
+// Glyph drawn for a candlestick at a given row.
+char cellGlyph(const CandleRows& rows, int row) {
+    if (row == rows.high || row == rows.low) return '|';
+    if (row == rows.open && row == rows.close) return '=';
+    if (row == rows.open) return '+';
+    if (row == rows.close) return '-';
+    if (row < rows.high && row > rows.low) return '|';
+    return ' ';
+}
+
+// Renders all pages of the plot, each built in one preallocated buffer and written with a single call.
+// In interactive mode the user is prompted to press Enter between pages.
+void renderPages(CandlestickRange candlesticks, int scaleHeight, std::ostream& out, bool interactive, Arena* arena) {
+    PROFILE_SCOPE("render plot");
     if (candlesticks.empty()) {
         std::cerr << "No candlestick data to plot." << std::endl;
         return;
     }
 
-    // Determine global min and max temperatures
-    double globalMin = candlesticks[0].low;
-    double globalMax = candlesticks[0].high;
-
+    // Determine global min and max temperatures in one pass over the candles; the fields are strided
+    // through Candlestick, so copying them out for the vector kernels would cost more than it saves
+    double globalMin = std::numeric_limits<double>::infinity();
+    double globalMax = -std::numeric_limits<double>::infinity();
     for (const auto& candle : candlesticks) {
         globalMin = std::min(globalMin, candle.low);
         globalMax = std::max(globalMax, candle.high);
@@ -27,65 +50,91 @@ void plotCandlesticks(const std::vector<Candlestick>& candlesticks, int scaleHei
     // Adjust scaleHeight if necessary
     scaleHeight = std::max(scaleHeight, 10);
 
+    // Row positions of every candle and the y-axis labels are the same on every page
+    ArenaVector<CandleRows> positions{ArenaAllocator<CandleRows>(arena)};
+    positions.reserve(candlesticks.size());
+    for (const auto& candle : candlesticks) {
+        CandleRows rows = {
+            normalize(candle.high, globalMin, globalMax, scaleHeight),
+            normalize(candle.low, globalMin, globalMax, scaleHeight),
+            normalize(candle.open, globalMin, globalMax, scaleHeight),
+            normalize(candle.close, globalMin, globalMax, scaleHeight)
+        };
+        positions.push_back(rows);
+    }
+    ArenaVector<ArenaString> axisLabels{ArenaAllocator<ArenaString>(arena)};
+    axisLabels.reserve(scaleHeight);
+    for (int row = 0; row < scaleHeight; ++row) {
+        double currentTemp = globalMin + (globalMax - globalMin) * row / (scaleHeight - 1);
+        char label[64];
+        std::snprintf(label, sizeof(label), "%6.1f | ", currentTemp);
+        axisLabels.emplace_back(label, ArenaAllocator<char>(arena));
+    }
+
     // Pagination setup
     const int pageSize = 20;
     int totalCandlesticks = candlesticks.size();
     int totalPages = (totalCandlesticks + pageSize - 1) / pageSize;
 
+    ArenaString page{ArenaAllocator<char>(arena)};
     for (int currentPage = 1; currentPage <= totalPages; ++currentPage) {
         int startIdx = (currentPage - 1) * pageSize;
         int endIdx = std::min(startIdx + pageSize, totalCandlesticks);
+        int width = endIdx - startIdx;
 
-        // Subset of candlesticks for the current page
-        std::vector<Candlestick> subset(candlesticks.begin() + startIdx, candlesticks.begin() + endIdx);
+        page.clear();
+        page.reserve(static_cast<size_t>(scaleHeight + 2) * (16 + 6 * width));
 
-        // Print the plot from top (max) to bottom (min)
+        // Plot rows from top (max) to bottom (min), five characters per candle
         for (int row = scaleHeight - 1; row >= 0; --row) {
-            double currentTemp = globalMin + (globalMax - globalMin) * row / (scaleHeight - 1);
-            std::cout << std::setw(6) << std::fixed << std::setprecision(1) << currentTemp << " | ";
-
-            for (const auto& candle : subset) {
-                int highPos = normalize(candle.high, globalMin, globalMax, scaleHeight);
-                int lowPos = normalize(candle.low, globalMin, globalMax, scaleHeight);
-                int openPos = normalize(candle.open, globalMin, globalMax, scaleHeight);
-                int closePos = normalize(candle.close, globalMin, globalMax, scaleHeight);
-
-                if (row == highPos && row == lowPos) {
-                    std::cout << "|    ";
-                } else if (row == highPos) {
-                    std::cout << "|    ";
-                } else if (row == lowPos) {
-                    std::cout << "|    ";
-                } else if (row == openPos && row == closePos) {
-                    std::cout << "=    ";
-                } else if (row == openPos) {
-                    std::cout << "+    ";
-                } else if (row == closePos) {
-                    std::cout << "-    ";
-                } else if (row < highPos && row > lowPos) {
-                    std::cout << "|    ";
-                } else {
-                    std::cout << "     ";  // Add appropriate spacing
-                }
+            page += axisLabels[row];
+            for (int i = startIdx; i < endIdx; ++i) {
+                page += cellGlyph(positions[i], row);
+                page.append(4, ' ');
             }
-            std::cout << std::endl;
+            page += '\n';
         }
 
-        // Print the x-axis separator
-        std::cout << "       " << std::string(subset.size() * 5, '-') << std::endl;
+        // X-axis separator
+        page.append(7, ' ');
+        page.append(static_cast<size_t>(width) * 5, '-');
+        page += '\n';
 
-        // Print the years below the plot with spacing aligned
-        std::cout << "       ";
-        for (const auto& candle : subset) {
-            std::cout << std::setw(5) << candle.date.substr(0, 4) << " ";
+        // Bucket labels below the plot with spacing aligned (the last five characters of finer labels,
+        // e.g. "80-07" for "1980-07")
+        page.append(7, ' ');
+        for (int i = startIdx; i < endIdx; ++i) {
+            const std::string& date = candlesticks[i].date;
+            size_t labelLength = date.size() <= 5 ? std::min<size_t>(date.size(), 4) : 5;
+            size_t labelStart = date.size() <= 5 ? 0 : date.size() - 5;
+            if (labelLength < 5) {
+                page.append(5 - labelLength, ' ');
+            }
+            page.append(date.data() + labelStart, labelLength);
+            page += ' ';
         }
-        std::cout << std::endl;
+        page += '\n';
+
+        out.write(page.data(), static_cast<std::streamsize>(page.size()));
 
         // If there are more pages, prompt the user to continue
-        if (currentPage < totalPages) {
-            std::cout << "\nPress Enter to view the next page...";
+        if (interactive && currentPage < totalPages) {
+            out << "\nPress Enter to view the next page..." << std::flush;
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear input buffer
             std::cin.get();    // Wait for Enter
         }
     }
+    out.flush();
+}
+
+} // namespace
+
+//Plots candlestick data in a text-based format with spacing aligned to x-axis labels.
+
+void plotCandlesticks(CandlestickRange candlesticks, int scaleHeight, Arena* arena) {
+    renderPages(candlesticks, scaleHeight, std::cout, true, arena);
+}
+
+void renderCandlesticks(CandlestickRange candlesticks, int scaleHeight, std::ostream& out, Arena* arena) {
+    renderPages(candlesticks, scaleHeight, out, false, arena);
 }
@@ -1,7 +1,15 @@
 // PlotCandlesticks.h
 #pragma once
 #include "Candlestick.h"
+#include "CandlestickRange.h"
+#include "Arena.h"
 #include <vector>
+#include <ostream>
 
-// Text Based Plot
-void plotCandlesticks(const std::vector<Candlestick>& candlesticks, int scaleHeight);
+// Both plots keep their row positions, axis labels and page buffer in arena when one is given.
+
+// Text Based Plot, paging through std::cout and waiting for Enter between pages
+void plotCandlesticks(CandlestickRange candlesticks, int scaleHeight, Arena* arena = nullptr);
+
+// Non-interactive plot that writes every page to out (a file, pipe or string stream) without pausing
+void renderCandlesticks(CandlestickRange candlesticks, int scaleHeight, std::ostream& out, Arena* arena = nullptr);
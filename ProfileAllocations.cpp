@@ -0,0 +1,56 @@
+// ProfileAllocations.cpp
+// Replaces the global allocation functions so profiled stages can report their heap traffic. Linked into the
+// application only; the benchmark harness has its own replacement in bench/AllocationCounter.cpp.
+#include "Profiler.h"
+
+#ifdef WEATHER_PROFILING
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+void* profiledAllocate(size_t size) {
+    profileAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    if (void* p = profiledAllocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if (void* p = profiledAllocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return profiledAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return profiledAllocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+#endif
@@ -0,0 +1,242 @@
+// Profiler.cpp
+#include "Profiler.h"
+#include "CandlestickTable.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+std::atomic<bool> profilingFlag(false);
+
+namespace {
+
+// One finished stage, or one counter increment when `counter` is set.
+struct ProfileEvent {
+    const char* name;
+    long long start;           // Nanoseconds since profiling was enabled
+    long long duration;
+    double value;              // Counter increment
+    size_t allocations;
+    size_t allocatedBytes;
+    bool counter;
+};
+
+// Events of one thread. Logs are shared with the registry so they outlive pool threads.
+struct ThreadLog {
+    unsigned id;
+    std::vector<ProfileEvent> events;
+};
+
+std::mutex registryMutex;
+std::vector<std::shared_ptr<ThreadLog>> registry;
+std::atomic<unsigned> generation(0);      // Bumped on every enable so threads drop their old logs
+std::atomic<long long> epochNanoseconds(0);
+
+// Plain thread-local counters, so the replacement operator new can update them without allocating.
+thread_local size_t threadAllocations = 0;
+thread_local size_t threadAllocatedBytes = 0;
+
+long long steadyNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+long long elapsedNanoseconds() {
+    return steadyNanoseconds() - epochNanoseconds.load(std::memory_order_relaxed);
+}
+
+ThreadLog& currentLog() {
+    thread_local std::shared_ptr<ThreadLog> log;
+    thread_local unsigned logGeneration = 0;
+    unsigned current = generation.load(std::memory_order_acquire);
+    if (!log || logGeneration != current) {
+        std::shared_ptr<ThreadLog> fresh(new ThreadLog());
+        fresh->events.reserve(1024);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        fresh->id = static_cast<unsigned>(registry.size()) + 1;
+        registry.push_back(fresh);
+        log = fresh;
+        logGeneration = current;
+    }
+    return *log;
+}
+
+// Every event recorded since profiling was last enabled, in start order.
+std::vector<std::pair<unsigned, ProfileEvent>> collectEvents() {
+    std::vector<std::pair<unsigned, ProfileEvent>> events;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto& log : registry) {
+        for (const auto& event : log->events) {
+            events.push_back(std::make_pair(log->id, event));
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const std::pair<unsigned, ProfileEvent>& a, const std::pair<unsigned, ProfileEvent>& b) {
+        return a.second.start < b.second.start;
+    });
+    return events;
+}
+
+void writeMicroseconds(long long nanoseconds, std::ostream& out) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3f", nanoseconds / 1000.0);
+    out << text;
+}
+
+void writeValue(double value, std::ostream& out) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.15g", value);
+    out << text;
+}
+
+} // namespace
+
+bool profilingCompiledIn() {
+#ifdef WEATHER_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void setProfilingEnabled(bool enabled) {
+    if (enabled) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.clear();
+        epochNanoseconds.store(steadyNanoseconds(), std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+    }
+    profilingFlag.store(enabled, std::memory_order_release);
+}
+
+void profileCount(const char* name, double amount) {
+    ProfileEvent event = {name, elapsedNanoseconds(), 0, amount, 0, 0, true};
+    currentLog().events.push_back(event);
+}
+
+void profileAllocation(size_t bytes) {
+    if (profilingEnabled()) {
+        ++threadAllocations;
+        threadAllocatedBytes += bytes;
+    }
+}
+
+ProfileScope::ProfileScope(const char* name)
+    : name(name), start(-1), allocations(0), allocatedBytes(0) {
+    if (profilingEnabled()) {
+        allocations = threadAllocations;
+        allocatedBytes = threadAllocatedBytes;
+        start = elapsedNanoseconds();
+    }
+}
+
+ProfileScope::~ProfileScope() {
+    if (start < 0) {
+        return;
+    }
+    ProfileEvent event = {name, start, elapsedNanoseconds() - start, 0.0,
+                          threadAllocations - allocations, threadAllocatedBytes - allocatedBytes, false};
+    currentLog().events.push_back(event);
+}
+
+// Stages are listed in the order they first started. Times are inclusive of nested stages and summed over
+// threads, so stages run by parallel workers can add up to more than the wall time.
+
+void writeProfileReport(std::ostream& out) {
+    if (!profilingCompiledIn()) {
+        out << "Profiling was compiled out (configure with -DWEATHER_PROFILING=ON).\n";
+        return;
+    }
+
+    struct StageTotals {
+        size_t calls;
+        long long total;
+        long long longest;
+        size_t allocations;
+        size_t allocatedBytes;
+    };
+    std::vector<std::string> stageOrder, counterOrder;
+    std::map<std::string, StageTotals> stages;
+    std::map<std::string, double> counters;
+    for (const auto& entry : collectEvents()) {
+        const ProfileEvent& event = entry.second;
+        if (event.counter) {
+            if (counters.find(event.name) == counters.end()) {
+                counterOrder.push_back(event.name);
+            }
+            counters[event.name] += event.value;
+            continue;
+        }
+        auto it = stages.find(event.name);
+        if (it == stages.end()) {
+            stageOrder.push_back(event.name);
+            StageTotals empty = {0, 0, 0, 0, 0};
+            it = stages.insert(std::make_pair(std::string(event.name), empty)).first;
+        }
+        StageTotals& totals = it->second;
+        ++totals.calls;
+        totals.total += event.duration;
+        totals.longest = std::max(totals.longest, event.duration);
+        totals.allocations += event.allocations;
+        totals.allocatedBytes += event.allocatedBytes;
+    }
+
+    char line[160];
+    out << "\nProfile (inclusive wall time per stage, summed over threads):\n";
+    std::snprintf(line, sizeof(line), "%-24s %8s %12s %12s %12s %10s %12s\n", "Stage", "Calls", "Total ms", "Mean ms", "Max ms", "Allocs", "Alloc KB");
+    out << line;
+    out << std::string(96, '-') << "\n";
+    for (const auto& name : stageOrder) {
+        const StageTotals& totals = stages[name];
+        std::snprintf(line, sizeof(line), "%-24s %8zu %12.3f %12.3f %12.3f %10zu %12.1f\n", name.c_str(), totals.calls,
+                      totals.total / 1e6, totals.total / 1e6 / totals.calls, totals.longest / 1e6, totals.allocations,
+                      totals.allocatedBytes / 1024.0);
+        out << line;
+    }
+
+    if (!counterOrder.empty()) {
+        out << "\nCounters:\n";
+        for (const auto& name : counterOrder) {
+            std::snprintf(line, sizeof(line), "%-24s %20.15g\n", name.c_str(), counters[name]);
+            out << line;
+        }
+    }
+    auto filtered = counters.find("candles filtered");
+    auto kept = counters.find("candles kept");
+    if (filtered != counters.end() && kept != counters.end() && filtered->second > 0) {
+        std::snprintf(line, sizeof(line), "%-24s %19.1f%%\n", "filter selectivity", 100.0 * kept->second / filtered->second);
+        out << line;
+    }
+}
+
+// Stages become complete ("X") events and counters become counter ("C") events carrying the running total.
+
+void writeChromeTrace(std::ostream& out) {
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"weather_analysis\"}}";
+    std::map<std::string, double> totals;
+    for (const auto& entry : collectEvents()) {
+        const ProfileEvent& event = entry.second;
+        out << ",\n{\"name\":";
+        writeJsonString(event.name, out);
+        if (event.counter) {
+            double& total = totals[event.name];
+            total += event.value;
+            out << ",\"ph\":\"C\",\"ts\":";
+            writeMicroseconds(event.start, out);
+            out << ",\"pid\":1,\"tid\":" << entry.first << ",\"args\":{\"value\":";
+            writeValue(total, out);
+            out << "}}";
+        } else {
+            out << ",\"cat\":\"stage\",\"ph\":\"X\",\"ts\":";
+            writeMicroseconds(event.start, out);
+            out << ",\"dur\":";
+            writeMicroseconds(event.duration, out);
+            out << ",\"pid\":1,\"tid\":" << entry.first << ",\"args\":{\"allocations\":" << event.allocations
+                << ",\"allocatedBytes\":" << event.allocatedBytes << "}}";
+        }
+    }
+    out << "\n]}\n";
+}
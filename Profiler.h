@@ -0,0 +1,70 @@
+// Profiler.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+
+// Scoped stage timers and named counters for attributing latency without an external profiler.
+//
+//   PROFILE_SCOPE("aggregate");                // Times the rest of the enclosing block
+//   PROFILE_COUNT("rows parsed", rows);        // Adds to a counter
+//
+// Both macros compile to nothing unless WEATHER_PROFILING is defined (the CMake option of the same
+// name, on by default). When compiled in they cost one relaxed atomic load until profiling is switched
+// on with setProfilingEnabled, e.g. by --profile. Stage names and counter names must be string literals.
+//
+// Every scope also records the heap allocations made on its thread while it was open. Allocations are
+// only seen in binaries that link ProfileAllocations.cpp, which replaces the global operator new.
+
+#ifdef WEATHER_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COUNT(name, amount) \
+    do { if (profilingEnabled()) profileCount(name, static_cast<double>(amount)); } while (0)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_COUNT(name, amount) ((void)0)
+#endif
+
+// True when the profiler was compiled in.
+bool profilingCompiledIn();
+
+// Starts or stops recording. Enabling clears everything recorded before.
+void setProfilingEnabled(bool enabled);
+
+extern std::atomic<bool> profilingFlag;
+
+inline bool profilingEnabled() {
+    return profilingFlag.load(std::memory_order_relaxed);
+}
+
+// Adds to a named counter on the calling thread.
+void profileCount(const char* name, double amount);
+
+// Called by the replacement operator new for every allocation.
+void profileAllocation(size_t bytes);
+
+// Records the wall time and allocations of one stage from construction to destruction, if profiling
+// was enabled when it was constructed.
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+
+private:
+    ProfileScope(const ProfileScope&);
+    ProfileScope& operator=(const ProfileScope&);
+
+    const char* name;
+    long long start;           // Nanoseconds since profiling was enabled, -1 when not recording
+    size_t allocations;
+    size_t allocatedBytes;
+};
+
+// Writes the per-stage breakdown (calls, inclusive wall time, allocations) and the counter totals.
+// Call after the profiled work has finished; threads still recording are not synchronized with.
+void writeProfileReport(std::ostream& out);
+
+// Writes every recorded stage and counter as Chrome trace-event JSON (chrome://tracing, Perfetto).
+void writeChromeTrace(std::ostream& out);
@@ -0,0 +1,189 @@
+// Query.cpp
+#include "Query.h"
+#include "CandlestickTable.h"
+#include "CountryColumns.h"
+#include "PlotCandlesticks.h"
+#include "TemperaturePredictor.h"
+#include "Timestamp.h"
+#include "Profiler.h"
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+const char* outputFormatName(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::Table: return "table";
+        case OutputFormat::Plot: return "plot";
+        case OutputFormat::Csv: return "csv";
+        case OutputFormat::Json: return "json";
+    }
+    return "table";
+}
+
+bool parseOutputFormat(const std::string& name, OutputFormat& format) {
+    static const OutputFormat formats[] = {OutputFormat::Table, OutputFormat::Plot, OutputFormat::Csv, OutputFormat::Json};
+    for (OutputFormat candidate : formats) {
+        if (name == outputFormatName(candidate)) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+WeatherQuery::WeatherQuery()
+    : bucketSize(BucketSize::Year), hasYearRange(false), startYear(0), endYear(0),
+      predict(false), predictStart(0), predictEnd(0), forecastPeriods(0), model(ForecastModel::Linear) {
+    for (auto& range : ranges) {
+        range.enabled = false;
+        range.minValue = 0.0;
+        range.maxValue = 0.0;
+    }
+}
+
+std::string WeatherQuery::cacheKey() const {
+    std::ostringstream key;
+    key.precision(17);
+    key << column << '|' << bucketSizeName(bucketSize);
+    if (hasYearRange) {
+        key << "|years=" << startYear << ':' << endYear;
+    }
+    static const char* fieldNames[] = {"open", "high", "low", "close"};
+    for (int f = 0; f < 4; ++f) {
+        if (ranges[f].enabled) {
+            key << '|' << fieldNames[f] << '=' << ranges[f].minValue << ':' << ranges[f].maxValue;
+        }
+    }
+    for (const auto& range : where) {
+        key << "|where=" << range.column << ':' << range.minValue << ':' << range.maxValue;
+    }
+    if (predict) {
+        key << "|predict=" << predictStart << ':' << predictEnd;
+    }
+    if (forecastPeriods) {
+        key << "|forecast=" << forecastPeriods << ':' << forecastModelName(model);
+    }
+    return key.str();
+}
+
+void checkQueryLimits(const WeatherQuery& query) {
+    if (query.predict && static_cast<long long>(query.predictEnd) - query.predictStart >= maxPredictYears) {
+        throw std::runtime_error("A prediction may span at most " + std::to_string(maxPredictYears) + " years");
+    }
+    if (query.forecastPeriods > maxForecastPeriods) {
+        throw std::runtime_error("A forecast may cover at most " + std::to_string(maxForecastPeriods) + " periods");
+    }
+}
+
+CandlestickFilter queryFilter(const WeatherQuery& query) {
+    CandlestickFilter filter;
+    if (query.hasYearRange) {
+        filter.yearRange(query.startYear, query.endYear);
+    }
+    for (int f = 0; f < 4; ++f) {
+        if (query.ranges[f].enabled) {
+            filter.fieldRange(static_cast<CandleField>(f), query.ranges[f].minValue, query.ranges[f].maxValue);
+        }
+    }
+    return filter;
+}
+
+QueryResult runQuery(const WeatherData& weatherData, const WeatherQuery& query) {
+    Arena arena;
+    return runQuery(weatherData, query, arena);
+}
+
+QueryResult runQuery(const WeatherData& weatherData, const WeatherQuery& query, Arena& arena, const RollupPyramid* rollups) {
+    PROFILE_SCOPE("query");
+    checkQueryLimits(query);
+    QueryResult result;
+    result.column = query.column;
+
+    // Work on the compact series and only build date strings for the candles that are returned
+    CandlestickFilter filter = queryFilter(query);
+    CandleSeries series(query.bucketSize, &arena);
+    if (rollups && !query.forecastPeriods) {
+        // Forecasts need the whole history, everything else only the requested years
+        long long from = std::numeric_limits<long long>::min();
+        long long to = std::numeric_limits<long long>::max();
+        if (query.hasYearRange) {
+            from = daysFromCivil(query.startYear, 1, 1) * 86400;
+            to = daysFromCivil(static_cast<long long>(query.endYear) + 1, 1, 1) * 86400;
+        }
+        series = rollups->candles(query.column, query.bucketSize, from, to, &arena);
+    } else {
+        series = aggregateSeries(weatherData, query.column, query.bucketSize, &arena);
+    }
+    // Means of the other columns over each candle's bucket; they must outlive the filter that refers to them
+    std::vector<std::vector<double>> whereMeans;
+    whereMeans.reserve(query.where.size());
+    for (const auto& range : query.where) {
+        whereMeans.push_back(alignedBucketMeans(weatherData, range.column, series));
+        filter.seriesRange(whereMeans.back(), range.minValue, range.maxValue);
+    }
+    CandleSeries selected = filter.empty() ? series : filter.apply(series);
+    result.candlesticks = selected.toCandlesticks();
+
+    if (query.predict) {
+        if (query.predictStart > query.predictEnd) {
+            throw std::runtime_error("Invalid range. Start year must be less than or equal to end year.");
+        }
+        TemperaturePredictor predictor(selected);
+        ArenaVector<Candlestick> predictions = predictor.predictTemperatures(query.predictStart, query.predictEnd, &arena);
+        result.predictions.insert(result.predictions.end(), predictions.begin(), predictions.end());
+    }
+
+    if (query.forecastPeriods) {
+        // Forecast from the full unfiltered series so the buckets stay consecutive
+        ForecastOptions options;
+        options.model = query.model;
+        options.bucketSize = query.bucketSize;
+        std::vector<Candlestick> candlesticks = series.toCandlesticks();
+        ForecastSeries forecastSeries = {query.column, &candlesticks};
+        std::vector<size_t> horizons;
+        for (size_t h = 1; h <= query.forecastPeriods; ++h) {
+            horizons.push_back(h);
+        }
+        std::vector<ForecastResult> forecasts = forecastAll(std::vector<ForecastSeries>(1, forecastSeries), horizons, options);
+        result.predictions.insert(result.predictions.end(), forecasts[0].forecasts.begin(), forecasts[0].forecasts.end());
+    }
+    return result;
+}
+
+void writeQueryResult(const QueryResult& result, OutputFormat format, std::ostream& out) {
+    PROFILE_SCOPE("write result");
+    switch (format) {
+        case OutputFormat::Table:
+            out << "\n" << formatCountryName(result.column) << " Candlestick Data:\n";
+            displayCandlesticksAsTable(result.candlesticks, out);
+            if (!result.predictions.empty()) {
+                out << "\nPredicted Candlestick Data:\n";
+                displayCandlesticksAsTable(result.predictions, out);
+            }
+            break;
+        case OutputFormat::Plot:
+            out << "\n" << formatCountryName(result.column) << " Candlestick Plot:\n";
+            renderCandlesticks(result.candlesticks, 20, out);
+            if (!result.predictions.empty()) {
+                out << "\nPredicted Candlestick Plot:\n";
+                renderCandlesticks(result.predictions, 20, out);
+            }
+            break;
+        case OutputFormat::Csv:
+            writeCandlesticksAsCsv(result.candlesticks, out);
+            if (!result.predictions.empty()) {
+                out << "\n";
+                writeCandlesticksAsCsv(result.predictions, out);
+            }
+            break;
+        case OutputFormat::Json:
+            out << "{\"column\":";
+            writeJsonString(result.column, out);
+            out << ",\"candlesticks\":";
+            writeCandlesticksAsJson(result.candlesticks, out);
+            out << ",\"predictions\":";
+            writeCandlesticksAsJson(result.predictions, out);
+            out << "}\n";
+            break;
+    }
+}
@@ -0,0 +1,86 @@
+// Query.h
+#pragma once
+#include "Candlestick.h"
+#include "BucketAggregator.h"
+#include "CandlestickFilter.h"
+#include "Forecaster.h"
+#include "WeatherData.h"
+#include "Arena.h"
+#include "RollupPyramid.h"
+#include <vector>
+#include <string>
+#include <ostream>
+
+// How a query result is written out.
+enum class OutputFormat { Table, Plot, Csv, Json };
+
+// Printable name of a format ("table", "plot", "csv", "json").
+const char* outputFormatName(OutputFormat format);
+
+// Parses a format name, returning false if it is not recognised.
+bool parseOutputFormat(const std::string& name, OutputFormat& format);
+
+// Inclusive range on one candlestick field.
+struct ValueRange {
+    bool enabled;
+    double minValue;
+    double maxValue;
+};
+
+// Inclusive range on the bucket mean of another column, e.g. radiation while aggregating temperature.
+struct ColumnRange {
+    std::string column;
+    double minValue;
+    double maxValue;
+};
+
+// One analysis request against a loaded dataset: aggregate a column into candlesticks, filter them,
+// and optionally predict (yearly linear trend) or forecast (any model) beyond the data.
+struct WeatherQuery {
+    std::string column;          // e.g. "AT_temperature"
+    BucketSize bucketSize;
+    bool hasYearRange;
+    int startYear;
+    int endYear;
+    ValueRange ranges[4];        // Indexed by CandleField
+    // Ranges on other columns; buckets without readings in such a column are dropped
+    std::vector<ColumnRange> where;
+    bool predict;                // Yearly TemperaturePredictor over [predictStart, predictEnd]
+    int predictStart;
+    int predictEnd;
+    size_t forecastPeriods;      // forecastAll horizons 1..forecastPeriods when non-zero
+    ForecastModel model;
+
+    WeatherQuery();
+
+    // Canonical text of every field, used as a cache key.
+    std::string cacheKey() const;
+};
+
+// Candlesticks selected by a query plus any predicted ones.
+struct QueryResult {
+    std::string column;
+    std::vector<Candlestick> candlesticks;
+    std::vector<Candlestick> predictions;
+};
+
+// Widest predicted year range and most forecast periods a query may ask for. Every predicted year and
+// forecast period becomes a candlestick, so these bound the size of a result.
+const int maxPredictYears = 1000;
+const size_t maxForecastPeriods = 100000;
+
+// Throws std::runtime_error if the query's predicted range or forecast length exceeds those limits.
+void checkQueryLimits(const WeatherQuery& query);
+
+// Filter selecting the candlesticks a query keeps (empty when it has no year or field ranges).
+CandlestickFilter queryFilter(const WeatherQuery& query);
+
+// Runs a query; throws std::runtime_error for unknown columns or impossible predictions.
+// Intermediate buffers are taken from `arena`, which the caller may reset once the result is written.
+// With rollups, only the buckets in the query's year range are read instead of aggregating every row.
+QueryResult runQuery(const WeatherData& weatherData, const WeatherQuery& query, Arena& arena, const RollupPyramid* rollups = nullptr);
+// Same with a private arena released when the query returns.
+QueryResult runQuery(const WeatherData& weatherData, const WeatherQuery& query);
+
+// Writes a result in the requested format.
+void writeQueryResult(const QueryResult& result, OutputFormat format, std::ostream& out);
@@ -0,0 +1,635 @@
+// QueryServer.cpp
+#include "QueryServer.h"
+#include "Query.h"
+#include "CandlestickTable.h"
+#include "Parallel.h"
+#include "ThreadPool.h"
+#include "FastParse.h"
+#include "Timestamp.h"
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Longest request line accepted before the connection is dropped
+const size_t maxRequestBytes = 64 * 1024;
+
+// Years a request may name (the four-digit years timestamps use)
+const long long minRequestYear = 1;
+const long long maxRequestYear = 9999;
+// Pause after accept runs out of descriptors or buffers, instead of spinning on the readable listener
+const std::chrono::milliseconds acceptBackoff(100);
+
+// Value of one request field; requests only use strings, numbers and arrays of numbers.
+struct JsonField {
+    enum Kind { String, Number, NumberArray, Other } kind;
+    std::string text;
+    double number;
+    std::vector<double> numbers;
+};
+
+// Minimal parser for the flat request objects the protocol uses.
+class RequestParser {
+public:
+    explicit RequestParser(const std::string& text) : p(text.c_str()), end(text.c_str() + text.size()) {}
+
+    std::map<std::string, JsonField> parseObject() {
+        std::map<std::string, JsonField> fields;
+        expect('{');
+        if (peek() == '}') {
+            ++p;
+        } else {
+            while (true) {
+                std::string key = parseString();
+                expect(':');
+                fields[key] = parseValue();
+                if (peek() == ',') {
+                    ++p;
+                    continue;
+                }
+                expect('}');
+                break;
+            }
+        }
+        if (peek() != '\0') {
+            throw std::runtime_error("Trailing characters after request object");
+        }
+        return fields;
+    }
+
+private:
+    char peek() {
+        while (p < end && std::isspace(static_cast<unsigned char>(*p))) {
+            ++p;
+        }
+        return p < end ? *p : '\0';
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            throw std::runtime_error(std::string("Malformed request: expected '") + c + "'");
+        }
+        ++p;
+    }
+
+    std::string parseString() {
+        expect('"');
+        std::string text;
+        while (p < end && *p != '"') {
+            char c = *p++;
+            if (c == '\\' && p < end) {
+                c = *p++;
+                switch (c) {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'u': throw std::runtime_error("Unicode escapes are not supported in requests");
+                    default: break; // '"', '\\' and '/' stand for themselves
+                }
+            }
+            text += c;
+        }
+        expect('"');
+        return text;
+    }
+
+    double parseNumber() {
+        peek();
+        char* numberEnd;
+        double value = std::strtod(p, &numberEnd);
+        if (numberEnd == p || numberEnd > end || !std::isfinite(value)) {
+            throw std::runtime_error("Malformed request: expected a number");
+        }
+        p = numberEnd;
+        return value;
+    }
+
+    JsonField parseValue() {
+        JsonField field;
+        field.kind = JsonField::Other;
+        field.number = 0.0;
+        char c = peek();
+        if (c == '"') {
+            field.kind = JsonField::String;
+            field.text = parseString();
+        } else if (c == '[') {
+            ++p;
+            field.kind = JsonField::NumberArray;
+            if (peek() == ']') {
+                ++p;
+            } else {
+                while (true) {
+                    field.numbers.push_back(parseNumber());
+                    if (peek() == ',') {
+                        ++p;
+                        continue;
+                    }
+                    expect(']');
+                    break;
+                }
+            }
+        } else if (c == '-' || std::isdigit(static_cast<unsigned char>(c))) {
+            field.kind = JsonField::Number;
+            field.number = parseNumber();
+        } else {
+            static const char* literals[] = {"true", "false", "null"};
+            for (const char* literal : literals) {
+                size_t length = std::strlen(literal);
+                if (static_cast<size_t>(end - p) >= length && std::strncmp(p, literal, length) == 0) {
+                    p += length;
+                    return field;
+                }
+            }
+            throw std::runtime_error("Malformed request: unexpected value");
+        }
+        return field;
+    }
+
+    const char* p;
+    const char* end;
+};
+
+const JsonField* findField(const std::map<std::string, JsonField>& fields, const std::string& name, JsonField::Kind kind) {
+    auto it = fields.find(name);
+    if (it == fields.end()) {
+        return nullptr;
+    }
+    if (it->second.kind != kind) {
+        throw std::runtime_error("Field '" + name + "' has the wrong type");
+    }
+    return &it->second;
+}
+
+// Reads a two-number array field such as "years":[1990,2000]; false if the field is absent.
+bool findPair(const std::map<std::string, JsonField>& fields, const std::string& name, double& first, double& second) {
+    const JsonField* field = findField(fields, name, JsonField::NumberArray);
+    if (!field) {
+        return false;
+    }
+    if (field->numbers.size() != 2) {
+        throw std::runtime_error("Field '" + name + "' must hold two numbers");
+    }
+    first = field->numbers[0];
+    second = field->numbers[1];
+    return true;
+}
+
+// Converts a request number that must be a whole number in [minimum, maximum]; casting anything else
+// to an integer would be undefined.
+long long wholeNumber(const std::string& name, double value, long long minimum, long long maximum) {
+    if (!(value >= static_cast<double>(minimum) && value <= static_cast<double>(maximum)) || value != std::floor(value)) {
+        throw std::runtime_error("Field '" + name + "' must hold whole numbers from " + std::to_string(minimum) + " to " +
+                                 std::to_string(maximum));
+    }
+    return static_cast<long long>(value);
+}
+
+// Reads a two-year array field such as "years":[1990,2000]; false if the field is absent.
+bool findYears(const std::map<std::string, JsonField>& fields, const std::string& name, int& first, int& second) {
+    double firstValue, secondValue;
+    if (!findPair(fields, name, firstValue, secondValue)) {
+        return false;
+    }
+    first = static_cast<int>(wholeNumber(name, firstValue, minRequestYear, maxRequestYear));
+    second = static_cast<int>(wholeNumber(name, secondValue, minRequestYear, maxRequestYear));
+    return true;
+}
+
+// Reads a "from"/"to" field holding an ISO date or timestamp.
+bool findTime(const std::map<std::string, JsonField>& fields, const std::string& name, long long& seconds) {
+    const JsonField* field = findField(fields, name, JsonField::String);
+    if (!field) {
+        return false;
+    }
+    const char* text = field->text.c_str();
+    if (!parseTimestamp(text, text + field->text.size(), seconds)) {
+        throw std::runtime_error("Field '" + name + "' is not a date: " + field->text);
+    }
+    return true;
+}
+
+std::string errorResponse(const std::string& message) {
+    std::ostringstream out;
+    out << "{\"ok\":false,\"error\":";
+    writeJsonString(message, out);
+    out << '}';
+    return out.str();
+}
+
+} // namespace
+
+QueryService::QueryService(const WeatherData& weatherData, const std::map<int, std::string>& countryMenu, size_t cacheEntries,
+                           const RollupPyramid* rollups)
+    : weatherData(weatherData), rollups(rollups), countryMenu(countryMenu), cache(cacheEntries) {}
+
+// Accepts either a country code ("AT"), combined with the variable, or a full column name ("AT_temperature").
+
+std::string QueryService::resolveColumn(const std::string& country, const std::string& variable) const {
+    for (const auto& it : countryMenu) {
+        if (it.second == country || it.second == country + "_" + variable) {
+            return it.second;
+        }
+    }
+    throw std::runtime_error("No column loaded for country '" + country + "' and variable '" + variable + "'");
+}
+
+std::string QueryService::handle(const std::string& request) {
+    try {
+        std::map<std::string, JsonField> fields = RequestParser(request).parseObject();
+        const JsonField* op = findField(fields, "op", JsonField::String);
+        if (!op) {
+            throw std::runtime_error("Missing 'op'");
+        }
+
+        std::ostringstream out;
+        if (op->text == "columns") {
+            out << "{\"ok\":true,\"columns\":[";
+            bool first = true;
+            for (const auto& it : countryMenu) {
+                out << (first ? "" : ",");
+                writeJsonString(it.second, out);
+                first = false;
+            }
+            out << "]}";
+            return out.str();
+        }
+        if (op->text == "stats") {
+            out << "{\"ok\":true,\"rows\":" << weatherData.rowCount() << ",\"cacheEntries\":" << cache.size()
+                << ",\"cacheHits\":" << cache.hits() << ",\"cacheMisses\":" << cache.misses() << '}';
+            return out.str();
+        }
+        if (op->text == "summary") {
+            // Range statistics straight from the rollups, without building candlesticks
+            if (!rollups) {
+                throw std::runtime_error("Summaries need the server's rollups");
+            }
+            const JsonField* country = findField(fields, "country", JsonField::String);
+            if (!country) {
+                throw std::runtime_error("Missing 'country'");
+            }
+            long long from = std::numeric_limits<long long>::min();
+            long long to = std::numeric_limits<long long>::max();
+            int startYear, endYear;
+            if (findYears(fields, "years", startYear, endYear)) {
+                from = daysFromCivil(startYear, 1, 1) * 86400;
+                to = daysFromCivil(static_cast<long long>(endYear) + 1, 1, 1) * 86400;
+            }
+            findTime(fields, "from", from);
+            findTime(fields, "to", to);
+
+            const JsonField* variable = findField(fields, "variable", JsonField::String);
+            std::string column = resolveColumn(country->text, variable ? variable->text : "temperature");
+            BucketStats summary = rollups->summarize(column, from, to);
+            out << "{\"ok\":true,\"column\":";
+            writeJsonString(column, out);
+            out << ",\"count\":" << summary.count;
+            if (summary.count) {
+                char numbers[256];
+                std::snprintf(numbers, sizeof(numbers),
+                              ",\"open\":%.6f,\"high\":%.6f,\"low\":%.6f,\"close\":%.6f,\"mean\":%.6f,\"stddev\":%.6f",
+                              summary.open, summary.high, summary.low, summary.close, summary.mean, std::sqrt(summary.variance()));
+                out << numbers;
+            }
+            out << '}';
+            return out.str();
+        }
+        if (op->text != "table" && op->text != "candlesticks" && op->text != "filter" && op->text != "predict" && op->text != "forecast") {
+            throw std::runtime_error("Unknown op '" + op->text + "'");
+        }
+
+        const JsonField* country = findField(fields, "country", JsonField::String);
+        if (!country) {
+            throw std::runtime_error("Missing 'country'");
+        }
+        const JsonField* variable = findField(fields, "variable", JsonField::String);
+        WeatherQuery query;
+        query.column = resolveColumn(country->text, variable ? variable->text : "temperature");
+
+        if (const JsonField* aggregate = findField(fields, "aggregate", JsonField::String)) {
+            if (!parseBucketSize(aggregate->text, query.bucketSize)) {
+                throw std::runtime_error("Unknown aggregation '" + aggregate->text + "'");
+            }
+        }
+        if (findYears(fields, "years", query.startYear, query.endYear)) {
+            query.hasYearRange = true;
+        }
+        static const char* fieldNames[] = {"open", "high", "low", "close"};
+        for (int f = 0; f < 4; ++f) {
+            if (findPair(fields, fieldNames[f], query.ranges[f].minValue, query.ranges[f].maxValue)) {
+                query.ranges[f].enabled = true;
+            }
+        }
+        if (op->text == "predict") {
+            if (!findYears(fields, "range", query.predictStart, query.predictEnd)) {
+                throw std::runtime_error("Missing 'range' for predict");
+            }
+            query.predict = true;
+        }
+        if (op->text == "forecast") {
+            const JsonField* periods = findField(fields, "periods", JsonField::Number);
+            if (!periods) {
+                throw std::runtime_error("Missing 'periods' for forecast");
+            }
+            query.forecastPeriods = static_cast<size_t>(wholeNumber("periods", periods->number, 1, maxForecastPeriods));
+            if (const JsonField* model = findField(fields, "model", JsonField::String)) {
+                if (!parseForecastModel(model->text, query.model)) {
+                    throw std::runtime_error("Unknown forecast model '" + model->text + "'");
+                }
+            }
+        }
+
+        // "filter" is the same query as "candlesticks"; only the table differs in output shape
+        const std::string key = (op->text == "table" ? "table|" : "json|") + query.cacheKey();
+        std::string response;
+        if (cache.lookup(key, response)) {
+            return response;
+        }
+
+        // Each worker reuses one arena for the temporaries of its queries, so steady traffic stops
+        // allocating once the arena's block has grown to fit the largest query
+        static thread_local Arena arena;
+        arena.reset();
+        QueryResult result = runQuery(weatherData, query, arena, rollups);
+        out << "{\"ok\":true,\"column\":";
+        writeJsonString(result.column, out);
+        if (op->text == "table") {
+            std::ostringstream table;
+            writeQueryResult(result, OutputFormat::Table, table);
+            out << ",\"text\":";
+            writeJsonString(table.str(), out);
+        } else {
+            out << ",\"candlesticks\":";
+            writeCandlesticksAsJson(result.candlesticks, out);
+            out << ",\"predictions\":";
+            writeCandlesticksAsJson(result.predictions, out);
+        }
+        out << '}';
+        response = out.str();
+        cache.insert(key, response);
+        return response;
+    } catch (const std::exception& e) {
+        return errorResponse(e.what());
+    }
+}
+
+#ifndef _WIN32
+
+namespace {
+
+// Sends the whole buffer, returning false once the client has gone away.
+bool sendAll(int socket, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(socket, data.data() + sent, data.size() - sent, 0);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// One client connection and the partial request line received from it so far.
+struct Connection {
+    int socket;
+    std::string pending;
+};
+
+// Reads what the client has sent (the socket is readable, so this does not wait) and answers every
+// complete request line in it. Returns false once the connection should be closed.
+bool serveRequests(Connection& connection, QueryService& service) {
+    char buffer[4096];
+    ssize_t n = ::recv(connection.socket, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+        return false;
+    }
+    std::string& pending = connection.pending;
+    pending.append(buffer, static_cast<size_t>(n));
+
+    size_t start = 0;
+    size_t newline;
+    while ((newline = pending.find('\n', start)) != std::string::npos) {
+        std::string line = pending.substr(start, newline - start);
+        start = newline + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.find_first_not_of(" \t") == std::string::npos) {
+            continue;
+        }
+        if (!sendAll(connection.socket, service.handle(line) + "\n")) {
+            return false;
+        }
+    }
+    pending.erase(0, start);
+    if (pending.size() > maxRequestBytes) {
+        sendAll(connection.socket, errorResponse("Request too long") + "\n");
+        return false;
+    }
+    return true;
+}
+
+// True if a server is accepting connections on the Unix socket.
+bool socketInUse(const sockaddr_un& address) {
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) {
+        return false;
+    }
+    bool connected = ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    ::close(probe);
+    return connected;
+}
+
+// Removes a socket file left behind by an earlier run. Anything else at the path is left alone.
+void removeStaleSocket(const std::string& path, const sockaddr_un& address) {
+    struct stat existing;
+    if (::lstat(path.c_str(), &existing) != 0) {
+        return; // Nothing there
+    }
+    if (!S_ISSOCK(existing.st_mode)) {
+        throw std::runtime_error("Refusing to replace " + path + ": it exists and is not a socket");
+    }
+    if (socketInUse(address)) {
+        throw std::runtime_error("Another server is already listening on " + path);
+    }
+    ::unlink(path.c_str());
+}
+
+int openListener(const std::string& address) {
+    int listener = -1;
+    if (address.compare(0, 5, "unix:") == 0) {
+        std::string path = address.substr(5);
+        sockaddr_un local;
+        std::memset(&local, 0, sizeof(local));
+        if (path.empty() || path.size() >= sizeof(local.sun_path)) {
+            throw std::runtime_error("Invalid socket path: " + path);
+        }
+        local.sun_family = AF_UNIX;
+        std::memcpy(local.sun_path, path.c_str(), path.size());
+        removeStaleSocket(path, local);
+        listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+            throw std::runtime_error("Could not bind " + address + ": " + std::strerror(errno));
+        }
+    } else if (address.compare(0, 4, "tcp:") == 0) {
+        char* end;
+        long port = std::strtol(address.c_str() + 4, &end, 10);
+        if (*end != '\0' || port <= 0 || port > 65535) {
+            throw std::runtime_error("Invalid port in " + address);
+        }
+        sockaddr_in local;
+        std::memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = htons(static_cast<unsigned short>(port));
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // Local clients only
+        listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (listener >= 0) {
+            ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+        if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+            throw std::runtime_error("Could not bind " + address + ": " + std::strerror(errno));
+        }
+    } else {
+        throw std::runtime_error("Address must be unix:PATH or tcp:PORT, got '" + address + "'");
+    }
+    if (::listen(listener, 64) != 0) {
+        ::close(listener);
+        throw std::runtime_error("Could not listen on " + address + ": " + std::strerror(errno));
+    }
+    return listener;
+}
+
+} // namespace
+
+// The calling thread polls the listener and every idle connection. A connection with data is handed to
+// the pool for one round of requests and comes back through `returned` afterwards, so workers are only
+// busy while answering and idle clients never keep others waiting.
+
+void runQueryServer(QueryService& service, const ServerOptions& options) {
+    ::signal(SIGPIPE, SIG_IGN); // A client closing early must not kill the server
+    int listener = openListener(options.address);
+    int wakePipe[2];
+    if (::pipe(wakePipe) != 0) {
+        ::close(listener);
+        throw std::runtime_error(std::string("pipe failed: ") + std::strerror(errno));
+    }
+
+    std::mutex returnedMutex;
+    std::vector<std::shared_ptr<Connection>> returned;     // Served connections waiting to be polled again
+    std::vector<std::shared_ptr<Connection>> idle;
+    ThreadPool pool(options.threads ? options.threads : workerCount());
+    std::cerr << "Debug: Serving queries on " << options.address << std::endl;
+
+    std::vector<pollfd> polled;
+    while (true) {
+        polled.clear();
+        pollfd listening = {listener, POLLIN, 0};
+        pollfd woken = {wakePipe[0], POLLIN, 0};
+        polled.push_back(listening);
+        polled.push_back(woken);
+        for (const auto& connection : idle) {
+            pollfd client = {connection->socket, POLLIN, 0};
+            polled.push_back(client);
+        }
+        if (::poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("poll failed: ") + std::strerror(errno));
+        }
+
+        // Hand every connection with something to read to a worker, keep polling the rest
+        std::vector<std::shared_ptr<Connection>> waiting;
+        for (size_t i = 0; i < idle.size(); ++i) {
+            if (!polled[i + 2].revents) {
+                waiting.push_back(idle[i]);
+                continue;
+            }
+            std::shared_ptr<Connection> connection = idle[i];
+            int wakeWriter = wakePipe[1];
+            pool.submit([connection, wakeWriter, &service, &returnedMutex, &returned]() {
+                bool open = false;
+                try {
+                    open = serveRequests(*connection, service);
+                } catch (const std::exception&) {
+                    // Dropping the client is all that can be done
+                }
+                if (!open) {
+                    ::close(connection->socket);
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(returnedMutex);
+                    returned.push_back(connection);
+                }
+                char signal = 1;
+                while (::write(wakeWriter, &signal, 1) < 0 && errno == EINTR) {
+                }
+            });
+        }
+        idle.swap(waiting);
+
+        if (polled[1].revents) {
+            char drained[64];
+            ::read(wakePipe[0], drained, sizeof(drained));
+            std::lock_guard<std::mutex> lock(returnedMutex);
+            idle.insert(idle.end(), returned.begin(), returned.end());
+            returned.clear();
+        }
+
+        if (polled[0].revents) {
+            int client = ::accept(listener, nullptr, nullptr);
+            if (client < 0) {
+                // A failed accept only loses that client; the server keeps answering the others
+                int error = errno;
+                if (error != EINTR && error != ECONNABORTED && error != EAGAIN && error != EWOULDBLOCK) {
+                    std::cerr << "Warning: accept failed: " << std::strerror(error) << std::endl;
+                }
+                if (error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM) {
+                    // The pending connection keeps the listener readable, so wait for descriptors to free up
+                    std::this_thread::sleep_for(acceptBackoff);
+                }
+                continue;
+            }
+            std::shared_ptr<Connection> connection(new Connection());
+            connection->socket = client;
+            idle.push_back(connection);
+        }
+    }
+}
+
+#else
+
+void runQueryServer(QueryService&, const ServerOptions&) {
+    throw std::runtime_error("The query server is only available on POSIX systems.");
+}
+
+#endif
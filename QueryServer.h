@@ -0,0 +1,52 @@
+// QueryServer.h
+#pragma once
+#include "LruCache.h"
+#include "WeatherData.h"
+#include "RollupPyramid.h"
+#include <map>
+#include <string>
+
+// Answers line-oriented JSON requests against one loaded dataset, memoizing responses by query.
+//
+//   {"op":"candlesticks","country":"AT","aggregate":"month","years":[1990,2000],"close":[0,5]}
+//   {"op":"table","country":"DE"}
+//   {"op":"candlesticks","country":"DE","variable":"radiation_direct_horizontal","aggregate":"day"}
+//   {"op":"predict","country":"AT","range":[2025,2030]}
+//   {"op":"forecast","country":"AT","aggregate":"month","periods":12,"model":"holt-winters"}
+//   {"op":"summary","country":"AT","from":"1990-01-01","to":"2000-01-01"}   (needs rollups)
+//   {"op":"columns"}   {"op":"stats"}
+//
+// "variable" defaults to "temperature"; only the columns the server loaded can be queried.
+// Every response is a single line: {"ok":true,...} or {"ok":false,"error":"..."}.
+class QueryService {
+public:
+    // With rollups, range queries read precomputed buckets and "summary" is available.
+    QueryService(const WeatherData& weatherData, const std::map<int, std::string>& countryMenu, size_t cacheEntries,
+                 const RollupPyramid* rollups = nullptr);
+
+    // Handles one request line and returns the response line without its trailing newline.
+    // Safe to call from several threads at once.
+    std::string handle(const std::string& request);
+
+private:
+    std::string resolveColumn(const std::string& country, const std::string& variable) const;
+
+    const WeatherData& weatherData;
+    const RollupPyramid* rollups;
+    std::map<int, std::string> countryMenu;
+    LruCache<std::string, std::string> cache;
+};
+
+// Where and how the server listens.
+struct ServerOptions {
+    std::string address;   // "unix:/path/to/socket" or "tcp:PORT" (bound to 127.0.0.1 only)
+    size_t threads;        // Requests answered at once; 0 means one per hardware thread
+
+    ServerOptions() : threads(0) {}
+};
+
+// Listens on the address and answers client requests on a worker pool until the process is stopped.
+// Idle connections are polled and do not occupy a worker.
+// A stale Unix socket at the path is replaced; throws std::runtime_error if the path holds anything else,
+// another server is listening there, or the socket cannot be set up.
+void runQueryServer(QueryService& service, const ServerOptions& options);
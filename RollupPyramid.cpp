@@ -0,0 +1,309 @@
+// RollupPyramid.cpp
+#include "RollupPyramid.h"
+#include "BinaryFormat.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+const char rollupMagic[8] = {'W', 'D', 'R', 'O', 'L', 'L', '0', '1'};
+const uint32_t rollupVersion = 2;
+
+// Bucket sizes of the pyramid levels, finest first.
+const int levelCount = 5;
+const BucketSize levelSizes[levelCount] = {BucketSize::Hour, BucketSize::Day, BucketSize::Week, BucketSize::Month, BucketSize::Year};
+const int yearLevel = 4;
+
+// Bytes of one stored bucket: ten 8-byte fields in BucketStats order.
+const size_t recordSize = 80;
+
+// Fixed-size header at the start of every rollup file.
+struct RollupHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t columnCount;
+    int64_t sourceModifiedTime;
+    uint64_t sourceSize;
+    uint64_t payloadSize;         // Bytes following the header
+    uint64_t checksum;            // Checksum of the payload
+};
+
+int levelIndex(BucketSize size) {
+    for (int i = 0; i < levelCount; ++i) {
+        if (levelSizes[i] == size) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Level whose buckets tile the buckets of `levelIndex`. Weeks straddle months, so months split into days.
+int finerLevel(int levelIndex) {
+    return levelSizes[levelIndex] == BucketSize::Month ? levelIndex - 2 : levelIndex - 1;
+}
+
+void writeRecord(char* p, const BucketStats& bucket) {
+    int64_t integers[4] = {bucket.start, static_cast<int64_t>(bucket.count), bucket.openTime, bucket.closeTime};
+    std::memcpy(p, &integers[0], 8);
+    std::memcpy(p + 8, &bucket.open, 8);
+    std::memcpy(p + 16, &bucket.high, 8);
+    std::memcpy(p + 24, &bucket.low, 8);
+    std::memcpy(p + 32, &bucket.close, 8);
+    std::memcpy(p + 40, &integers[1], 8);
+    std::memcpy(p + 48, &bucket.mean, 8);
+    std::memcpy(p + 56, &bucket.m2, 8);
+    std::memcpy(p + 64, &integers[2], 8);
+    std::memcpy(p + 72, &integers[3], 8);
+}
+
+BucketStats readRecord(const char* p) {
+    BucketStats bucket;
+    int64_t start, count, openTime, closeTime;
+    std::memcpy(&start, p, 8);
+    std::memcpy(&bucket.open, p + 8, 8);
+    std::memcpy(&bucket.high, p + 16, 8);
+    std::memcpy(&bucket.low, p + 24, 8);
+    std::memcpy(&bucket.close, p + 32, 8);
+    std::memcpy(&count, p + 40, 8);
+    std::memcpy(&bucket.mean, p + 48, 8);
+    std::memcpy(&bucket.m2, p + 56, 8);
+    std::memcpy(&openTime, p + 64, 8);
+    std::memcpy(&closeTime, p + 72, 8);
+    bucket.start = start;
+    bucket.count = static_cast<size_t>(count);
+    bucket.openTime = openTime;
+    bucket.closeTime = closeTime;
+    return bucket;
+}
+
+// Index of the first bucket starting at or after `start`.
+size_t lowerBound(const std::vector<BucketStats>& buckets, long long start) {
+    return static_cast<size_t>(std::lower_bound(buckets.begin(), buckets.end(), start,
+                                                [](const BucketStats& b, long long s) { return b.start < s; }) - buckets.begin());
+}
+
+} // namespace
+
+RollupPyramid::RollupPyramid(const std::vector<std::string>& columns) : columnNames(columns) {}
+
+// Every level is aggregated from the raw rows rather than merged from the level below, so its buckets
+// are bit-identical to aggregateBuckets and candles() matches the non-rollup path exactly.
+
+void RollupPyramid::build(const WeatherData& weatherData) {
+    PROFILE_SCOPE("rollup build");
+    std::vector<ColumnLevels*> targets;
+    for (const auto& name : columnNames) {
+        if (!weatherData.column(name)) {
+            throw std::runtime_error("Column not found: " + name);
+        }
+        targets.push_back(&columns[name]);
+    }
+    parallelFor(columnNames.size() * levelCount, [&](size_t task) {
+        size_t c = task / levelCount;
+        int level = static_cast<int>(task % levelCount);
+        targets[c]->levels[level] = aggregateBuckets(weatherData.timestamps(), *weatherData.column(columnNames[c]), levelSizes[level]);
+    });
+}
+
+bool RollupPyramid::load(const std::string& path, const SnapshotSource& source) {
+    PROFILE_SCOPE("rollup load");
+    if (!hostIsLittleEndian()) {
+        return false;
+    }
+    SnapshotSource cached;
+    if (!statSnapshotSource(path, cached)) {
+        return false; // Not built yet
+    }
+
+    MappedFile file(path);
+    if (file.size() < sizeof(RollupHeader)) {
+        return false;
+    }
+    RollupHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, rollupMagic, sizeof(rollupMagic)) != 0 || header.version != rollupVersion ||
+        header.sourceModifiedTime != source.modifiedTime || header.sourceSize != source.size ||
+        header.columnCount != columnNames.size() || header.payloadSize != file.size() - sizeof(RollupHeader)) {
+        return false;
+    }
+
+    const char* payload = file.data() + sizeof(RollupHeader);
+    const char* end = payload + header.payloadSize;
+    if (payloadChecksum(payload, header.payloadSize) != header.checksum) {
+        return false;
+    }
+    const char* p = payload;
+    if (!matchNames(p, end, payload, columnNames)) {
+        return false;
+    }
+
+    std::map<std::string, ColumnLevels> loaded;
+    for (const auto& name : columnNames) {
+        ColumnLevels& column = loaded[name];
+        for (auto& level : column.levels) {
+            uint64_t count;
+            if (end - p < 8) return false;
+            std::memcpy(&count, p, 8);
+            p += 8;
+            if (static_cast<uint64_t>(end - p) / recordSize < count) return false;
+            level.reserve(static_cast<size_t>(count));
+            for (uint64_t i = 0; i < count; ++i, p += recordSize) {
+                level.push_back(readRecord(p));
+            }
+        }
+    }
+    if (p != end) {
+        return false;
+    }
+    columns.swap(loaded);
+    return true;
+}
+
+void RollupPyramid::save(const std::string& path, const SnapshotSource& source) const {
+    if (!hostIsLittleEndian()) {
+        throw std::runtime_error("Rollups are only supported on little-endian hosts.");
+    }
+
+    std::vector<char> payload;
+    appendNames(payload, columnNames);
+    for (const auto& name : columnNames) {
+        for (const auto& level : columnLevels(name).levels) {
+            uint64_t count = level.size();
+            size_t offset = payload.size();
+            payload.resize(offset + 8 + level.size() * recordSize);
+            std::memcpy(&payload[offset], &count, 8);
+            char* p = &payload[offset + 8];
+            for (const auto& bucket : level) {
+                writeRecord(p, bucket);
+                p += recordSize;
+            }
+        }
+    }
+
+    RollupHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, rollupMagic, sizeof(rollupMagic));
+    header.version = rollupVersion;
+    header.columnCount = static_cast<uint32_t>(columnNames.size());
+    header.sourceModifiedTime = source.modifiedTime;
+    header.sourceSize = source.size;
+    header.payloadSize = payload.size();
+    header.checksum = payloadChecksum(payload.data(), payload.size());
+    replaceFile(path, &header, sizeof(header), payload);
+}
+
+const RollupPyramid::ColumnLevels& RollupPyramid::columnLevels(const std::string& column) const {
+    auto it = columns.find(column);
+    if (it == columns.end()) {
+        throw std::runtime_error("Column not in rollups: " + column);
+    }
+    return it->second;
+}
+
+const std::vector<BucketStats>& RollupPyramid::level(const std::string& column, BucketSize size) const {
+    int index = levelIndex(size);
+    if (index < 0) {
+        throw std::runtime_error(std::string("No rollup level for ") + bucketSizeName(size) + " buckets.");
+    }
+    return columnLevels(column).levels[index];
+}
+
+// Takes the whole buckets of this level inside [from, to) and hands the ragged edges to the level below,
+// like the canonical cover of a segment tree.
+
+void RollupPyramid::cover(const ColumnLevels& column, int levelIndex, long long from, long long to, BucketStats& summary) const {
+    if (from >= to) {
+        return;
+    }
+    const std::vector<BucketStats>& buckets = column.levels[levelIndex];
+    long long first = from;
+    long long last = to;
+    if (levelIndex > 0) {
+        BucketSize size = levelSizes[levelIndex];
+        first = bucketStart(from, size);
+        if (first < from) {
+            first = nextBucketStart(first, size);
+        }
+        last = bucketStart(to, size); // Buckets starting before `last` end by `to`
+        if (first >= last) {
+            cover(column, finerLevel(levelIndex), from, to, summary);
+            return;
+        }
+        cover(column, finerLevel(levelIndex), from, first, summary);
+    }
+    for (size_t i = lowerBound(buckets, first); i < buckets.size() && buckets[i].start < last; ++i) {
+        mergeBucketStats(summary, buckets[i]);
+    }
+    if (levelIndex > 0) {
+        cover(column, finerLevel(levelIndex), last, to, summary);
+    }
+}
+
+BucketStats RollupPyramid::summarize(const std::string& column, long long from, long long to) const {
+    BucketStats summary;
+    summary.start = from;
+    summary.open = summary.high = summary.low = summary.close = 0.0;
+    summary.count = 0;
+    summary.mean = 0.0;
+    summary.m2 = 0.0;
+    summary.openTime = summary.closeTime = from;
+    // Clamp to the hours that hold readings so unbounded sentinels never reach the calendar arithmetic
+    const ColumnLevels& levels = columnLevels(column);
+    const std::vector<BucketStats>& hours = levels.levels[0];
+    if (hours.empty()) {
+        return summary;
+    }
+    cover(levels, yearLevel, std::max(from, hours.front().start), std::min(to, hours.back().start + 3600), summary);
+    return summary;
+}
+
+// Converts the buckets from the last one before `from` through the first one at or after `to`, so the
+// first open and any flat gap candles come out as they do in the full series, then cuts to [from, to).
+
+CandleSeries RollupPyramid::candles(const std::string& column, BucketSize size, long long from, long long to, Arena* arena) const {
+    const std::vector<BucketStats>& buckets = level(column, size);
+    size_t first = lowerBound(buckets, from);
+    size_t last = lowerBound(buckets, to);
+    first = first > 0 ? first - 1 : 0;
+    last = std::min(last + 1, buckets.size());
+    CandleSeries series = bucketsToSeries(buckets.data() + first, last - first, size, arena);
+    std::pair<size_t, size_t> range = series.timeRange(from, to);
+    return series.slice(range.first, range.second);
+}
+
+std::string rollupPathFor(const std::string& filename) {
+    return filename + ".rollup";
+}
+
+RollupPyramid loadRollups(const std::string& filename, const WeatherData& weatherData, const std::vector<std::string>& columns) {
+    RollupPyramid pyramid(columns);
+    SnapshotSource source;
+    bool haveSource = statSnapshotSource(filename, source);
+    const std::string path = rollupPathFor(filename);
+    if (haveSource) {
+        try {
+            if (pyramid.load(path, source)) {
+                std::cerr << "Debug: Loaded rollups for " << columns.size() << " columns.\n";
+                return pyramid;
+            }
+        } catch (const std::exception&) {
+            // An unreadable rollup file is just a cache miss
+        }
+    }
+
+    pyramid.build(weatherData);
+    if (haveSource) {
+        try {
+            pyramid.save(path, source);
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: " << e.what() << std::endl;
+        }
+    }
+    return pyramid;
+}
@@ -0,0 +1,54 @@
+// RollupPyramid.h
+#pragma once
+#include "BucketAggregator.h"
+#include "CandleSeries.h"
+#include "WeatherSnapshot.h"
+#include "WeatherData.h"
+#include "Arena.h"
+#include <vector>
+#include <string>
+#include <map>
+
+// RollupPyramid class that keeps every column pre-aggregated at five resolutions (hour, day, week, month,
+// year), so a time range is answered from precomputed buckets instead of the raw rows. A range summary
+// combines whole years, then whole months and days at its edges, then hours: at most a few dozen
+// buckets however long the range. Each bucket holds OHLC, count, mean and the Welford sum of squared
+// deviations (the stable form of sum and sum of squares).
+class RollupPyramid {
+public:
+    // Constructor for an empty pyramid over the given columns; fill it with build() or load().
+    explicit RollupPyramid(const std::vector<std::string>& columns);
+    // Aggregates every level of every column from the loaded rows.
+    void build(const WeatherData& weatherData);
+    // Loads the pyramid saved at `path` if it was built from this exact source file and column list.
+    bool load(const std::string& path, const SnapshotSource& source);
+    // Saves the pyramid atomically. Throws on I/O failure.
+    void save(const std::string& path, const SnapshotSource& source) const;
+
+    // Buckets of one level in time order; throws for unknown columns.
+    const std::vector<BucketStats>& level(const std::string& column, BucketSize size) const;
+    // Statistics of the readings in the hours starting in [from, to) (UTC epoch seconds); count is 0 when
+    // there are none. Bounds are effectively rounded up to whole hours.
+    BucketStats summarize(const std::string& column, long long from, long long to) const;
+    // Candlesticks whose bucket starts in [from, to), equal to the same slice of aggregateSeries over all
+    // rows (opens continue from the bucket before `from`).
+    CandleSeries candles(const std::string& column, BucketSize size, long long from, long long to, Arena* arena = nullptr) const;
+private:
+    // Levels in fine-to-coarse order: hour, day, week, month, year.
+    struct ColumnLevels {
+        std::vector<BucketStats> levels[5];
+    };
+
+    const ColumnLevels& columnLevels(const std::string& column) const;
+    // Merges the readings of [from, to) into `summary` using whole buckets of `levelIndex` and finer.
+    void cover(const ColumnLevels& column, int levelIndex, long long from, long long to, BucketStats& summary) const;
+
+    std::vector<std::string> columnNames;
+    std::map<std::string, ColumnLevels> columns;
+};
+
+// Path of the rollups that belong to a CSV file ("<file>.rollup").
+std::string rollupPathFor(const std::string& filename);
+
+// Loads the pyramid saved next to the CSV when it is current, otherwise builds it and refreshes the file.
+RollupPyramid loadRollups(const std::string& filename, const WeatherData& weatherData, const std::vector<std::string>& columns);
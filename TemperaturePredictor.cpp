@@ -1,62 +1,150 @@
 // TemperaturePredictor.cpp
 #include "TemperaturePredictor.h"
-#include <numeric>
+#include "FastParse.h"
+#include "Profiler.h"
 #include <cmath>
 #include <iostream>
+#include <stdexcept>
 
-//Constructor that initializes the historical data.
+namespace {
+
+// Labels may be yearly ("1980") or finer buckets ("1980-07"); both parse to the bucket start
+CompactCandle compactCandle(const Candlestick& candle) {
+    CompactCandle compact;
+    const char* label = candle.date.c_str();
+    if (!parseTimestamp(label, label + candle.date.size(), compact.start)) {
+        throw std::runtime_error("Invalid date in candlestick: " + candle.date);
+    }
+    compact.open = candle.open;
+    compact.high = candle.high;
+    compact.low = candle.low;
+    compact.close = candle.close;
+    return compact;
+}
+
+} // namespace
+
+TemperaturePredictor::TemperaturePredictor()
+    : count(0), meanYear(0.0), meanTemperature(0.0), yearSquares(0.0), yearTemperature(0.0),
+      bandCount(0), highOffset(0.0), lowOffset(0.0) {}
+
+//Constructor that feeds the historical data through the running statistics without keeping a copy.
  
-TemperaturePredictor::TemperaturePredictor(const std::vector<Candlestick>& historicalData) : data(historicalData) {}
+TemperaturePredictor::TemperaturePredictor(const std::vector<Candlestick>& historicalData) : TemperaturePredictor() {
+    for (const auto& candle : historicalData) {
+        addCandlestick(candle);
+    }
+}
+
+TemperaturePredictor::TemperaturePredictor(const CandleSeries& historicalData) : TemperaturePredictor() {
+    for (size_t i = 0; i < historicalData.size(); ++i) {
+        addCandle(historicalData[i]);
+    }
+}
 
-//Calculates the slope (m) and intercept (c) for linear regression.
+// Welford-style update of the means and co-deviation sums.
 
-void TemperaturePredictor::calculateLinearRegression(double& m, double& c) {
-    int n = data.size();
-    if (n == 0) {
-        throw std::runtime_error("No data available for prediction.");
+void TemperaturePredictor::addObservation(double year, double temperature) {
+    ++count;
+    double dx = year - meanYear;
+    meanYear += dx / count;
+    meanTemperature += (temperature - meanTemperature) / count;
+    yearSquares += dx * (year - meanYear);
+    yearTemperature += dx * (temperature - meanTemperature);
+}
+
+// Exact inverse of addObservation.
+
+void TemperaturePredictor::removeObservation(double year, double temperature) {
+    if (count == 0) {
+        throw std::runtime_error("No observations to remove.");
     }
-    
-    std::vector<double> years;
-    std::vector<double> temperatures;
-    
-    for (const auto& candle : data) {
-        years.push_back(std::stod(candle.date));
-        temperatures.push_back(candle.close);
+    if (count == 1) {
+        count = 0;
+        meanYear = meanTemperature = yearSquares = yearTemperature = 0.0;
+        return;
     }
-    
-    double sum_x = std::accumulate(years.begin(), years.end(), 0.0);
-    double sum_y = std::accumulate(temperatures.begin(), temperatures.end(), 0.0);
-    double sum_xy = 0.0;
-    double sum_x2 = 0.0;
-    
-    for (int i = 0; i < n; ++i) {
-        sum_xy += years[i] * temperatures[i];
-        sum_x2 += years[i] * years[i];
+
+    double previousMeanYear = meanYear - (year - meanYear) / (count - 1);
+    double previousMeanTemperature = meanTemperature - (temperature - meanTemperature) / (count - 1);
+    double dx = year - previousMeanYear;
+    yearSquares -= dx * (year - meanYear);
+    yearTemperature -= dx * (temperature - meanTemperature);
+    meanYear = previousMeanYear;
+    meanTemperature = previousMeanTemperature;
+    --count;
+
+    // Guard against tiny negative drift after many removals
+    if (yearSquares < 0.0) {
+        yearSquares = 0.0;
     }
-    
-    double denominator = n * sum_x2 - sum_x * sum_x;
-    if (denominator == 0) {
+}
+
+void TemperaturePredictor::addCandlestick(const Candlestick& candle) {
+    addCandle(compactCandle(candle));
+}
+
+void TemperaturePredictor::removeCandlestick(const Candlestick& candle) {
+    removeCandle(compactCandle(candle));
+}
+
+// Regresses on the fractional year of the bucket start.
+
+void TemperaturePredictor::addCandle(const CompactCandle& candle) {
+    addObservation(decimalYearOfEpochSeconds(candle.start), candle.close);
+    ++bandCount;
+    highOffset += (candle.high - candle.close - highOffset) / bandCount;
+    lowOffset += (candle.low - candle.close - lowOffset) / bandCount;
+}
+
+void TemperaturePredictor::removeCandle(const CompactCandle& candle) {
+    removeObservation(decimalYearOfEpochSeconds(candle.start), candle.close);
+    if (bandCount <= 1) {
+        bandCount = 0;
+        highOffset = lowOffset = 0.0;
+        return;
+    }
+    --bandCount;
+    highOffset -= (candle.high - candle.close - highOffset) / bandCount;
+    lowOffset -= (candle.low - candle.close - lowOffset) / bandCount;
+}
+
+size_t TemperaturePredictor::observationCount() const {
+    return count;
+}
+
+//Calculates the slope (m) and intercept (c) for linear regression from the running statistics.
+
+void TemperaturePredictor::calculateLinearRegression(double& m, double& c) const {
+    if (count == 0) {
+        throw std::runtime_error("No data available for prediction.");
+    }
+    if (yearSquares == 0) {
         throw std::runtime_error("Denominator in linear regression calculation is zero.");
     }
     
-    m = (n * sum_xy - sum_x * sum_y) / denominator;
-    c = (sum_y * sum_x2 - sum_x * sum_xy) / denominator;
+    m = yearTemperature / yearSquares;
+    c = meanTemperature - m * meanYear;
 }
 
 // Predicts temperatures for a given range of years using linear regression.
 
-std::vector<Candlestick> TemperaturePredictor::predictTemperatures(int startYear, int endYear) {
-    std::vector<Candlestick> predictions;
+ArenaVector<Candlestick> TemperaturePredictor::predictTemperatures(int startYear, int endYear, Arena* arena) const {
+    PROFILE_SCOPE("predict");
+    ArenaVector<Candlestick> predictions{ArenaAllocator<Candlestick>(arena)};
     
     double m, c;
     calculateLinearRegression(m, c);
+    if (startYear <= endYear) {
+        predictions.reserve(static_cast<size_t>(static_cast<long long>(endYear) - startYear + 1));
+    }
     
     for (int year = startYear; year <= endYear; ++year) {
         double predictedClose = m * year + c;
-        // For simplicity, set open = close = predictedClose, high = predictedClose + 1, low = predictedClose - 1
-        double predictedOpen = predictedClose;
-        double predictedHigh = predictedClose + 1.0;
-        double predictedLow = predictedClose - 1.0;
+        // Open follows the previous year's close; high and low keep the historical spread around the close
+        double predictedOpen = m * (year - 1) + c;
+        double predictedHigh = predictedClose + highOffset;
+        double predictedLow = predictedClose + lowOffset;
         
         predictions.emplace_back(std::to_string(year), predictedOpen, predictedClose, predictedHigh, predictedLow);
     }
@@ -1,19 +1,46 @@
 // TemperaturePredictor.h
 #pragma once
 #include "Candlestick.h"
+#include "CandleSeries.h"
 #include <vector>
 #include <string>
 #include <utility>
+#include <cstddef>
 
 // TemperaturePredictor class to predict future temperatures based on historical data.
+// Keeps only running regression statistics, so observations can be added or removed in O(1).
 class TemperaturePredictor {
 public:
-  // Constructor that takes historical candlestick data.
+    // Constructor for an empty predictor that is fed with addObservation.
+    TemperaturePredictor();
+    // Constructor that takes historical candlestick data (regressing closing temperature on fractional year).
     TemperaturePredictor(const std::vector<Candlestick>& historicalData);
-    // Predicts temperatures for a given range of years.
-    std::vector<Candlestick> predictTemperatures(int startYear, int endYear);
+    // Same for a compact series, without parsing any dates.
+    TemperaturePredictor(const CandleSeries& historicalData);
+    // Adds one (year, temperature) observation.
+    void addObservation(double year, double temperature);
+    // Removes an observation previously added, e.g. the oldest one of a sliding window.
+    void removeObservation(double year, double temperature);
+    // Adds or removes a candlestick's (fractional year, close) observation.
+    void addCandlestick(const Candlestick& candle);
+    void removeCandlestick(const Candlestick& candle);
+    void addCandle(const CompactCandle& candle);
+    void removeCandle(const CompactCandle& candle);
+    // Number of observations currently in the fit.
+    size_t observationCount() const;
+    // Predicts temperatures for a given range of years. Open is the previous year's predicted close, and
+    // high/low keep the average distance of the historical candlesticks' high/low from their close.
+    // The predictions are allocated in arena when one is given.
+    ArenaVector<Candlestick> predictTemperatures(int startYear, int endYear, Arena* arena = nullptr) const;
 private:
-    std::vector<Candlestick> data;
+    size_t count;
+    double meanYear;
+    double meanTemperature;
+    double yearSquares;      // Sum of squared year deviations from the mean
+    double yearTemperature;  // Sum of co-deviations of year and temperature
+    size_t bandCount;        // Candlesticks contributing to the band offsets
+    double highOffset;       // Mean of high - close
+    double lowOffset;        // Mean of low - close
     //  Calculates the slope (m) and intercept (c) for linear regression.
-    void calculateLinearRegression(double& m, double& c);
-};
\ No newline at end of file
+    void calculateLinearRegression(double& m, double& c) const;
+};
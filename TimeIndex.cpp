@@ -0,0 +1,47 @@
+// TimeIndex.cpp
+#include "TimeIndex.h"
+#include "FastParse.h"
+#include "Timestamp.h"
+#include <algorithm>
+#include <stdexcept>
+
+TimeIndex::TimeIndex(const std::vector<Candlestick>& candlesticks) : data(candlesticks.data()) {
+    extend(candlesticks);
+}
+
+void TimeIndex::extend(const std::vector<Candlestick>& candlesticks) {
+    if (candlesticks.size() < starts.size()) {
+        throw std::runtime_error("Candlesticks were removed since they were indexed.");
+    }
+    data = candlesticks.data();
+    starts.reserve(candlesticks.size());
+    for (size_t i = starts.size(); i < candlesticks.size(); ++i) {
+        const Candlestick& candle = candlesticks[i];
+        long long start;
+        const char* label = candle.date.c_str();
+        if (!parseTimestamp(label, label + candle.date.size(), start)) {
+            throw std::runtime_error("Invalid date in candlestick: " + candle.date);
+        }
+        if (!starts.empty() && start < starts.back()) {
+            throw std::runtime_error("Candlesticks must be sorted by date to be indexed.");
+        }
+        starts.push_back(start);
+    }
+}
+
+CandlestickRange TimeIndex::all() const {
+    return CandlestickRange(data, data + starts.size());
+}
+
+CandlestickRange TimeIndex::yearRange(int startYear, int endYear) const {
+    if (startYear > endYear) {
+        return CandlestickRange(data, data);
+    }
+    return timeRange(daysFromCivil(startYear, 1, 1) * 86400, daysFromCivil(static_cast<long long>(endYear) + 1, 1, 1) * 86400);
+}
+
+CandlestickRange TimeIndex::timeRange(long long from, long long to) const {
+    auto first = std::lower_bound(starts.begin(), starts.end(), from);
+    auto last = std::lower_bound(first, starts.end(), to);
+    return CandlestickRange(data + (first - starts.begin()), data + (last - starts.begin()));
+}
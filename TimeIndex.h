@@ -0,0 +1,26 @@
+// TimeIndex.h
+#pragma once
+#include "Candlestick.h"
+#include "CandlestickRange.h"
+#include <vector>
+#include <cstddef>
+
+// TimeIndex class that parses the date of each candlestick once so date-range queries over a
+// date-sorted series are answered by binary search, returning views instead of copies.
+class TimeIndex {
+public:
+    // Constructor that indexes candlesticks sorted by date; throws if a date cannot be parsed or the series is unsorted.
+    explicit TimeIndex(const std::vector<Candlestick>& candlesticks);
+    // Indexes candlesticks appended to the same vector since it was indexed (it may have reallocated),
+    // parsing only the new dates.
+    void extend(const std::vector<Candlestick>& candlesticks);
+    // Every indexed candlestick.
+    CandlestickRange all() const;
+    // Candlesticks whose period starts within the years [startYear, endYear].
+    CandlestickRange yearRange(int startYear, int endYear) const;
+    // Candlesticks whose period starts in [from, to), in UTC epoch seconds.
+    CandlestickRange timeRange(long long from, long long to) const;
+private:
+    const Candlestick* data;
+    std::vector<long long> starts;
+};
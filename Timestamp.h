@@ -0,0 +1,48 @@
+// Timestamp.h
+#pragma once
+
+// Calendar helpers for UTC timestamps stored as seconds since 1970-01-01 (proleptic Gregorian).
+
+// Days since 1970-01-01 for a civil date.
+inline long long daysFromCivil(long long year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const long long era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    const unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<long long>(dayOfEra) - 719468;
+}
+
+// Civil date for a count of days since 1970-01-01.
+inline void civilFromDays(long long days, long long& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    const long long era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = static_cast<long long>(yearOfEra) + era * 400 + (month <= 2);
+}
+
+// Whole days since 1970-01-01 containing the timestamp (floors for times before the epoch).
+inline long long daysFromEpochSeconds(long long seconds) {
+    return (seconds >= 0 ? seconds : seconds - 86399) / 86400;
+}
+
+// Calendar year of a timestamp.
+inline int yearOfEpochSeconds(long long seconds) {
+    long long year;
+    unsigned month, day;
+    civilFromDays(daysFromEpochSeconds(seconds), year, month, day);
+    return static_cast<int>(year);
+}
+
+// Timestamp as a fractional calendar year (e.g. 1980.5 in early July 1980).
+inline double decimalYearOfEpochSeconds(long long seconds) {
+    int year = yearOfEpochSeconds(seconds);
+    long long yearStart = daysFromCivil(year, 1, 1) * 86400;
+    long long nextYearStart = daysFromCivil(year + 1, 1, 1) * 86400;
+    return year + static_cast<double>(seconds - yearStart) / static_cast<double>(nextYearStart - yearStart);
+}
@@ -0,0 +1,419 @@
+// WeatherData.cpp
+#include "WeatherData.h"
+#include "MappedFile.h"
+#include "FastParse.h"
+#include "Timestamp.h"
+#include "Parallel.h"
+#include "WeatherSnapshot.h"
+#include "ColumnarFile.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <iostream>
+#include <limits>
+#include <cmath>
+
+namespace {
+
+// Rows parsed by one worker: its own timestamp and value buffers, stitched together afterwards.
+struct ParsedChunk {
+    std::vector<long long> timestamps;
+    std::vector<std::vector<double>> values;
+    std::vector<std::string> warnings;
+};
+
+// Minimum bytes per chunk so small files are not split across threads for nothing
+const size_t minChunkBytes = 1 << 20;
+
+// Parses the complete lines in [p, end), routing each field to the output column its header position maps to.
+void parseLines(const char* p, const char* end, const std::vector<int>& slots, ParsedChunk& chunk) {
+    const double missing = std::numeric_limits<double>::quiet_NaN();
+
+    // Rough row estimate from the first line so the buffers grow without repeated reallocation
+    if (p != end) {
+        const char* firstEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        size_t lineLength = firstEnd ? static_cast<size_t>(firstEnd - p) + 1 : static_cast<size_t>(end - p);
+        size_t estimate = static_cast<size_t>(end - p) / lineLength + 1;
+        chunk.timestamps.reserve(estimate);
+        for (auto& column : chunk.values) {
+            column.reserve(estimate);
+        }
+    }
+
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        const char* next = lineEnd == end ? end : lineEnd + 1;
+        if (lineEnd > p && lineEnd[-1] == '\r') {
+            --lineEnd;
+        }
+        if (lineEnd == p) {
+            p = next;
+            continue; // Blank line
+        }
+
+        const char* fieldEnd = static_cast<const char*>(std::memchr(p, ',', lineEnd - p));
+        if (!fieldEnd) {
+            fieldEnd = lineEnd;
+        }
+        long long timestamp;
+        if (!parseTimestamp(p, fieldEnd, timestamp)) {
+            chunk.warnings.push_back("Warning: Invalid date format '" + std::string(p, fieldEnd) + "'");
+            p = next;
+            continue;
+        }
+        chunk.timestamps.push_back(timestamp);
+
+        size_t col = 1;
+        const char* field = fieldEnd;
+        while (field < lineEnd && col < slots.size()) {
+            ++field; // Step over the comma
+            fieldEnd = field;
+            while (fieldEnd < lineEnd && *fieldEnd != ',') {
+                ++fieldEnd;
+            }
+            if (slots[col] >= 0) {
+                double value;
+                if (fieldEnd == field || parseDouble(field, fieldEnd, value) != fieldEnd) {
+                    value = missing; // Leave missing or malformed readings as NaN so rows stay aligned
+                }
+                chunk.values[slots[col]].push_back(value);
+            }
+            field = fieldEnd;
+            ++col;
+        }
+        // Pad short rows so every column keeps the same length as the timestamps
+        for (; col < slots.size(); ++col) {
+            if (slots[col] >= 0) {
+                chunk.values[slots[col]].push_back(missing);
+            }
+        }
+        p = next;
+    }
+}
+
+} // namespace
+
+WeatherData::WeatherData(const std::string& filename, const std::vector<std::string>& columnNames, const std::map<int, std::string>& countryMenu)
+    : WeatherData(filename, columnNames, countryMenu, std::numeric_limits<long long>::min(), std::numeric_limits<long long>::max()) {
+}
+
+// Decodes a columnar file directly. A CSV is loaded from the binary snapshot when it is current, otherwise
+// parsed, and the snapshot rewritten with the parsed columns plus those it already held.
+
+WeatherData::WeatherData(const std::string& filename, const std::vector<std::string>& columnNames, const std::map<int, std::string>& countryMenu,
+                         long long from, long long to)
+    : sourceFile(filename), columnarSource(false), committedRows(0), committedBytes(0) {
+    PROFILE_SCOPE("load");
+    mapColumns(columnNames, countryMenu);
+    if (isColumnarFile(filename)) {
+        loadColumnar(filename, from, to);
+        return;
+    }
+
+    std::vector<std::string> loadedColumns;
+    for (const auto& it : countryMenu) {
+        loadedColumns.push_back(it.second);
+    }
+
+    SnapshotSource source;
+    bool haveSource = statSnapshotSource(filename, source);
+    const std::string snapshotPath = snapshotPathFor(filename);
+
+    if (haveSource) {
+        std::vector<std::vector<double>> values;
+        try {
+            if (readSnapshot(snapshotPath, source, columnNames, loadedColumns, timestampColumn, values)) {
+                for (size_t i = 0; i < loadedColumns.size(); ++i) {
+                    columns[loadedColumns[i]].swap(values[i]);
+                }
+                MappedFile file(filename);
+                const char* begin = file.data();
+                const char* headerEnd = begin ? static_cast<const char*>(std::memchr(begin, '\n', file.size())) : nullptr;
+                markCommitted(begin, headerEnd ? headerEnd + 1 : begin + file.size(), begin + file.size());
+                std::cerr << "Debug: Loaded " << timestampColumn.size() << " rows and " << columns.size() << " columns from snapshot.\n";
+                return;
+            }
+        } catch (const std::exception&) {
+            // An unreadable snapshot is just a cache miss
+        }
+        timestampColumn.clear();
+    }
+
+    loadCsv(filename);
+
+    if (haveSource) {
+        // Carry over the columns the snapshot holds for other projections, so alternating between
+        // projections does not keep evicting them
+        std::vector<std::string> storedColumns = loadedColumns;
+        std::vector<std::vector<double>> carried;
+        try {
+            std::vector<std::string> previous, others;
+            if (snapshotColumns(snapshotPath, source, columnNames, previous)) {
+                for (const auto& name : previous) {
+                    if (columns.find(name) == columns.end()) {
+                        others.push_back(name);
+                    }
+                }
+            }
+            std::vector<long long> previousTimestamps;
+            if (!others.empty() && readSnapshot(snapshotPath, source, columnNames, others, previousTimestamps, carried) &&
+                previousTimestamps.size() == timestampColumn.size()) {
+                storedColumns.insert(storedColumns.end(), others.begin(), others.end());
+            } else {
+                carried.clear();
+            }
+        } catch (const std::exception&) {
+            carried.clear(); // Rewrite the snapshot with this projection only
+        }
+
+        std::vector<const std::vector<double>*> values;
+        for (const auto& name : loadedColumns) {
+            values.push_back(&columns[name]);
+        }
+        for (const auto& column : carried) {
+            values.push_back(&column);
+        }
+        try {
+            writeSnapshot(snapshotPath, source, columnNames, storedColumns, timestampColumn, values);
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: " << e.what() << std::endl;
+        }
+    }
+}
+
+void WeatherData::mapColumns(const std::vector<std::string>& columnNames, const std::map<int, std::string>& countryMenu) {
+    // Map each header position to the output column it fills (-1 for columns we skip)
+    fieldSlots.assign(columnNames.size(), -1);
+    slotTargets.clear();
+    for (const auto& it : countryMenu) {
+        for (size_t i = 1; i < columnNames.size(); ++i) {
+            if (columnNames[i] == it.second) {
+                fieldSlots[i] = static_cast<int>(slotTargets.size());
+                slotTargets.push_back(&columns[it.second]);
+                break;
+            }
+        }
+        if (columns.find(it.second) == columns.end()) {
+            throw std::runtime_error("Column not found: " + it.second);
+        }
+    }
+}
+
+// Maps the file, splits it into newline-aligned chunks parsed on worker threads, then joins them in order.
+
+void WeatherData::loadCsv(const std::string& filename) {
+    PROFILE_SCOPE("csv parse");
+    MappedFile file(filename);
+    const std::vector<int>& slots = fieldSlots;
+    const std::vector<std::vector<double>*>& targets = slotTargets;
+
+    const char* fileBegin = file.data();
+    const char* begin = fileBegin;
+    const char* end = begin + file.size();
+
+    // Skip header, already parsed by getColumnNames
+    const char* headerEnd = begin ? static_cast<const char*>(std::memchr(begin, '\n', file.size())) : nullptr;
+    begin = headerEnd ? headerEnd + 1 : end;
+
+    // Cut the body into roughly equal chunks, moving each cut forward to the next line start
+    size_t bodySize = static_cast<size_t>(end - begin);
+    size_t chunkCount = std::max<size_t>(1, std::min(workerCount(), bodySize / minChunkBytes));
+    std::vector<const char*> cuts(1, begin);
+    for (size_t i = 1; i < chunkCount; ++i) {
+        const char* cut = begin + bodySize * i / chunkCount;
+        if (cut < cuts.back()) {
+            cut = cuts.back();
+        }
+        const char* newline = static_cast<const char*>(std::memchr(cut, '\n', end - cut));
+        cut = newline ? newline + 1 : end;
+        cuts.push_back(cut);
+    }
+    cuts.push_back(end);
+
+    std::vector<ParsedChunk> chunks(chunkCount);
+    for (auto& chunk : chunks) {
+        chunk.values.resize(targets.size());
+    }
+    parallelFor(chunkCount, [&](size_t i) {
+        PROFILE_SCOPE("csv parse chunk");
+        parseLines(cuts[i], cuts[i + 1], slots, chunks[i]);
+    });
+
+    // Stitch the chunk buffers together in file order
+    size_t totalRows = 0;
+    for (const auto& chunk : chunks) {
+        totalRows += chunk.timestamps.size();
+    }
+    timestampColumn.reserve(totalRows);
+    for (auto target : targets) {
+        target->reserve(totalRows);
+    }
+    for (auto& chunk : chunks) {
+        for (const auto& warning : chunk.warnings) {
+            std::cerr << warning << std::endl;
+        }
+        timestampColumn.insert(timestampColumn.end(), chunk.timestamps.begin(), chunk.timestamps.end());
+        for (size_t c = 0; c < targets.size(); ++c) {
+            targets[c]->insert(targets[c]->end(), chunk.values[c].begin(), chunk.values[c].end());
+        }
+        chunk = ParsedChunk(); // Release the chunk as soon as it has been copied
+    }
+    markCommitted(fileBegin, begin, end);
+    PROFILE_COUNT("rows parsed", totalRows);
+    PROFILE_COUNT("bytes read", file.size());
+
+    // Debug output
+    std::cerr << "Debug: Loaded " << timestampColumn.size() << " rows and " << columns.size() << " columns from CSV.\n";
+}
+
+// Decodes block by block on worker threads, each block straight into its place in the columns.
+
+void WeatherData::loadColumnar(const std::string& filename, long long from, long long to) {
+    PROFILE_SCOPE("columnar read");
+    ColumnarFile file(filename);
+    std::vector<size_t> indices;
+    std::vector<std::vector<double>*> targets;
+    for (auto& it : columns) {
+        int index = file.columnIndex(it.first);
+        if (index < 0) {
+            throw std::runtime_error("Column not found: " + it.first);
+        }
+        indices.push_back(static_cast<size_t>(index));
+        targets.push_back(&it.second);
+    }
+
+    std::vector<size_t> blocks = blocksForCandles(file, indices, from, to);
+    std::vector<size_t> offsets(1, 0);
+    size_t bytes = 0;
+    for (size_t block : blocks) {
+        offsets.push_back(offsets.back() + file.blockRowCount(block));
+        bytes += file.timestampChunkSize(block);
+        for (size_t index : indices) {
+            bytes += file.columnChunkSize(block, index);
+        }
+    }
+    timestampColumn.resize(offsets.back());
+    for (auto target : targets) {
+        target->resize(offsets.back());
+    }
+    parallelFor(blocks.size() * (targets.size() + 1), [&](size_t task) {
+        size_t c = task / blocks.size(), b = task % blocks.size();
+        if (c == 0) {
+            file.readTimestamps(blocks[b], timestampColumn.data() + offsets[b]);
+        } else {
+            file.readColumn(blocks[b], indices[c - 1], targets[c - 1]->data() + offsets[b]);
+        }
+    });
+    columnarSource = true;
+    committedRows = timestampColumn.size();
+    PROFILE_COUNT("blocks read", blocks.size());
+    PROFILE_COUNT("blocks skipped", file.blockCount() - blocks.size());
+    PROFILE_COUNT("bytes read", bytes);
+
+    std::cerr << "Debug: Loaded " << timestampColumn.size() << " rows and " << columns.size() << " columns from "
+              << blocks.size() << " of " << file.blockCount() << " columnar blocks.\n";
+}
+
+// The unterminated last line, if any, is the only row that can still change as the file grows.
+
+void WeatherData::markCommitted(const char* fileBegin, const char* body, const char* end) {
+    const char* tail = end;
+    if (end > body && end[-1] != '\n') {
+        while (tail > body && tail[-1] != '\n') {
+            --tail;
+        }
+    }
+    committedBytes = static_cast<size_t>(tail - fileBegin);
+
+    // The tail holds a row only if it starts with a valid timestamp
+    ParsedChunk scratch;
+    scratch.values.resize(slotTargets.size());
+    parseLines(tail, end, fieldSlots, scratch);
+    committedRows = timestampColumn.size() - scratch.timestamps.size();
+}
+
+// Drops the unterminated row loaded last time, if any, and parses from the end of the last committed row.
+// Only the pages holding new bytes are read, so the cost grows with the appended rows, not the history.
+
+size_t WeatherData::refresh() {
+    PROFILE_SCOPE("refresh");
+    if (columnarSource) {
+        throw std::runtime_error("Only CSV files can be followed for appended rows: " + sourceFile);
+    }
+    MappedFile file(sourceFile);
+    if (file.size() < committedBytes) {
+        throw std::runtime_error("File shrank since it was loaded: " + sourceFile);
+    }
+
+    const size_t previousRows = committedRows;
+    timestampColumn.resize(committedRows);
+    for (auto target : slotTargets) {
+        target->resize(committedRows);
+    }
+
+    const char* begin = file.data();
+    const char* from = begin + committedBytes;
+    const char* end = begin + file.size();
+    ParsedChunk chunk;
+    chunk.values.resize(slotTargets.size());
+    parseLines(from, end, fieldSlots, chunk);
+    PROFILE_COUNT("rows parsed", chunk.timestamps.size());
+    PROFILE_COUNT("bytes read", end - from);
+    for (const auto& warning : chunk.warnings) {
+        std::cerr << warning << std::endl;
+    }
+    timestampColumn.insert(timestampColumn.end(), chunk.timestamps.begin(), chunk.timestamps.end());
+    for (size_t c = 0; c < slotTargets.size(); ++c) {
+        slotTargets[c]->insert(slotTargets[c]->end(), chunk.values[c].begin(), chunk.values[c].end());
+    }
+
+    markCommitted(begin, from, end);
+    return committedRows - previousRows;
+}
+
+size_t WeatherData::committedRowCount() const {
+    return committedRows;
+}
+
+size_t WeatherData::rowCount() const {
+    return timestampColumn.size();
+}
+
+const std::vector<long long>& WeatherData::timestamps() const {
+    return timestampColumn;
+}
+
+const std::vector<double>* WeatherData::column(const std::string& name) const {
+    auto it = columns.find(name);
+    return it == columns.end() ? nullptr : &it->second;
+}
+
+// Builds each year label once per year rather than once per reading; CSVReader::readCSV returns this.
+
+ArenaVector<std::pair<std::string, double>> WeatherData::yearlySeries(const std::string& name, Arena* arena) const {
+    const std::vector<double>* values = column(name);
+    if (!values) {
+        throw std::runtime_error("Column not found: " + name);
+    }
+
+    ArenaVector<std::pair<std::string, double>> series{ArenaAllocator<std::pair<std::string, double>>(arena)};
+    series.reserve(values->size());
+    int currentYear = std::numeric_limits<int>::min();
+    std::string yearLabel;
+    for (size_t i = 0; i < values->size(); ++i) {
+        if (std::isnan((*values)[i])) {
+            continue;
+        }
+        int year = yearOfEpochSeconds(timestampColumn[i]);
+        if (year != currentYear) {
+            currentYear = year;
+            yearLabel = std::to_string(year);
+        }
+        series.emplace_back(yearLabel, (*values)[i]);
+    }
+    return series;
+}
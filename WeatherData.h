@@ -0,0 +1,55 @@
+// WeatherData.h
+#pragma once
+#include "Arena.h"
+#include <vector>
+#include <string>
+#include <map>
+#include <utility>
+
+// WeatherData class that reads the CSV (or a columnar file) once and keeps one contiguous column per
+// loaded value field.
+class WeatherData {
+public:
+    // Constructor that loads the timestamp column and every column in countryMenu in a single pass,
+    // reusing the binary snapshot next to the CSV when the CSV has not changed since it was written.
+    // Columns outside countryMenu are skipped while parsing, so memory grows with the projection
+    // rather than with the width of the file. Columnar files (see ColumnarFile.h) are decoded directly.
+    WeatherData(const std::string& filename, const std::vector<std::string>& columnNames, const std::map<int, std::string>& countryMenu);
+    // Constructor that only needs the candlesticks whose bucket starts in [from, to): from a columnar file
+    // it decodes just the blocks those candlesticks depend on (see blocksForCandles). CSVs load whole.
+    WeatherData(const std::string& filename, const std::vector<std::string>& columnNames, const std::map<int, std::string>& countryMenu,
+                long long from, long long to);
+    // Number of data rows loaded from the file.
+    size_t rowCount() const;
+    // Timestamp column shared by every country, in UTC seconds since 1970-01-01.
+    const std::vector<long long>& timestamps() const;
+    // Values of a loaded column (NaN where the CSV field was missing), or nullptr if it was not loaded.
+    const std::vector<double>* column(const std::string& name) const;
+    // Builds the (year, value) pairs computeCandlesticks expects for a column, in the arena when given.
+    ArenaVector<std::pair<std::string, double>> yearlySeries(const std::string& name, Arena* arena = nullptr) const;
+    // Parses only the bytes appended to the file since it was loaded or last refreshed, and returns how many
+    // committed rows were added. Throws if the file shrank or is not a CSV. Not safe while other threads
+    // read the columns.
+    size_t refresh();
+    // Rows whose line ends in a newline. A final unterminated line is loaded as a row but may still be
+    // incomplete while the file is being appended to; refresh parses it again once the line is finished.
+    size_t committedRowCount() const;
+private:
+    // Maps each header position to the column it fills, throwing if a requested column is missing.
+    void mapColumns(const std::vector<std::string>& columnNames, const std::map<int, std::string>& countryMenu);
+    // Parses the CSV itself into the timestamp and value columns.
+    void loadCsv(const std::string& filename);
+    // Decodes the blocks of a columnar file that candlesticks starting in [from, to) need.
+    void loadColumnar(const std::string& filename, long long from, long long to);
+    // Records where the newline-terminated rows among the loaded bytes [body, end) of the file end.
+    void markCommitted(const char* fileBegin, const char* body, const char* end);
+
+    std::string sourceFile;
+    bool columnarSource;
+    std::vector<long long> timestampColumn;
+    std::map<std::string, std::vector<double>> columns;
+    std::vector<int> fieldSlots;                  // Output column of each header position, -1 when skipped
+    std::vector<std::vector<double>*> slotTargets;
+    size_t committedRows;
+    size_t committedBytes;                        // File offset just past the last committed row
+};
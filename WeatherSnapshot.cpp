@@ -0,0 +1,224 @@
+// WeatherSnapshot.cpp
+#include "WeatherSnapshot.h"
+#include "MappedFile.h"
+#include "BinaryFormat.h"
+#include "ColumnSchema.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace {
+
+const char snapshotMagic[8] = {'W', 'D', 'S', 'N', 'A', 'P', '0', '1'};
+const uint32_t snapshotVersion = 2;
+
+// Fixed-size header at the start of every snapshot.
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t columnNameCount;     // Entries in the CSV header
+    uint32_t storedColumnCount;   // Columns stored in the payload
+    uint32_t reserved;
+    uint64_t rowCount;
+    int64_t sourceModifiedTime;
+    uint64_t sourceSize;
+    uint64_t payloadSize;         // Bytes following the header
+    uint64_t checksum;            // Checksum of the names and the column directory
+    uint64_t timestampChecksum;
+};
+
+// Directory entry of one stored column. Each column carries its own checksum so loading a few
+// columns only reads (and verifies) their pages.
+struct ColumnEntry {
+    uint8_t type;                 // StorageType
+    uint8_t decimals;
+    uint8_t reserved[6];
+    uint64_t offset;              // From the start of the payload
+    uint64_t size;
+    uint64_t checksum;
+};
+
+// Validates the header, names and directory of a snapshot built from this source and CSV header, and
+// returns the stored column names and where the directory starts. False when the snapshot does not apply.
+bool openSnapshot(const MappedFile& file, const SnapshotSource& source, const std::vector<std::string>& columnNames,
+                  SnapshotHeader& header, std::vector<std::string>& storedColumns, const char*& directory) {
+    if (file.size() < sizeof(SnapshotHeader)) {
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0 || header.version != snapshotVersion ||
+        header.sourceModifiedTime != source.modifiedTime || header.sourceSize != source.size ||
+        header.columnNameCount != columnNames.size() || header.payloadSize != file.size() - sizeof(SnapshotHeader)) {
+        return false;
+    }
+
+    const char* payload = file.data() + sizeof(SnapshotHeader);
+    const char* end = payload + header.payloadSize;
+    const char* p = payload;
+    if (!matchNames(p, end, payload, columnNames) || !readNames(p, end, payload, header.storedColumnCount, storedColumns) ||
+        static_cast<size_t>(end - p) < storedColumns.size() * sizeof(ColumnEntry)) {
+        return false;
+    }
+    directory = p;
+    p += storedColumns.size() * sizeof(ColumnEntry);
+    return payloadChecksum(payload, static_cast<size_t>(p - payload)) == header.checksum;
+}
+
+} // namespace
+
+bool statSnapshotSource(const std::string& filename, SnapshotSource& source) {
+    struct stat info;
+    if (stat(filename.c_str(), &info) != 0) {
+        return false;
+    }
+    source.modifiedTime = static_cast<long long>(info.st_mtime);
+    source.size = static_cast<unsigned long long>(info.st_size);
+    return true;
+}
+
+std::string snapshotPathFor(const std::string& filename) {
+    return filename + ".snapshot";
+}
+
+bool readSnapshot(const std::string& path, const SnapshotSource& source,
+                  const std::vector<std::string>& columnNames, const std::vector<std::string>& loadedColumns,
+                  std::vector<long long>& timestamps, std::vector<std::vector<double>>& values) {
+    PROFILE_SCOPE("snapshot read");
+    if (!hostIsLittleEndian()) {
+        return false;
+    }
+
+    SnapshotSource cached;
+    if (!statSnapshotSource(path, cached)) {
+        return false; // No snapshot yet
+    }
+
+    MappedFile file(path);
+    SnapshotHeader header;
+    std::vector<std::string> storedColumns;
+    const char* directory;
+    if (!openSnapshot(file, source, columnNames, header, storedColumns, directory)) {
+        return false;
+    }
+    const char* payload = file.data() + sizeof(SnapshotHeader);
+    const char* end = payload + header.payloadSize;
+    const char* p = directory + storedColumns.size() * sizeof(ColumnEntry);
+
+    // Find every requested column before decoding any of them
+    size_t rows = static_cast<size_t>(header.rowCount);
+    std::vector<ColumnEntry> entries;
+    for (const auto& name : loadedColumns) {
+        size_t index = std::find(storedColumns.begin(), storedColumns.end(), name) - storedColumns.begin();
+        if (index == storedColumns.size()) {
+            return false; // Loaded with a different projection; parse the CSV instead
+        }
+        ColumnEntry entry;
+        std::memcpy(&entry, directory + index * sizeof(ColumnEntry), sizeof(entry));
+        if (entry.type > static_cast<uint8_t>(StorageType::Int16) || entry.offset > header.payloadSize ||
+            entry.size > header.payloadSize - entry.offset ||
+            entry.size != rows * storageWidth(static_cast<StorageType>(entry.type))) {
+            return false;
+        }
+        entries.push_back(entry);
+    }
+    if (static_cast<size_t>(end - p) / 8 < rows || payloadChecksum(p, rows * 8) != header.timestampChecksum) {
+        return false;
+    }
+
+    timestamps.resize(rows);
+    if (rows) std::memcpy(&timestamps[0], p, rows * 8);
+    values.assign(loadedColumns.size(), std::vector<double>());
+    for (size_t c = 0; c < entries.size(); ++c) {
+        const char* data = payload + entries[c].offset;
+        if (payloadChecksum(data, static_cast<size_t>(entries[c].size)) != entries[c].checksum) {
+            return false;
+        }
+        ColumnStorage storage;
+        storage.type = static_cast<StorageType>(entries[c].type);
+        storage.decimals = entries[c].decimals;
+        decodeColumn(data, rows, storage, values[c]);
+    }
+    return true;
+}
+
+bool snapshotColumns(const std::string& path, const SnapshotSource& source, const std::vector<std::string>& columnNames,
+                     std::vector<std::string>& storedColumns) {
+    SnapshotSource cached;
+    if (!hostIsLittleEndian() || !statSnapshotSource(path, cached)) {
+        return false;
+    }
+    MappedFile file(path);
+    SnapshotHeader header;
+    const char* directory;
+    return openSnapshot(file, source, columnNames, header, storedColumns, directory);
+}
+
+// Picks each column's storage type on worker threads, then lays out the directory and arrays.
+
+void writeSnapshot(const std::string& path, const SnapshotSource& source,
+                   const std::vector<std::string>& columnNames, const std::vector<std::string>& loadedColumns,
+                   const std::vector<long long>& timestamps, const std::vector<const std::vector<double>*>& values) {
+    PROFILE_SCOPE("snapshot write");
+    if (!hostIsLittleEndian()) {
+        throw std::runtime_error("Snapshots are only supported on little-endian hosts.");
+    }
+
+    size_t rows = timestamps.size();
+    for (const auto* column : values) {
+        if (column->size() != rows) {
+            throw std::runtime_error("Snapshot column length does not match the timestamp column.");
+        }
+    }
+    std::vector<ColumnStorage> storage(values.size());
+    parallelFor(values.size(), [&](size_t c) {
+        storage[c] = chooseColumnStorage(*values[c]);
+    });
+
+    std::vector<char> payload;
+    appendNames(payload, columnNames);
+    appendNames(payload, loadedColumns);
+    size_t directoryStart = payload.size();
+    payload.resize(directoryStart + values.size() * sizeof(ColumnEntry));
+
+    size_t timestampStart = payload.size();
+    payload.resize(timestampStart + rows * 8);
+    for (size_t i = 0; i < rows; ++i) {
+        int64_t timestamp = timestamps[i];
+        std::memcpy(&payload[timestampStart + i * 8], &timestamp, 8);
+    }
+
+    std::vector<ColumnEntry> entries(values.size());
+    for (size_t c = 0; c < values.size(); ++c) {
+        ColumnEntry& entry = entries[c];
+        std::memset(&entry, 0, sizeof(entry));
+        entry.type = static_cast<uint8_t>(storage[c].type);
+        entry.decimals = static_cast<uint8_t>(storage[c].decimals);
+        entry.offset = payload.size();
+        encodeColumn(*values[c], storage[c], payload);
+        entry.size = payload.size() - entry.offset;
+        entry.checksum = payloadChecksum(&payload[0] + entry.offset, static_cast<size_t>(entry.size));
+        payload.resize(paddedTo8(payload.size()), '\0');
+    }
+    if (!entries.empty()) {
+        std::memcpy(&payload[directoryStart], entries.data(), entries.size() * sizeof(ColumnEntry));
+    }
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = snapshotVersion;
+    header.columnNameCount = static_cast<uint32_t>(columnNames.size());
+    header.storedColumnCount = static_cast<uint32_t>(loadedColumns.size());
+    header.rowCount = rows;
+    header.sourceModifiedTime = source.modifiedTime;
+    header.sourceSize = source.size;
+    header.payloadSize = payload.size();
+    header.checksum = payloadChecksum(payload.data(), timestampStart);
+    header.timestampChecksum = payloadChecksum(payload.data() + timestampStart, rows * 8);
+
+    replaceFile(path, &header, sizeof(header), payload);
+}
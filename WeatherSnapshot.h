@@ -0,0 +1,38 @@
+// WeatherSnapshot.h
+#pragma once
+#include <vector>
+#include <string>
+
+// Binary sidecar cache of a loaded CSV (written next to it as "<file>.snapshot").
+// Layout, little-endian: fixed header, header column names, stored column names, a directory with the
+// storage type, offset and checksum of every stored column, int64 epoch-second timestamps, then one
+// array per stored column in the narrowest type that holds it exactly (see ColumnStorage).
+
+// Identity of the source CSV a snapshot was built from.
+struct SnapshotSource {
+    long long modifiedTime;
+    unsigned long long size;
+};
+
+// Reads the modification time and size of a file, returning false if it cannot be inspected.
+bool statSnapshotSource(const std::string& filename, SnapshotSource& source);
+
+// Path of the snapshot that belongs to a CSV file.
+std::string snapshotPathFor(const std::string& filename);
+
+// Loads the requested columns from a snapshot that matches the source and header, holds every requested
+// column and whose checksums verify. Columns that were not requested are never touched.
+// Returns false when the CSV has to be parsed instead.
+bool readSnapshot(const std::string& path, const SnapshotSource& source,
+                  const std::vector<std::string>& columnNames, const std::vector<std::string>& loadedColumns,
+                  std::vector<long long>& timestamps, std::vector<std::vector<double>>& values);
+
+// Names of the columns stored in the snapshot, if it matches the source and header. Only the header and
+// directory are read. Returns false when there is no usable snapshot.
+bool snapshotColumns(const std::string& path, const SnapshotSource& source, const std::vector<std::string>& columnNames,
+                     std::vector<std::string>& storedColumns);
+
+// Writes a snapshot of the loaded columns atomically (temporary file + rename). Throws on I/O failure.
+void writeSnapshot(const std::string& path, const SnapshotSource& source,
+                   const std::vector<std::string>& columnNames, const std::vector<std::string>& loadedColumns,
+                   const std::vector<long long>& timestamps, const std::vector<const std::vector<double>*>& values);
@@ -0,0 +1,13 @@
+// AllocationCounter.h
+#pragma once
+#include <cstddef>
+
+// Process-wide heap allocation counters, maintained by the replacement operator new/delete in
+// AllocationCounter.cpp. Only binaries that link that file count anything.
+struct AllocationCounts {
+    size_t allocations;
+    size_t bytes;
+};
+
+// Allocations (and bytes requested) since the process started.
+AllocationCounts allocationCounts();
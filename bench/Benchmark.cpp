@@ -0,0 +1,468 @@
+// Benchmark.cpp
+#include "AllocationCounter.h"
+#include "Arena.h"
+#include "SyntheticWeather.h"
+#include "CSVReader.h"
+#include "ComputeCandlesticks.h"
+#include "DataFilter.h"
+#include "PlotCandlesticks.h"
+#include "TemperaturePredictor.h"
+#include "BucketAggregator.h"
+#include "CandlestickFilter.h"
+#include "CandlestickTable.h"
+#include "CountryColumns.h"
+#include "ColumnSchema.h"
+#include "ColumnarFile.h"
+#include "WeatherData.h"
+#include "WeatherSnapshot.h"
+#include "Timestamp.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Discards everything written to it: the plot's sink, and the destination of debug output while measuring.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+// Sends std::cout and std::cerr to a NullBuffer while it is alive.
+class SilenceOutput {
+public:
+    SilenceOutput() : out(std::cout.rdbuf(&sink)), err(std::cerr.rdbuf(&sink)) {}
+    ~SilenceOutput() {
+        std::cout.rdbuf(out);
+        std::cerr.rdbuf(err);
+    }
+
+private:
+    NullBuffer sink;
+    std::streambuf* out;
+    std::streambuf* err;
+};
+
+// Keeps results observable so the optimizer cannot drop a measured call.
+volatile size_t resultSink = 0;
+
+struct StageResult {
+    std::string name;
+    size_t iterations;
+    double seconds;            // Mean wall time of one iteration
+    double minSeconds;
+    size_t items;              // Rows, entries or candlesticks one iteration processes
+    size_t bytes;              // Bytes one iteration reads, 0 where that is not meaningful
+    double allocations;        // Heap allocations per iteration
+    double allocatedBytes;     // Bytes requested from the heap per iteration
+};
+
+struct BenchSettings {
+    std::string input;         // Existing CSV, or empty to generate one
+    std::string generated;     // Where the generated CSV is written
+    SyntheticOptions synthetic;
+    std::string column;        // Column of the single-column stages, or empty for the first temperature column
+    double minTime;            // Seconds each stage is repeated for at least
+    std::string output;        // JSON report path, or empty for stdout
+    std::vector<std::string> stages;
+    bool keep;                 // Keep the generated CSV, its snapshot and its columnar copy
+
+    BenchSettings() : generated("weather_bench.csv"), minTime(0.5), keep(false) {
+        synthetic.rows = 100000;
+    }
+};
+
+const char* const stageNames[] = {"csv_read", "weather_data_csv", "weather_data_snapshot", "compute_candlesticks",
+                                  "aggregate_candlesticks", "filter_year_range", "filter_close_range", "candlestick_filter",
+                                  "render_plot", "predict", "columnar_write", "weather_data_columnar", "columnar_year_window",
+                                  "columnar_value_scan"};
+
+void printUsage(std::ostream& out) {
+    out << "Usage: weather_bench [options]\n"
+           "  --input FILE            Benchmark an existing CSV instead of a generated one\n"
+           "  --rows N                Rows of the generated CSV (default 100000)\n"
+           "  --countries N           Country columns of the generated CSV, 1 to 200 (default 4)\n"
+           "  --radiation             Add radiation columns to the generated CSV\n"
+           "  --seed N                Seed of the generated CSV (default 1)\n"
+           "  --generate-to FILE      Path of the generated CSV (default weather_bench.csv)\n"
+           "  --keep                  Keep the generated CSV, its snapshot and its columnar copy afterwards\n"
+           "  --column NAME           Column the single-column stages use (default: first temperature column)\n"
+           "  --min-time SECONDS      Repeat each stage for at least this long (default 0.5)\n"
+           "  --stages LIST           Comma-separated stages to run (default all):\n"
+           "                          csv_read, weather_data_csv, weather_data_snapshot, compute_candlesticks,\n"
+           "                          aggregate_candlesticks, filter_year_range, filter_close_range,\n"
+           "                          candlestick_filter, render_plot, predict, columnar_write,\n"
+           "                          weather_data_columnar, columnar_year_window, columnar_value_scan\n"
+           "  --output FILE           Write the JSON report to FILE instead of stdout\n"
+           "  --help                  Show this message\n";
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Runs `prepare` untimed and `body` timed, once to warm up and then until minTime has passed.
+// Allocation counts cover only `body`.
+template <typename Prepare, typename Body>
+StageResult measure(const std::string& name, size_t items, size_t bytes, double minTime, Prepare prepare, Body body) {
+    StageResult result;
+    result.name = name;
+    result.items = items;
+    result.bytes = bytes;
+    result.iterations = 0;
+    result.minSeconds = 0.0;
+
+    SilenceOutput silence;
+    prepare();
+    body();
+
+    double total = 0.0;
+    size_t allocations = 0, allocatedBytes = 0;
+    while (result.iterations == 0 || (total < minTime && result.iterations < 1000000)) {
+        prepare();
+        AllocationCounts before = allocationCounts();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        body();
+        double elapsed = secondsSince(start);
+        AllocationCounts after = allocationCounts();
+
+        allocations += after.allocations - before.allocations;
+        allocatedBytes += after.bytes - before.bytes;
+        result.minSeconds = result.iterations == 0 ? elapsed : std::min(result.minSeconds, elapsed);
+        total += elapsed;
+        ++result.iterations;
+    }
+    result.seconds = total / result.iterations;
+    result.allocations = static_cast<double>(allocations) / result.iterations;
+    result.allocatedBytes = static_cast<double>(allocatedBytes) / result.iterations;
+    return result;
+}
+
+void noPreparation() {}
+
+// Where the columnar stages write their copy of the dataset.
+std::string columnarPathFor(const std::string& input) {
+    return input + ".wcol";
+}
+
+size_t fileSize(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file.is_open() ? static_cast<size_t>(file.tellg()) : 0;
+}
+
+void writeNumber(double value, std::ostream& out) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", value);
+    out << text;
+}
+
+void writeReport(const BenchSettings& settings, const std::string& input, size_t rows, size_t columns,
+                 const std::string& column, const std::vector<StageResult>& results, std::ostream& out) {
+    out << "{\n  \"dataset\": {\"file\": ";
+    writeJsonString(input, out);
+    out << ", \"generated\": " << (settings.input.empty() ? "true" : "false") << ", \"bytes\": " << fileSize(input)
+        << ", \"rows\": " << rows << ", \"columns\": " << columns << ", \"column\": ";
+    writeJsonString(column, out);
+    out << "},\n  \"threads\": " << workerCount() << ",\n  \"minTime\": ";
+    writeNumber(settings.minTime, out);
+    out << ",\n  \"stages\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const StageResult& r = results[i];
+        out << (i ? "," : "") << "\n    {\"name\": ";
+        writeJsonString(r.name, out);
+        out << ", \"iterations\": " << r.iterations << ", \"seconds\": ";
+        writeNumber(r.seconds, out);
+        out << ", \"minSeconds\": ";
+        writeNumber(r.minSeconds, out);
+        out << ", \"items\": " << r.items << ", \"itemsPerSecond\": ";
+        writeNumber(r.seconds > 0.0 ? r.items / r.seconds : 0.0, out);
+        if (r.bytes) {
+            out << ", \"bytes\": " << r.bytes << ", \"bytesPerSecond\": ";
+            writeNumber(r.bytes / r.seconds, out);
+        }
+        out << ", \"allocations\": ";
+        writeNumber(r.allocations, out);
+        out << ", \"allocatedBytes\": ";
+        writeNumber(r.allocatedBytes, out);
+        out << '}';
+    }
+    out << "\n  ]\n}\n";
+}
+
+unsigned long long parseCount(const std::string& option, const std::string& value) {
+    char* end;
+    unsigned long long number = std::strtoull(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || value[0] == '-') {
+        throw std::runtime_error("Invalid value '" + value + "' for " + option);
+    }
+    return number;
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+bool wanted(const BenchSettings& settings, const std::string& stage) {
+    return settings.stages.empty() || std::find(settings.stages.begin(), settings.stages.end(), stage) != settings.stages.end();
+}
+
+// Runs the selected stages against one CSV. Stages reuse each other's outputs (the loaded dataset, the
+// candlesticks), which are built outside the timed regions whenever a stage needs them.
+std::vector<StageResult> runStages(const BenchSettings& settings, const std::string& input, std::string& column,
+                                   size_t& rows, size_t& columns) {
+    std::vector<StageResult> results;
+    const std::vector<std::string> columnNames = getColumnNames(input);
+    const ColumnSchema schema(columnNames);
+    if (schema.columns().empty()) {
+        throw std::runtime_error("No country columns found in " + input);
+    }
+    std::map<int, std::string> projection;
+    for (const auto& spec : schema.columns()) {
+        projection[static_cast<int>(projection.size()) + 1] = spec.name;
+    }
+    column = settings.column;
+    if (column.empty()) {
+        column = schema.hasVariable("temperature") ? schema.menu("temperature").begin()->second : schema.columns()[0].name;
+    }
+    columns = projection.size();
+
+    const size_t inputBytes = fileSize(input);
+    const std::string snapshot = snapshotPathFor(input);
+    std::remove(snapshot.c_str());
+
+    std::unique_ptr<SilenceOutput> silence(new SilenceOutput());
+    const ArenaVector<std::pair<std::string, double>> entries = CSVReader::readCSV(input, column);
+    const WeatherData weatherData(input, columnNames, projection);
+    silence.reset();
+    rows = weatherData.rowCount();
+
+    if (wanted(settings, "csv_read")) {
+        // readCSV goes through the WeatherData loader, so drop the snapshot to time the parse
+        results.push_back(measure("csv_read", rows, inputBytes, settings.minTime, [&]() { std::remove(snapshot.c_str()); }, [&]() {
+            resultSink = CSVReader::readCSV(input, column).size();
+        }));
+    }
+    if (wanted(settings, "weather_data_csv")) {
+        // Includes writing the snapshot, as a cold start does
+        results.push_back(measure("weather_data_csv", rows, inputBytes, settings.minTime, [&]() { std::remove(snapshot.c_str()); }, [&]() {
+            resultSink = WeatherData(input, columnNames, projection).rowCount();
+        }));
+    }
+    if (wanted(settings, "weather_data_snapshot")) {
+        {
+            SilenceOutput silence;
+            WeatherData(input, columnNames, projection); // Make sure the snapshot exists
+        }
+        results.push_back(measure("weather_data_snapshot", rows, fileSize(snapshot), settings.minTime, noPreparation, [&]() {
+            resultSink = WeatherData(input, columnNames, projection).rowCount();
+        }));
+    }
+    // The single-column stages allocate from one arena reset before every iteration, as a menu query does
+    Arena stageArena;
+    auto resetArena = [&]() { stageArena.reset(); };
+    if (wanted(settings, "compute_candlesticks")) {
+        results.push_back(measure("compute_candlesticks", entries.size(), 0, settings.minTime, resetArena, [&]() {
+            resultSink = computeCandlesticks(entries, &stageArena).size();
+        }));
+    }
+    if (wanted(settings, "aggregate_candlesticks")) {
+        results.push_back(measure("aggregate_candlesticks", rows, 0, settings.minTime, noPreparation, [&]() {
+            resultSink = aggregateCandlesticks(weatherData, column, BucketSize::Year).size();
+        }));
+    }
+
+    // The filters run over hourly candlesticks so they see as many items as the dataset has rows
+    std::vector<Candlestick> hourly = aggregateCandlesticks(weatherData, column, BucketSize::Hour);
+    std::vector<Candlestick> monthly = aggregateCandlesticks(weatherData, column, BucketSize::Month);
+    int firstYear = hourly.empty() ? 1980 : std::atoi(hourly.front().date.c_str());
+    int lastYear = hourly.empty() ? 1980 : std::atoi(hourly.back().date.c_str());
+    int fromYear = firstYear + (lastYear - firstYear) / 4;
+    int toYear = lastYear - (lastYear - firstYear) / 4;
+
+    if (wanted(settings, "filter_year_range")) {
+        results.push_back(measure("filter_year_range", hourly.size(), 0, settings.minTime, resetArena, [&]() {
+            resultSink = filterByYearRange(hourly, fromYear, toYear, &stageArena).size();
+        }));
+    }
+    if (wanted(settings, "filter_close_range")) {
+        results.push_back(measure("filter_close_range", hourly.size(), 0, settings.minTime, resetArena, [&]() {
+            resultSink = filterByClosingTemperatureRange(hourly, 0.0, 15.0, &stageArena).size();
+        }));
+    }
+    if (wanted(settings, "candlestick_filter")) {
+        // Both predicates in the fused single pass, for comparison with the two filters above
+        results.push_back(measure("candlestick_filter", hourly.size(), 0, settings.minTime, noPreparation, [&]() {
+            resultSink = CandlestickFilter().yearRange(fromYear, toYear).closeRange(0.0, 15.0).select(hourly).size();
+        }));
+    }
+    if (wanted(settings, "render_plot")) {
+        results.push_back(measure("render_plot", monthly.size(), 0, settings.minTime, resetArena, [&]() {
+            NullBuffer sink;
+            std::ostream out(&sink);
+            renderCandlesticks(monthly, 20, out, &stageArena);
+        }));
+    }
+    if (wanted(settings, "predict")) {
+        results.push_back(measure("predict", monthly.size(), 0, settings.minTime, resetArena, [&]() {
+            resultSink = TemperaturePredictor(monthly).predictTemperatures(lastYear + 1, lastYear + 10, &stageArena).size();
+        }));
+    }
+
+    // The columnar copy holds every value column; the load stages decode the same projection as above
+    const std::string columnar = columnarPathFor(input);
+    std::vector<std::string> valueColumns;
+    for (const auto& it : projection) {
+        valueColumns.push_back(it.second);
+    }
+    if (wanted(settings, "columnar_write")) {
+        results.push_back(measure("columnar_write", rows, 0, settings.minTime, noPreparation, [&]() {
+            writeColumnarFile(columnar, weatherData, columnNames[0], valueColumns);
+        }));
+        results.back().bytes = fileSize(columnar);
+    }
+    if (wanted(settings, "weather_data_columnar") || wanted(settings, "columnar_year_window") || wanted(settings, "columnar_value_scan")) {
+        writeColumnarFile(columnar, weatherData, columnNames[0], valueColumns);
+    }
+    if (wanted(settings, "weather_data_columnar")) {
+        results.push_back(measure("weather_data_columnar", rows, fileSize(columnar), settings.minTime, noPreparation, [&]() {
+            resultSink = WeatherData(columnar, columnNames, projection).rowCount();
+        }));
+    }
+    if (wanted(settings, "columnar_year_window")) {
+        // The middle half of the years, as filter_year_range selects, decoding only the blocks they need
+        const long long from = daysFromCivil(fromYear, 1, 1) * 86400;
+        const long long to = daysFromCivil(static_cast<long long>(toYear) + 1, 1, 1) * 86400;
+        size_t windowRows;
+        {
+            SilenceOutput silence;
+            windowRows = WeatherData(columnar, columnNames, projection, from, to).rowCount();
+        }
+        results.push_back(measure("columnar_year_window", windowRows, 0, settings.minTime, noPreparation, [&]() {
+            resultSink = WeatherData(columnar, columnNames, projection, from, to).rowCount();
+        }));
+    }
+    if (wanted(settings, "columnar_value_scan")) {
+        // Readings of at least 25 degrees: the zone maps skip every block from the colder seasons
+        results.push_back(measure("columnar_value_scan", rows, 0, settings.minTime, noPreparation, [&]() {
+            ColumnarFile file(columnar);
+            resultSink = selectReadings(file, column, 25.0, std::numeric_limits<double>::infinity(),
+                                        std::numeric_limits<long long>::min(), std::numeric_limits<long long>::max()).size();
+        }));
+    }
+    return results;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchSettings settings;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option == "--help" || option == "-h") {
+                printUsage(std::cout);
+                return 0;
+            }
+            if (option == "--radiation") {
+                settings.synthetic.radiation = true;
+                continue;
+            }
+            if (option == "--keep") {
+                settings.keep = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for " + option);
+            }
+            std::string value = argv[++i];
+            if (option == "--input") {
+                settings.input = value;
+            } else if (option == "--rows") {
+                settings.synthetic.rows = static_cast<size_t>(parseCount(option, value));
+            } else if (option == "--countries") {
+                settings.synthetic.countries = static_cast<size_t>(parseCount(option, value));
+            } else if (option == "--seed") {
+                settings.synthetic.seed = parseCount(option, value);
+            } else if (option == "--generate-to") {
+                settings.generated = value;
+            } else if (option == "--column") {
+                settings.column = value;
+            } else if (option == "--min-time") {
+                settings.minTime = std::strtod(value.c_str(), nullptr);
+            } else if (option == "--stages") {
+                settings.stages = splitList(value);
+                for (const auto& stage : settings.stages) {
+                    if (std::find(std::begin(stageNames), std::end(stageNames), stage) == std::end(stageNames)) {
+                        throw std::runtime_error("Unknown stage '" + stage + "'");
+                    }
+                }
+            } else if (option == "--output") {
+                settings.output = value;
+            } else {
+                throw std::runtime_error("Unknown option " + option);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n";
+        printUsage(std::cerr);
+        return 2;
+    }
+
+    const std::string input = settings.input.empty() ? settings.generated : settings.input;
+    int status = 0;
+    try {
+        if (settings.input.empty()) {
+            std::ofstream file(input, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Unable to write " + input);
+            }
+            writeSyntheticWeather(settings.synthetic, file);
+        }
+
+        std::string column;
+        size_t rows = 0, columns = 0;
+        std::vector<StageResult> results = runStages(settings, input, column, rows, columns);
+
+        if (settings.output.empty()) {
+            writeReport(settings, input, rows, columns, column, results, std::cout);
+        } else {
+            std::ofstream out(settings.output, std::ios::trunc);
+            writeReport(settings, input, rows, columns, column, results, out);
+            if (!out) {
+                throw std::runtime_error("Unable to write " + settings.output);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        status = 1;
+    }
+
+    if (settings.input.empty() && !settings.keep) {
+        std::remove(input.c_str());
+        std::remove(snapshotPathFor(input).c_str());
+        std::remove(columnarPathFor(input).c_str());
+    }
+    return status;
+}
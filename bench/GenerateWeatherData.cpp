@@ -0,0 +1,103 @@
+// GenerateWeatherData.cpp
+#include "SyntheticWeather.h"
+#include "Timestamp.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+void printUsage(std::ostream& out) {
+    out << "Usage: weather_gen [options]\n"
+           "  --rows N                Data rows (default 10000)\n"
+           "  --countries N           Country columns per variable, 1 to 200 (default 4)\n"
+           "  --radiation             Also write direct and diffuse radiation columns per country\n"
+           "  --start YYYY-MM-DD      Date of the first row (default 1980-01-01)\n"
+           "  --step SECONDS          Seconds between rows (default 3600)\n"
+           "  --seed N                Random seed; equal options and seeds give identical files (default 1)\n"
+           "  --missing FRACTION      Fraction of value fields left empty (default 0)\n"
+           "  --output FILE           Write to FILE instead of stdout\n"
+           "  --help                  Show this message\n";
+}
+
+unsigned long long parseCount(const std::string& option, const std::string& value) {
+    char* end;
+    unsigned long long number = std::strtoull(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || value[0] == '-') {
+        throw std::runtime_error("Invalid value '" + value + "' for " + option);
+    }
+    return number;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SyntheticOptions options;
+    std::string output;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option == "--help" || option == "-h") {
+                printUsage(std::cout);
+                return 0;
+            }
+            if (option == "--radiation") {
+                options.radiation = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for " + option);
+            }
+            std::string value = argv[++i];
+            if (option == "--rows") {
+                options.rows = static_cast<size_t>(parseCount(option, value));
+            } else if (option == "--countries") {
+                options.countries = static_cast<size_t>(parseCount(option, value));
+            } else if (option == "--start") {
+                int year;
+                unsigned month, day;
+                char extra;
+                if (std::sscanf(value.c_str(), "%d-%u-%u%c", &year, &month, &day, &extra) != 3 || month < 1 || month > 12 || day < 1 || day > 31) {
+                    throw std::runtime_error("Invalid value '" + value + "' for --start");
+                }
+                options.start = daysFromCivil(year, month, day) * 86400;
+            } else if (option == "--step") {
+                options.step = static_cast<long long>(parseCount(option, value));
+            } else if (option == "--seed") {
+                options.seed = parseCount(option, value);
+            } else if (option == "--missing") {
+                options.missingRate = std::strtod(value.c_str(), nullptr);
+            } else if (option == "--output") {
+                output = value;
+            } else {
+                throw std::runtime_error("Unknown option " + option);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n";
+        printUsage(std::cerr);
+        return 2;
+    }
+
+    try {
+        if (output.empty() || output == "-") {
+            std::ios::sync_with_stdio(false);
+            writeSyntheticWeather(options, std::cout);
+            std::cout.flush();
+        } else {
+            std::ofstream file(output, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Unable to write " + output);
+            }
+            writeSyntheticWeather(options, file);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
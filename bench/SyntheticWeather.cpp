@@ -0,0 +1,205 @@
+// SyntheticWeather.cpp
+#include "SyntheticWeather.h"
+#include "Timestamp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+
+const double pi = 3.14159265358979323846;
+
+const char* const exportCountries[] = {"AT", "BE", "BG", "CH", "CZ", "DE", "DK", "EE", "ES", "FI", "FR", "GB", "GR", "HR",
+                                       "HU", "IE", "IT", "LT", "LU", "LV", "NL", "NO", "PL", "PT", "RO", "SE", "SI", "SK"};
+
+// SplitMix64: tiny, fast and identical on every platform, unlike the std distributions.
+class Random {
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1).
+    double uniform() {
+        return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Approximately standard normal (Irwin-Hall sum of four uniforms), without any libm calls.
+    double normal() {
+        return (uniform() + uniform() + uniform() + uniform() - 2.0) * 1.7320508075688772;
+    }
+
+private:
+    uint64_t state;
+};
+
+// Per-country climate and the state of its anomaly processes.
+struct CountryModel {
+    double meanTemperature;
+    double seasonalAmplitude;
+    double dailyAmplitude;
+    double cloudBias;
+    double anomaly;
+    double cloud;
+};
+
+// Appends a value rounded to 1 or 3 decimals, much faster than printf for the hundreds of millions of fields
+// a large file holds.
+void appendFixed(double value, int decimals, std::string& out) {
+    const long long scale = decimals == 3 ? 1000 : 10;
+    long long scaled = std::llround(value * static_cast<double>(scale));
+    if (scaled < 0) {
+        out += '-';
+        scaled = -scaled;
+    }
+    char digits[24];
+    char* first = digits + sizeof(digits);
+    long long whole = scaled / scale;
+    do {
+        *--first = static_cast<char>('0' + whole % 10);
+        whole /= 10;
+    } while (whole);
+    out.append(first, digits + sizeof(digits));
+    out += '.';
+    long long fraction = scaled % scale;
+    for (long long unit = scale / 10; unit > 0; unit /= 10) {
+        out += static_cast<char>('0' + fraction / unit % 10);
+    }
+}
+
+} // namespace
+
+SyntheticOptions::SyntheticOptions()
+    : rows(10000), countries(4), radiation(false), start(daysFromCivil(1980, 1, 1) * 86400), step(3600), seed(1), missingRate(0.0) {}
+
+std::vector<std::string> syntheticCountryCodes(size_t count) {
+    std::vector<std::string> codes(exportCountries, exportCountries + sizeof(exportCountries) / sizeof(exportCountries[0]));
+    for (char first = 'A'; first <= 'Z' && codes.size() < count; ++first) {
+        for (char second = 'A'; second <= 'Z' && codes.size() < count; ++second) {
+            std::string code;
+            code += first;
+            code += second;
+            if (std::find(codes.begin(), codes.end(), code) == codes.end()) {
+                codes.push_back(code);
+            }
+        }
+    }
+    codes.resize(count);
+    return codes;
+}
+
+std::vector<std::string> syntheticColumnNames(const SyntheticOptions& options) {
+    std::vector<std::string> names(1, "utc_timestamp");
+    for (const auto& code : syntheticCountryCodes(options.countries)) {
+        names.push_back(code + "_temperature");
+        if (options.radiation) {
+            names.push_back(code + "_radiation_direct_horizontal");
+            names.push_back(code + "_radiation_diffuse_horizontal");
+        }
+    }
+    return names;
+}
+
+// Streams the file row by row through a reused buffer, so memory stays constant however many rows are written.
+
+void writeSyntheticWeather(const SyntheticOptions& options, std::ostream& out) {
+    if (options.rows == 0 || options.countries == 0 || options.countries > 200) {
+        throw std::runtime_error("Generated files need at least one row and 1 to 200 countries.");
+    }
+    if (options.step <= 0 || !(options.missingRate >= 0.0 && options.missingRate < 1.0)) {
+        throw std::runtime_error("The step must be positive and the missing rate in [0, 1).");
+    }
+    const long long last = options.start + static_cast<long long>(options.rows - 1) * options.step;
+    if (yearOfEpochSeconds(options.start) < 1000 || yearOfEpochSeconds(last) > 9999) {
+        throw std::runtime_error("Timestamps must stay within the years 1000 to 9999; use a smaller step.");
+    }
+
+    const std::vector<std::string> names = syntheticColumnNames(options);
+    Random climate(options.seed);
+    std::vector<CountryModel> models(options.countries);
+    for (auto& model : models) {
+        model.meanTemperature = 3.0 + 12.0 * climate.uniform();
+        model.seasonalAmplitude = 5.0 + 9.0 * climate.uniform();
+        model.dailyAmplitude = 1.5 + 4.0 * climate.uniform();
+        model.cloudBias = 0.2 + 0.5 * climate.uniform();
+        model.anomaly = 0.0;
+        model.cloud = model.cloudBias;
+    }
+    Random weather(options.seed * 0x2545F4914F6CDD1DULL + 1);
+    Random gaps(options.seed ^ 0x5DEECE66DULL);
+
+    std::string buffer;
+    for (size_t i = 0; i < names.size(); ++i) {
+        buffer += i ? "," : "";
+        buffer += names[i];
+    }
+    buffer += '\n';
+
+    long long currentDay = daysFromEpochSeconds(options.start) - 1;
+    char date[32] = "";
+    double dayOfYear = 0.0;
+    for (size_t row = 0; row < options.rows; ++row) {
+        const long long timestamp = options.start + static_cast<long long>(row) * options.step;
+        const long long day = daysFromEpochSeconds(timestamp);
+        if (day != currentDay) {
+            long long year;
+            unsigned month, dayOfMonth;
+            civilFromDays(day, year, month, dayOfMonth);
+            std::snprintf(date, sizeof(date), "%04lld-%02u-%02u", year, month, dayOfMonth);
+            dayOfYear = static_cast<double>(day - daysFromCivil(year, 1, 1));
+            currentDay = day;
+        }
+        const long long secondOfDay = timestamp - day * 86400;
+        char time[32];
+        std::snprintf(time, sizeof(time), "T%02lld:%02lld:%02lldZ", secondOfDay / 3600, secondOfDay / 60 % 60, secondOfDay % 60);
+        buffer += date;
+        buffer += time;
+
+        // Coldest in mid-January and at 03:00, warmest in mid-July and at 15:00
+        const double hour = secondOfDay / 3600.0;
+        const double season = -std::cos(2.0 * pi * (dayOfYear - 15.0) / 365.25);
+        const double daily = -std::cos(2.0 * pi * (hour - 3.0) / 24.0);
+        const double sun = hour > 6.0 && hour < 18.0 ? std::sin(pi * (hour - 6.0) / 12.0) : 0.0;
+        const double clearSky = 1000.0 * sun * (0.55 + 0.45 * season);
+        const double shared = weather.normal();
+
+        for (auto& model : models) {
+            model.anomaly = 0.97 * model.anomaly + 0.35 * shared + 0.25 * weather.normal();
+            double temperature = model.meanTemperature + model.seasonalAmplitude * season + model.dailyAmplitude * daily + model.anomaly;
+            buffer += ',';
+            if (options.missingRate == 0.0 || gaps.uniform() >= options.missingRate) {
+                appendFixed(temperature, 3, buffer);
+            }
+            if (!options.radiation) {
+                continue;
+            }
+            model.cloud = std::min(1.0, std::max(0.0, 0.98 * model.cloud + 0.02 * model.cloudBias + 0.08 * weather.normal()));
+            const double direct = clearSky * (1.0 - model.cloud);
+            const double diffuse = clearSky * (0.12 + 0.35 * model.cloud);
+            buffer += ',';
+            if (options.missingRate == 0.0 || gaps.uniform() >= options.missingRate) {
+                appendFixed(direct, 1, buffer);
+            }
+            buffer += ',';
+            if (options.missingRate == 0.0 || gaps.uniform() >= options.missingRate) {
+                appendFixed(diffuse, 1, buffer);
+            }
+        }
+        buffer += '\n';
+
+        if (buffer.size() >= (1 << 20)) {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!out) {
+        throw std::runtime_error("Unable to write the generated data.");
+    }
+}
@@ -0,0 +1,32 @@
+// SyntheticWeather.h
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Shape of a generated weather export. The same options and seed always produce the same file.
+struct SyntheticOptions {
+    size_t rows;              // Data rows after the header
+    size_t countries;         // 1 to 200 country columns per variable
+    bool radiation;           // Add COUNTRY_radiation_direct_horizontal / _diffuse_horizontal like the real export
+    long long start;          // Timestamp of the first row, in UTC seconds since 1970-01-01
+    long long step;           // Seconds between rows
+    uint64_t seed;
+    double missingRate;       // Fraction of value fields left empty
+
+    SyntheticOptions();
+};
+
+// Country codes used for the columns: the 28 codes of the real export first, then made-up two-letter codes.
+std::vector<std::string> syntheticCountryCodes(size_t count);
+
+// Header of the generated file, "utc_timestamp" first.
+std::vector<std::string> syntheticColumnNames(const SyntheticOptions& options);
+
+// Writes the CSV: hourly-style temperatures with seasonal and daily cycles plus AR(1) anomalies that are
+// partly shared between countries, and optionally a clear-sky radiation curve dimmed by cloud cover.
+// Temperatures have three decimals and radiation one, as in the real export.
+// Throws std::runtime_error for options outside the supported range.
+void writeSyntheticWeather(const SyntheticOptions& options, std::ostream& out);
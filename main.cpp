@@ -1,10 +1,19 @@
     // main.cpp
     #include "Candlestick.h"
-    #include "CSVReader.h"
-    #include "ComputeCandlesticks.h"
-    #include "DataFilter.h"
+    #include "Arena.h"
+    #include "BatchCandlesticks.h"
+    #include "BucketAggregator.h"
     #include "PlotCandlesticks.h"
     #include "TemperaturePredictor.h"
+    #include "CandlestickFilter.h"
+    #include "Forecaster.h"
+    #include "Parallel.h"
+    #include "WeatherData.h"
+    #include "CountryColumns.h"
+    #include "ColumnSchema.h"
+    #include "CandlestickTable.h"
+    #include "BatchMode.h"
+    #include "CrossCountryStats.h"
     #include <iostream>
     #include <vector>
     #include <string>
@@ -13,107 +22,76 @@
     #include <map>
     #include <iomanip>
     #include <limits>
+    #include <memory>
+    #include <stdexcept>
 
-   
-    std::vector<std::string> getColumnNames(const std::string& filename) {
-        std::ifstream file(filename);
-        std::vector<std::string> columnNames;
-
-        if (file.is_open()) {
-            std::string headerLine;
-            std::getline(file, headerLine); // Read the first line
-            std::stringstream ss(headerLine);
-            std::string column;
+    std::string selectCountry(const std::map<int, std::string>& countryMenu) {
+        while (true) {
+            std::cout << "\nAvailable Countries:\n";
 
-            while (std::getline(ss, column, ',')) {
-                columnNames.push_back(column);
+            for (const auto& it : countryMenu) {
+                std::cout << it.first << ". " << formatCountryName(it.second) << std::endl;
             }
-        } else {
-            throw std::runtime_error("Unable to open file: " + filename);
-        }
-
-        return columnNames;
-    }
 
+            std::cout << "Enter the number of the country: ";
+            int choice;
+            std::cin >> choice;
 
-    //  Dynamically extracts country columns from the dataset.
-    //  Vector of column names from the dataset.
-    //   Map of menu index to column name (e.g., "AT_temperature").
-     
-    std::map<int, std::string> extractCountryColumns(const std::vector<std::string>& columnNames) {
-        std::map<int, std::string> countryMenu;
-        int index = 1;
+            if (std::cin.fail()) {
+                std::cin.clear(); // Clear the error flags
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Discard invalid input
+                std::cout << "Invalid input. Please enter a valid number.\n";
+                continue;
+            }
 
-        for (const auto& column : columnNames) {
-            // Only include columns ending with "_temperature"
-            if (column.find("_temperature") != std::string::npos) {
-                countryMenu[index++] = column;
+            if (countryMenu.find(choice) != countryMenu.end()) {
+                return countryMenu.at(choice);
+            } else {
+                std::cout << "Invalid selection. Please try again.\n";
             }
         }
+    }
+
+    // Prompts for the variable to analyse when the export has more than one, e.g. temperature or radiation.
 
-        if (countryMenu.empty()) {
-            throw std::runtime_error("No country temperature columns found in the CSV file.");
+    std::string selectVariable(const ColumnSchema& schema) {
+        const std::vector<std::string>& variables = schema.variables();
+        if (variables.size() == 1) {
+            return variables[0];
         }
 
-        return countryMenu;
-    }
+        while (true) {
+            std::cout << "\nAvailable Variables:\n";
+            for (size_t i = 0; i < variables.size(); ++i) {
+                std::cout << i + 1 << ". " << formatVariableName(variables[i]) << std::endl;
+            }
+            std::cout << "Enter the number of the variable: ";
+            int choice;
+            std::cin >> choice;
 
-    // Converts a column name into a user-friendly country name.
-    //  Column name from the dataset (e.g., "AT_temperature").
-    //  Formatted country name (e.g., "Austria Temperature").
-     
-    std::string formatCountryName(const std::string& columnName) {
-        std::string countryCode = columnName.substr(0, columnName.find("_"));
-        std::string countryName = countryCode; // Default to code if not mapped
-
-        // Example map of country codes to full names (add more if needed)
-        static std::map<std::string, std::string> countryNameMap = {
-            {"AT", "Austria"},
-            {"BE", "Belgium"},
-            {"BG", "Bulgaria"},
-            {"CH", "Switzerland"},
-            {"CZ", "Czech Republic"},
-            {"DE", "Germany"},
-            {"DK", "Denmark"},
-            {"EE", "Estonia"},
-            {"ES", "Spain"},
-            {"FI", "Finland"},
-            {"FR", "France"},
-            {"GB", "United Kingdom"},
-            {"GR", "Greece"},
-            {"HR", "Croatia"},
-            {"HU", "Hungary"},
-            {"IE", "Ireland"},
-            {"IT", "Italy"},
-            {"LT", "Lithuania"},
-            {"LU", "Luxembourg"},
-            {"LV", "Latvia"},
-            {"NL", "Netherlands"},
-            {"NO", "Norway"},
-            {"PL", "Poland"},
-            {"PT", "Portugal"},
-            {"RO", "Romania"},
-            {"SE", "Sweden"},
-            {"SI", "Slovenia"},
-            {"SK", "Slovakia"}
-        };
-
-        if (countryNameMap.find(countryCode) != countryNameMap.end()) {
-            countryName = countryNameMap[countryCode];
-        }
+            if (std::cin.fail()) {
+                std::cin.clear(); // Clear the error flags
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Discard invalid input
+                std::cout << "Invalid input. Please enter a valid number.\n";
+                continue;
+            }
 
-        return countryName + " Temperature";
+            if (choice >= 1 && static_cast<size_t>(choice) <= variables.size()) {
+                return variables[choice - 1];
+            }
+            std::cout << "Invalid selection. Please try again.\n";
+        }
     }
 
-    std::string selectCountry(const std::map<int, std::string>& countryMenu) {
-        while (true) {
-            std::cout << "\nAvailable Countries:\n";
+    // Prompts for the time bucket candlesticks are aggregated into.
 
-            for (const auto& it : countryMenu) {
-                std::cout << it.first << ". " << formatCountryName(it.second) << std::endl;
-            }
+    BucketSize selectBucketSize() {
+        static const BucketSize sizes[] = {BucketSize::Hour, BucketSize::Day, BucketSize::Week, BucketSize::Month, BucketSize::Year};
 
-            std::cout << "Enter the number of the country: ";
+        while (true) {
+            std::cout << "\nAggregation Periods:\n";
+            std::cout << "1. Hour\n2. Day\n3. Week\n4. Month\n5. Year\n";
+            std::cout << "Enter the number of the period: ";
             int choice;
             std::cin >> choice;
 
@@ -124,42 +102,40 @@
                 continue;
             }
 
-            if (countryMenu.find(choice) != countryMenu.end()) {
-                return countryMenu.at(choice);
-            } else {
-                std::cout << "Invalid selection. Please try again.\n";
+            if (choice >= 1 && choice <= 5) {
+                return sizes[choice - 1];
             }
+            std::cout << "Invalid selection. Please try again.\n";
         }
     }
 
-    // Displays candlestick data in a tabular format.
+    // Displays the yearly closing temperature of every country side by side.
 
-    void displayCandlesticksAsTable(const std::vector<Candlestick>& candlesticks) {
-        // Print header
-        std::cout << std::setw(15) << "Year"
-                << std::setw(10) << "Open"
-                << std::setw(10) << "High"
-                << std::setw(10) << "Low"
-                << std::setw(10) << "Close" << std::endl;
+    void displayAllCountriesTable(const CandlestickMatrix& matrix) {
+        // Print header with one column per country code
+        std::cout << std::setw(8) << "Year";
+        for (const auto& column : matrix.columns) {
+            std::cout << std::setw(8) << column.substr(0, column.find("_"));
+        }
+        std::cout << std::endl;
 
         // Print separator line
-        std::cout << std::string(55, '-') << std::endl;
-
-        // Print each candlestick row
-        for (const auto& candle : candlesticks) {
-            std::cout << std::setw(15) << candle.date
-                    << std::setw(10) << std::fixed << std::setprecision(3) << candle.open
-                    << std::setw(10) << candle.high
-                    << std::setw(10) << candle.low
-                    << std::setw(10) << candle.close << std::endl;
+        std::cout << std::string(8 * (matrix.columns.size() + 1), '-') << std::endl;
+
+        // Print one row per year
+        for (size_t y = 0; y < matrix.years.size(); ++y) {
+            std::cout << std::setw(8) << matrix.years[y] << std::fixed << std::setprecision(2);
+            for (const auto& candles : matrix.candlesticks) {
+                std::cout << std::setw(8) << candles[y].close;
+            }
+            std::cout << std::endl;
         }
     }
 
-    // Prompts the user for filter criteria and filters the candlestick data accordingly.
+    // Prompts the user for filter criteria and filters the candlestick data accordingly; the year range
+    // is a binary search on the index kept next to the candlesticks, and the matches are copied into arena.
     
-    std::vector<Candlestick> filterCandlesticks(const std::vector<Candlestick>& candlesticks) {
-        std::vector<Candlestick> filtered;
-        
+    ArenaVector<Candlestick> filterCandlesticks(const std::vector<Candlestick>& candlesticks, const TimeIndex& index, Arena& arena) {
         bool filterDate = false, filterTemp = false;
         int startYear = 1980, endYear = 2019;
         double minTemp = -1000.0, maxTemp = 1000.0;
@@ -205,40 +181,27 @@
             }
         }
         
-        // Apply filters using DataFilter functions
-        std::vector<Candlestick> tempFiltered = candlesticks;
-        
+        // Collect the requested predicates and evaluate them in one pass
+        CandlestickFilter filter;
         if (filterDate) {
-            tempFiltered = filterByYearRange(tempFiltered, startYear, endYear);
+            filter.yearRange(startYear, endYear);
         }
-        
         if (filterTemp) {
-            tempFiltered = filterByClosingTemperatureRange(tempFiltered, minTemp, maxTemp);
+            filter.closeRange(minTemp, maxTemp);
         }
-        
-        filtered = tempFiltered;
+        ArenaVector<Candlestick> filtered = filter.apply(candlesticks, index, arena);
         
         // Debug output
         std::cout << "Debug: Filtered " << filtered.size() << " candlesticks after applying filters.\n";
         return filtered;
     }
 
-    // Handles the filtering and plotting functionality.
+    // Handles the filtering and plotting functionality for the candlesticks selected in option 1.
     
-    void filterAndPlot(const std::map<int, std::string>& countryMenu, const std::string& filename) {
+    void filterAndPlot(const std::vector<Candlestick>& candlesticks, const TimeIndex& index, Arena& arena) {
         try {
-            // Select Country
-            std::string selectedColumn = selectCountry(countryMenu);
-            std::cout << "You selected: " << formatCountryName(selectedColumn) << std::endl;
-
-            // Read CSV data for the selected country
-            std::vector<std::pair<std::string, double>> data = CSVReader::readCSV(filename, selectedColumn);
-
-            // Compute Candlesticks
-            std::vector<Candlestick> candlesticks = computeCandlesticks(data);
-
             // Apply Filters
-            std::vector<Candlestick> filteredCandlesticks = filterCandlesticks(candlesticks);
+            ArenaVector<Candlestick> filteredCandlesticks = filterCandlesticks(candlesticks, index, arena);
 
             if (filteredCandlesticks.empty()) {
                 std::cout << "No data matches the specified filters.\n";
@@ -251,27 +214,175 @@
 
             // Plot filtered candlesticks
             std::cout << "\nPlotting Filtered Candlestick Data:\n";
-            plotCandlesticks(filteredCandlesticks, 20);  // Adjust scaleHeight as needed
+            plotCandlesticks(filteredCandlesticks, 20, &arena);  // Adjust scaleHeight as needed
 
         } catch (const std::exception& e) {
             std::cerr << "Error during filtering and plotting: " << e.what() << std::endl;
         }
     }
 
-    int main() {
+    // Prompts for the model used to forecast every country.
+
+    ForecastModel selectForecastModel() {
+        static const ForecastModel models[] = {ForecastModel::Linear, ForecastModel::Harmonic, ForecastModel::HoltWinters};
+
+        while (true) {
+            std::cout << "\nForecast Models:\n";
+            std::cout << "1. Linear Trend\n2. Seasonal Harmonic Regression\n3. Holt-Winters\n";
+            std::cout << "Enter the number of the model: ";
+            int choice;
+            std::cin >> choice;
+
+            if (std::cin.fail()) {
+                std::cin.clear(); // Clear the error flags
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Discard invalid input
+                std::cout << "Invalid input. Please enter a valid number.\n";
+                continue;
+            }
+
+            if (choice >= 1 && choice <= 3) {
+                return models[choice - 1];
+            }
+            std::cout << "Invalid selection. Please try again.\n";
+        }
+    }
+
+    // Forecasts every country at once with the chosen period and model.
+
+    void forecastAllCountries(const std::map<int, std::string>& countryMenu, const WeatherData& weatherData) {
+        try {
+            ForecastOptions options;
+            options.bucketSize = selectBucketSize();
+            options.model = selectForecastModel();
+
+            int periods;
+            std::cout << "Enter the number of periods to forecast: ";
+            std::cin >> periods;
+            if (std::cin.fail() || periods < 1) {
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                std::cerr << "Invalid number of periods.\n";
+                return;
+            }
+
+            // Aggregate every country's history in parallel
+            std::vector<std::string> columns;
+            for (const auto& it : countryMenu) {
+                columns.push_back(it.second);
+            }
+            std::vector<std::vector<Candlestick>> history(columns.size());
+            parallelFor(columns.size(), [&](size_t i) {
+                history[i] = aggregateCandlesticks(weatherData, columns[i], options.bucketSize);
+            });
+
+            std::vector<ForecastSeries> series;
+            for (size_t i = 0; i < columns.size(); ++i) {
+                ForecastSeries entry = {columns[i], &history[i]};
+                series.push_back(entry);
+            }
+            std::vector<size_t> horizons;
+            for (int h = 1; h <= periods; ++h) {
+                horizons.push_back(static_cast<size_t>(h));
+            }
+
+            std::vector<ForecastResult> results = forecastAll(series, horizons, options);
+            for (const auto& result : results) {
+                std::cout << "\n" << formatCountryName(result.name) << " Forecast (" << forecastModelName(options.model) << "):\n";
+                displayCandlesticksAsTable(result.forecasts);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error during forecasting: " << e.what() << std::endl;
+        }
+    }
+
+    // Prints the correlation matrix of all countries, then the readings that stand out from the preceding window.
+
+    void displayCrossCountryStats(const std::map<int, std::string>& countryMenu, const WeatherData& weatherData) {
+        try {
+            std::vector<std::string> columns;
+            for (const auto& it : countryMenu) {
+                columns.push_back(it.second);
+            }
+
+            CorrelationMatrix matrix = correlationMatrix(weatherData, columns);
+            std::cout << "\nCorrelation Matrix (All Countries):\n";
+            std::cout << std::setw(6) << "";
+            for (const auto& column : columns) {
+                std::cout << std::setw(6) << column.substr(0, column.find("_"));
+            }
+            std::cout << std::endl;
+            std::cout << std::string(6 * (columns.size() + 1), '-') << std::endl;
+            for (size_t i = 0; i < columns.size(); ++i) {
+                std::cout << std::setw(6) << columns[i].substr(0, columns[i].find("_")) << std::fixed << std::setprecision(2);
+                for (size_t j = 0; j < columns.size(); ++j) {
+                    std::cout << std::setw(6) << matrix.at(i, j);
+                }
+                std::cout << std::endl;
+            }
+
+            int windowHours;
+            double threshold;
+            std::cout << "Enter the anomaly window in hours (e.g. 720): ";
+            std::cin >> windowHours;
+            std::cout << "Enter the z-score threshold (e.g. 4): ";
+            std::cin >> threshold;
+            if (std::cin.fail() || windowHours < 2 || threshold <= 0) {
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                std::cerr << "Invalid window or threshold.\n";
+                return;
+            }
+
+            std::vector<Anomaly> anomalies = findAnomalies(weatherData, columns, static_cast<size_t>(windowHours), threshold);
+            std::cout << "\nFound " << anomalies.size() << " anomalies";
+            const size_t shown = std::min<size_t>(anomalies.size(), 50);
+            if (shown < anomalies.size()) {
+                std::cout << " (showing the first " << shown << ")";
+            }
+            std::cout << ":\n";
+            std::cout << std::setw(22) << "Time" << std::setw(10) << "Country" << std::setw(10) << "Value" << std::setw(10) << "Z" << std::endl;
+            std::cout << std::string(52, '-') << std::endl;
+            for (size_t i = 0; i < shown; ++i) {
+                const Anomaly& anomaly = anomalies[i];
+                const std::string& column = columns[anomaly.column];
+                std::cout << std::setw(22) << bucketLabel(anomaly.timestamp, BucketSize::Hour)
+                          << std::setw(10) << column.substr(0, column.find("_")) << std::fixed << std::setprecision(3)
+                          << std::setw(10) << anomaly.value << std::setw(10) << anomaly.zScore << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    int main(int argc, char* argv[]) {
+        // Any command-line arguments select the headless batch mode instead of the menu
+        if (argc > 1) {
+            return runBatchMode(argc, argv);
+        }
+
         const std::string filename = "weather_data.csv";
         std::vector<std::string> columnNames;
         std::map<int, std::string> countryMenu;
-        std::vector<std::pair<std::string, double>> data;
         std::vector<Candlestick> candlesticks;
+        std::unique_ptr<TimeIndex> candleIndex;   // Dates of candlesticks, parsed once per selection
+        Arena queryArena;                         // Filtered copies, predictions and plot buffers of one menu query
         std::string selectedColumn;
 
         try {
             // Extract column names from the CSV file
             columnNames = getColumnNames(filename);
 
-            // Dynamically extract country columns
-            countryMenu = extractCountryColumns(columnNames);
+            // Group the columns by country and variable, and pick the variable to work on
+            ColumnSchema schema(columnNames);
+            if (schema.variables().empty()) {
+                throw std::runtime_error("No country columns found in the CSV file.");
+            }
+            std::string variable = selectVariable(schema);
+            countryMenu = schema.menu(variable);
+
+            // Load every country's column of that variable in one pass so switching countries never re-reads the file;
+            // the other variables stay on disk until selected
+            std::unique_ptr<WeatherData> weatherData(new WeatherData(filename, columnNames, countryMenu));
 
             // Menu Loop
             while (true) {
@@ -281,7 +392,11 @@
                 std::cout << "2. Plot Candlestick Data\n";
                 std::cout << "3. Filter Plot Data\n";
                 std::cout << "4. Predict Temperature Changes\n"; // New option
-                std::cout << "5. Exit\n"; // Updated Exit option number
+                std::cout << "5. Summarize All Countries\n";
+                std::cout << "6. Forecast All Countries\n";
+                std::cout << "7. Cross-Country Statistics\n";
+                std::cout << "8. Change Variable (" << formatVariableName(variable) << ")\n";
+                std::cout << "9. Exit\n";
                 std::cout << "Enter your choice: ";
 
                 int choice;
@@ -291,7 +406,7 @@
                 if (std::cin.fail()) {
                     std::cin.clear(); // clear the error flags
                     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // discard invalid input
-                    std::cout << "Invalid input. Please enter a number between 1 and 5.\n";
+                    std::cout << "Invalid input. Please enter a number between 1 and 9.\n";
                     continue;
                 }
 
@@ -301,9 +416,12 @@
                             selectedColumn = selectCountry(countryMenu);
                             std::cout << "You selected: " << formatCountryName(selectedColumn) << std::endl;
 
-                            // Read and compute candlesticks for the selected country
-                            data = CSVReader::readCSV(filename, selectedColumn);
-                            candlesticks = computeCandlesticks(data);
+                            // Aggregate the loaded column into candlesticks of the chosen period
+                            BucketSize bucketSize = selectBucketSize();
+                            std::vector<Candlestick> aggregated = aggregateCandlesticks(*weatherData, selectedColumn, bucketSize);
+                            std::unique_ptr<TimeIndex> index(new TimeIndex(aggregated));
+                            candlesticks.swap(aggregated); // Keeps the buffer the index points into
+                            candleIndex.swap(index);
 
                             // Display computed candlesticks immediately (Tabular Format Only)
                             std::cout << "\nCandlestick Data:\n";
@@ -318,7 +436,7 @@
                             std::cout << "No candlestick data available. Please select a country first.\n";
                         } else {
                             std::cout << "\nPlotting Candlestick Data:\n";
-                            plotCandlesticks(candlesticks, 20);  // Adjust scaleHeight as needed
+                            plotCandlesticks(candlesticks, 20, &queryArena);  // Adjust scaleHeight as needed
                         }
                         break;
 
@@ -326,7 +444,7 @@
                         if (candlesticks.empty()) {
                             std::cout << "No candlestick data available. Please select a country first.\n";
                         } else {
-                            filterAndPlot(countryMenu, filename);
+                            filterAndPlot(candlesticks, *candleIndex, queryArena);
                         }
                         break;
 
@@ -351,7 +469,7 @@
                                 TemperaturePredictor predictor(candlesticks);
                                 
                                 // Predict temperatures
-                                std::vector<Candlestick> predictions = predictor.predictTemperatures(predStartYear, predEndYear);
+                                ArenaVector<Candlestick> predictions = predictor.predictTemperatures(predStartYear, predEndYear, &queryArena);
                                 
                                 // Display predictions
                                 std::cout << "\nPredicted Candlestick Data:\n";
@@ -359,7 +477,7 @@
                                 
                                 // Plot predictions
                                 std::cout << "\nPlotting Predicted Candlestick Data:\n";
-                                plotCandlesticks(predictions, 20);
+                                plotCandlesticks(predictions, 20, &queryArena);
                                 
                             } catch (const std::exception& e) {
                                 std::cerr << "Error during prediction: " << e.what() << std::endl;
@@ -368,6 +486,41 @@
                         break;
 
                     case 5:
+                        try {
+                            // Compute every country's candlesticks in one batch
+                            CandlestickMatrix matrix = computeAllCandlesticks(*weatherData, countryMenu);
+                            std::cout << "\nYearly Closing " << formatVariableName(variable) << " (All Countries):\n";
+                            displayAllCountriesTable(matrix);
+                        } catch (const std::exception& e) {
+                            std::cerr << "Error: " << e.what() << std::endl;
+                        }
+                        break;
+
+                    case 6:
+                        forecastAllCountries(countryMenu, *weatherData);
+                        break;
+
+                    case 7:
+                        displayCrossCountryStats(countryMenu, *weatherData);
+                        break;
+
+                    case 8:
+                        try {
+                            variable = selectVariable(schema);
+                            countryMenu = schema.menu(variable);
+                            candlesticks.clear();
+                            candleIndex.reset();
+
+                            // Release the previous variable before loading the next so only one is ever in memory
+                            weatherData.reset();
+                            weatherData.reset(new WeatherData(filename, columnNames, countryMenu));
+                        } catch (const std::exception& e) {
+                            std::cerr << "Error: " << e.what() << std::endl;
+                            return 1;
+                        }
+                        break;
+
+                    case 9:
                         std::cout << "Exiting Weather Analysis...\n";
                         return 0;
 
@@ -375,6 +528,8 @@
                         std::cout << "Invalid choice. Please try again.\n";
                         break;
                 }
+                // Whatever the query left in the arena is dead once its output is shown
+                queryArena.reset();
             }
         } catch (const std::exception& e) {
             std::cerr << "Error: " << e.what() << std::endl;
@@ -0,0 +1,34 @@
+// BatchCandlesticksTests.cpp
+#include "Check.h"
+#include "TestData.h"
+#include "BatchCandlesticks.h"
+#include "CandleSeries.h"
+#include <cstdlib>
+#include <map>
+
+// Enough rows for several row partitions, whose years must come out as aggregateSeries computes them.
+TEST_CASE(batch, yearlyCandlesMatchAggregateSeries) {
+    const std::string path = writeTestCsv("batch_years", 20 * 8760);
+    {
+        std::map<int, std::string> projection;
+        projection[1] = "AT_temperature";
+        projection[2] = "DE_temperature";
+        WeatherData weatherData(path, testColumnNames(), projection);
+        CandlestickMatrix matrix = computeAllCandlesticks(weatherData, projection);
+        CHECK(matrix.columns.size() == 2);
+        CHECK(matrix.years.size() == 21);
+        for (size_t c = 0; c < matrix.columns.size(); ++c) {
+            CandleSeries expected = aggregateSeries(weatherData, matrix.columns[c], BucketSize::Year);
+            const std::vector<Candlestick>& actual = matrix.candlesticks[c];
+            CHECK(actual.size() == expected.size());
+            for (size_t i = 0; i < actual.size() && i < expected.size(); ++i) {
+                CHECK(std::atoi(actual[i].date.c_str()) == matrix.years[i]);
+                CHECK_SAME(actual[i].open, expected[i].open);
+                CHECK_SAME(actual[i].close, expected[i].close);
+                CHECK_SAME(actual[i].high, expected[i].high);
+                CHECK_SAME(actual[i].low, expected[i].low);
+            }
+        }
+    }
+    removeTestFiles(path);
+}
@@ -0,0 +1,31 @@
+// Check.h
+#pragma once
+#include <string>
+
+// Minimal self-registering checks for the ctest target, in the spirit of bench/'s own harness.
+//
+//   TEST_CASE(rollup, weekCandlesMatch) { CHECK(a == b); }
+//
+// Every case belongs to a group; ctest runs one group per test (weather_tests <group>).
+
+typedef void (*TestFunction)();
+
+// Adds a case to the registry; returns a dummy so it can initialize a static.
+int registerTest(const char* group, const char* name, TestFunction function);
+
+// Records a failed check of the running case.
+void reportFailure(const char* file, int line, const std::string& message);
+
+#define TEST_CASE(group, name) \
+    static void group##_##name(); \
+    static const int group##_##name##_registered = registerTest(#group, #name, group##_##name); \
+    static void group##_##name()
+
+#define CHECK(condition) \
+    do { if (!(condition)) reportFailure(__FILE__, __LINE__, #condition); } while (0)
+
+// Compares doubles bit for bit, so NaN equals NaN and 0.0 differs from -0.0.
+bool sameBits(double a, double b);
+
+#define CHECK_SAME(a, b) \
+    do { if (!sameBits((a), (b))) reportFailure(__FILE__, __LINE__, #a " is not bit-identical to " #b); } while (0)
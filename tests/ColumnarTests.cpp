@@ -0,0 +1,157 @@
+// ColumnarTests.cpp
+#include "Check.h"
+#include "TestData.h"
+#include "ColumnarFile.h"
+#include "CandleSeries.h"
+#include "Timestamp.h"
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace {
+
+std::map<int, std::string> projectionOf(const std::vector<std::string>& names) {
+    std::map<int, std::string> projection;
+    for (size_t i = 1; i < names.size(); ++i) {
+        projection[static_cast<int>(i)] = names[i];
+    }
+    return projection;
+}
+
+std::vector<std::string> valueColumns(const std::vector<std::string>& names) {
+    return std::vector<std::string>(names.begin() + 1, names.end());
+}
+
+void checkSameColumn(const std::vector<double>& expected, const std::vector<double>& actual) {
+    CHECK(expected.size() == actual.size());
+    for (size_t i = 0; i < expected.size() && i < actual.size(); ++i) {
+        CHECK_SAME(expected[i], actual[i]);
+    }
+}
+
+} // namespace
+
+// Three-decimal readings take the scaled-integer codec, full-precision ones the XOR codec; both must
+// decode to the parsed doubles, including NaN, -0.0, constant runs and timestamps that step backwards.
+TEST_CASE(columnar, codecsRoundTripEveryValue) {
+    std::ostringstream csv;
+    csv << "utc_timestamp,AT_temperature,DE_temperature,FR_temperature\n";
+    unsigned long long state = 3;
+    long long t = daysFromCivil(2015, 6, 1) * 86400;
+    char line[160];
+    for (int i = 0; i < 1000; ++i) {
+        t += i == 500 ? -7200 : i % 97 == 0 ? 86400 * 3 : 3600;
+        long long year;
+        unsigned month, day;
+        civilFromDays(daysFromEpochSeconds(t), year, month, day);
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        double precise = static_cast<double>(state >> 11) / 9007199254740992.0 * 80.0 - 40.0;
+        std::snprintf(line, sizeof(line), "%04lld-%02u-%02uT%02lld:00:00Z,", year, month, day, (t % 86400 + 86400) % 86400 / 3600);
+        csv << line;
+        if (i % 13 == 0) {
+            csv << (i % 26 == 0 ? "" : "-0.000");
+        } else {
+            std::snprintf(line, sizeof(line), "%.3f", (static_cast<double>(state >> 50) - 8192.0) / 400.0);
+            csv << line;
+        }
+        std::snprintf(line, sizeof(line), ",%.17g,%s\n", precise, i % 7 == 0 ? "" : "12.5");
+        csv << line;
+    }
+    const std::string path = writeCsvText("columnar_codecs", csv.str());
+    const std::string converted = path + ".wcol";
+    {
+        std::vector<std::string> names;
+        names.push_back("utc_timestamp");
+        names.push_back("AT_temperature");
+        names.push_back("DE_temperature");
+        names.push_back("FR_temperature");
+        WeatherData parsed(path, names, projectionOf(names));
+        writeColumnarFile(converted, parsed, names[0], valueColumns(names), 100);
+
+        ColumnarFile file(converted);
+        CHECK(file.columnNames() == names);
+        CHECK(file.rowCount() == 1000 && file.blockCount() == 10);
+        // The XOR chunks of the random column are wider than the scaled-integer ones
+        CHECK(file.columnChunkSize(0, 1) > file.columnChunkSize(0, 0));
+
+        WeatherData decoded(converted, names, projectionOf(names));
+        CHECK(decoded.timestamps() == parsed.timestamps());
+        for (size_t c = 1; c < names.size(); ++c) {
+            checkSameColumn(*parsed.column(names[c]), *decoded.column(names[c]));
+        }
+    }
+    std::remove(converted.c_str());
+    removeTestFiles(path);
+}
+
+// Windowed loads decode only some blocks, yet every candle in the window comes out as from the full file.
+TEST_CASE(columnar, windowedLoadsGiveExactCandles) {
+    const std::string path = writeTestCsv("columnar_window");
+    const std::string converted = path + ".wcol";
+    {
+        const std::vector<std::string> names = testColumnNames();
+        const std::map<int, std::string> projection = projectionOf(names);
+        WeatherData full(path, names, projection);
+        writeColumnarFile(converted, full, names[0], valueColumns(names), 256);
+
+        const int windows[4][2] = {{2018, 2018}, {2019, 2020}, {2020, 2020}, {2017, 2018}};
+        const BucketSize sizes[5] = {BucketSize::Hour, BucketSize::Day, BucketSize::Week, BucketSize::Month, BucketSize::Year};
+        for (const auto& window : windows) {
+            long long from = daysFromCivil(window[0], 1, 1) * 86400;
+            long long to = daysFromCivil(window[1] + 1, 1, 1) * 86400;
+            WeatherData partial(converted, names, projection, from, to);
+            CHECK(partial.rowCount() > 0);
+            CHECK(window[1] > window[0] || partial.rowCount() < full.rowCount());
+            for (BucketSize size : sizes) {
+                for (size_t c = 1; c < names.size(); ++c) {
+                    CandleSeries expected = aggregateSeries(full, names[c], size);
+                    CandleSeries actual = aggregateSeries(partial, names[c], size);
+                    std::pair<size_t, size_t> e = expected.timeRange(from, to);
+                    std::pair<size_t, size_t> a = actual.timeRange(from, to);
+                    CHECK(e.second - e.first == a.second - a.first);
+                    for (size_t i = 0; i < e.second - e.first && a.first + i < a.second; ++i) {
+                        CHECK(expected[e.first + i].start == actual[a.first + i].start);
+                        CHECK_SAME(expected[e.first + i].open, actual[a.first + i].open);
+                        CHECK_SAME(expected[e.first + i].high, actual[a.first + i].high);
+                        CHECK_SAME(expected[e.first + i].low, actual[a.first + i].low);
+                        CHECK_SAME(expected[e.first + i].close, actual[a.first + i].close);
+                    }
+                }
+            }
+        }
+    }
+    std::remove(converted.c_str());
+    removeTestFiles(path);
+}
+
+TEST_CASE(columnar, valueScansMatchBruteForce) {
+    const std::string path = writeTestCsv("columnar_scan");
+    const std::string converted = path + ".wcol";
+    {
+        const std::vector<std::string> names = testColumnNames();
+        WeatherData full(path, names, projectionOf(names));
+        writeColumnarFile(converted, full, names[0], valueColumns(names), 128);
+        ColumnarFile file(converted);
+
+        const double minValue = 20.0, maxValue = 23.5;
+        const long long from = daysFromCivil(2018, 5, 1) * 86400;
+        const long long to = std::numeric_limits<long long>::max();
+        std::vector<ColumnarReading> found = selectReadings(file, names[2], minValue, maxValue, from, to);
+        CHECK(file.blocksInValueRange(1, minValue, maxValue).size() < file.blockCount());
+
+        const std::vector<double>& values = *full.column(names[2]);
+        size_t next = 0;
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (full.timestamps()[i] < from || !(values[i] >= minValue && values[i] <= maxValue)) {
+                continue;
+            }
+            CHECK(next < found.size() && found[next].timestamp == full.timestamps()[i]);
+            CHECK(next < found.size() && sameBits(found[next].value, values[i]));
+            ++next;
+        }
+        CHECK(next == found.size());
+    }
+    std::remove(converted.c_str());
+    removeTestFiles(path);
+}
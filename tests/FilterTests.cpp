@@ -0,0 +1,92 @@
+// FilterTests.cpp
+#include "Check.h"
+#include "TestData.h"
+#include "CandlestickFilter.h"
+#include "CandleSeries.h"
+#include "Query.h"
+#include <map>
+
+namespace {
+
+std::map<int, std::string> bothColumns() {
+    std::map<int, std::string> projection;
+    projection[1] = "AT_temperature";
+    projection[2] = "DE_temperature";
+    return projection;
+}
+
+} // namespace
+
+// Temperature candles kept by the bucket mean of a second column, against picking them by hand.
+TEST_CASE(filter, whereKeepsBucketsByAnotherColumn) {
+    const std::string path = writeTestCsv("filter_where");
+    {
+        WeatherData weatherData(path, testColumnNames(), bothColumns());
+        WeatherQuery query;
+        query.column = "AT_temperature";
+        query.bucketSize = BucketSize::Month;
+        query.ranges[static_cast<int>(CandleField::Close)].enabled = true;
+        query.ranges[static_cast<int>(CandleField::Close)].minValue = 0.0;
+        query.ranges[static_cast<int>(CandleField::Close)].maxValue = 17.0;
+        ColumnRange range = {"DE_temperature", 8.0, 16.0};
+        query.where.push_back(range);
+        QueryResult result = runQuery(weatherData, query);
+
+        CandleSeries temperatures = aggregateSeries(weatherData, "AT_temperature", BucketSize::Month);
+        CandleSeries others = aggregateSeries(weatherData, "DE_temperature", BucketSize::Month);
+        CHECK(temperatures.size() == others.size());
+        std::vector<Candlestick> expected;
+        for (size_t i = 0; i < temperatures.size() && i < others.size(); ++i) {
+            CHECK(temperatures[i].start == others[i].start);
+            double other = others[i].close; // The close of a candle is its bucket mean
+            if (other >= 8.0 && other <= 16.0 && temperatures[i].close >= 0.0 && temperatures[i].close <= 17.0) {
+                expected.push_back(temperatures.candlestick(i));
+            }
+        }
+        CHECK(!expected.empty() && expected.size() < temperatures.size() / 2);
+        CHECK(result.candlesticks.size() == expected.size());
+        for (size_t i = 0; i < expected.size() && i < result.candlesticks.size(); ++i) {
+            CHECK(result.candlesticks[i].date == expected[i].date);
+            CHECK_SAME(result.candlesticks[i].close, expected[i].close);
+        }
+    }
+    removeTestFiles(path);
+}
+
+// The mask is filled during the scan, and must agree with the index list with or without a TimeIndex.
+TEST_CASE(filter, maskMatchesSelect) {
+    const std::string path = writeTestCsv("filter_mask");
+    {
+        WeatherData weatherData(path, testColumnNames(), bothColumns());
+        std::vector<Candlestick> candlesticks = aggregateCandlesticks(weatherData, "AT_temperature", BucketSize::Day);
+        std::vector<double> others = alignedBucketMeans(weatherData, "DE_temperature", BucketSize::Day, candlesticks);
+        TimeIndex index(candlesticks);
+
+        CandlestickFilter filter;
+        filter.yearRange(2018, 2019).closeRange(5.0, 14.0).seriesRange(others, 6.0, 15.0);
+        std::vector<size_t> selected = filter.select(candlesticks, index);
+        std::vector<unsigned char> bits = filter.mask(candlesticks, index);
+        CHECK(filter.mask(candlesticks) == bits);
+        CHECK(!selected.empty());
+
+        size_t next = 0;
+        for (size_t i = 0; i < candlesticks.size(); ++i) {
+            bool chosen = next < selected.size() && selected[next] == i;
+            CHECK((bits[i] != 0) == chosen);
+            next += chosen ? 1 : 0;
+        }
+        CHECK(next == selected.size());
+
+        // Candlesticks appended since position `first` are filtered on their own
+        const size_t first = candlesticks.size() / 2;
+        std::vector<size_t> tail = filter.select(candlesticks, index, first);
+        std::vector<size_t> expectedTail;
+        for (size_t i : selected) {
+            if (i >= first) {
+                expectedTail.push_back(i);
+            }
+        }
+        CHECK(tail == expectedTail);
+    }
+    removeTestFiles(path);
+}
@@ -0,0 +1,100 @@
+// ParseTests.cpp
+#include "Check.h"
+#include "FastParse.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// parseDouble must consume the whole text and agree with strtod to the last bit.
+void checkLikeStrtod(const std::string& text) {
+    double parsed = 0.0;
+    const char* end = parseDouble(text.c_str(), text.c_str() + text.size(), parsed);
+    if (end != text.c_str() + text.size()) {
+        reportFailure(__FILE__, __LINE__, "parseDouble stopped early on '" + text + "'");
+        return;
+    }
+    if (!sameBits(parsed, std::strtod(text.c_str(), nullptr))) {
+        reportFailure(__FILE__, __LINE__, "parseDouble differs from strtod on '" + text + "'");
+    }
+}
+
+bool parses(const char* text, long long& seconds) {
+    return parseTimestamp(text, text + std::strlen(text), seconds);
+}
+
+} // namespace
+
+TEST_CASE(parse, doublesMatchStrtod) {
+    const char* samples[] = {"0", "-0", "-0.000", "+1.5", "12.345", "-7.25", "0.1", "1e5", "1E-5", "2.5e+3", "-3.000e-2",
+                             "1234567890123456789012", "0.000000000000000000001", "9007199254740993", "179769313486231570000e288",
+                             "4.9e-324", "123456.789012345678901", ".5", "5."};
+    for (const char* sample : samples) {
+        checkLikeStrtod(sample);
+    }
+
+    // Every reading the exports contain: up to three decimals over the temperature range
+    char text[32];
+    for (int i = -60000; i <= 60000; i += 7) {
+        std::snprintf(text, sizeof(text), "%.3f", i / 1000.0);
+        checkLikeStrtod(text);
+        std::snprintf(text, sizeof(text), "%.1f", i / 10.0);
+        checkLikeStrtod(text);
+    }
+    unsigned long long state = 99;
+    for (int i = 0; i < 20000; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        double value = static_cast<double>(state >> 11) / static_cast<double>(1ULL << 40) - 4096.0;
+        std::snprintf(text, sizeof(text), "%.17g", value);
+        checkLikeStrtod(text);
+    }
+}
+
+TEST_CASE(parse, doublesRejectNonNumbers) {
+    const char* samples[] = {"", "-", "+", ".", "abc", "e5", "-.e1"};
+    for (const char* sample : samples) {
+        double parsed = 42.0;
+        const char* end = sample + std::strlen(sample);
+        CHECK(parseDouble(sample, end, parsed) == sample);
+    }
+    // A trailing field separator or a dangling exponent is left unconsumed
+    const char text[] = "21.5,7";
+    double parsed = 0.0;
+    CHECK(parseDouble(text, text + 6, parsed) == text + 4);
+    const char exponent[] = "3e";
+    CHECK(parseDouble(exponent, exponent + 2, parsed) == exponent + 1);
+    CHECK(parsed == 3.0);
+}
+
+TEST_CASE(parse, timestampsMatchCalendarArithmetic) {
+    long long seconds = 0;
+    CHECK(parses("1970-01-01T00:00:00Z", seconds) && seconds == 0);
+    CHECK(parses("1980-01-01T00:00:00Z", seconds) && seconds == 315532800);
+    CHECK(parses("2000-02-29T23:59:59Z", seconds) && seconds == 951868799);
+    CHECK(parses("2019-12-31 18:30", seconds) && seconds == 1577817000);
+    CHECK(parses("1980", seconds) && seconds == 315532800);
+    CHECK(parses("1980-03", seconds) && seconds == daysFromCivil(1980, 3, 1) * 86400);
+    CHECK(parses("1969-12-31T23:00:00Z", seconds) && seconds == -3600);
+
+    // Every hour of a leap year round-trips through the civil calendar
+    char text[32];
+    for (long long t = daysFromCivil(2016, 1, 1) * 86400; t < daysFromCivil(2017, 1, 1) * 86400; t += 3600) {
+        long long year;
+        unsigned month, day;
+        civilFromDays(daysFromEpochSeconds(t), year, month, day);
+        std::snprintf(text, sizeof(text), "%04lld-%02u-%02uT%02lld:00:00Z", year, month, day, (t / 3600) % 24);
+        CHECK(parses(text, seconds) && seconds == t);
+    }
+}
+
+TEST_CASE(parse, timestampsRejectMalformedText) {
+    const char* samples[] = {"", "198", "19x0-01-01", "1980-13-01", "1980-00-10", "1980-01-32", "1980-01-01T24:00:00Z",
+                             "1980-01-01T12:60:00Z"};
+    for (const char* sample : samples) {
+        long long seconds = 7;
+        CHECK(!parses(sample, seconds));
+        CHECK(seconds == 7);
+    }
+}
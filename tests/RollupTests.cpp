@@ -0,0 +1,106 @@
+// RollupTests.cpp
+#include "Check.h"
+#include "TestData.h"
+#include "RollupPyramid.h"
+#include "CandleSeries.h"
+#include "Timestamp.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+
+namespace {
+
+const BucketSize allSizes[5] = {BucketSize::Hour, BucketSize::Day, BucketSize::Week, BucketSize::Month, BucketSize::Year};
+
+void checkSameSeries(const CandleSeries& expected, const CandleSeries& actual) {
+    CHECK(expected.size() == actual.size());
+    for (size_t i = 0; i < expected.size() && i < actual.size(); ++i) {
+        CHECK(expected[i].start == actual[i].start);
+        CHECK_SAME(expected[i].open, actual[i].open);
+        CHECK_SAME(expected[i].high, actual[i].high);
+        CHECK_SAME(expected[i].low, actual[i].low);
+        CHECK_SAME(expected[i].close, actual[i].close);
+    }
+}
+
+} // namespace
+
+// Unbounded queries reach candles() with the LLONG_MIN/LLONG_MAX sentinels; weeks used to overflow there.
+TEST_CASE(rollup, unboundedCandlesMatchAggregate) {
+    const std::string path = writeTestCsv("rollup_unbounded");
+    {
+        std::vector<std::string> columns(1, "AT_temperature");
+        std::map<int, std::string> projection;
+        projection[1] = columns[0];
+        WeatherData weatherData(path, testColumnNames(), projection);
+        RollupPyramid rollups(columns);
+        rollups.build(weatherData);
+        for (BucketSize size : allSizes) {
+            CandleSeries expected = aggregateSeries(weatherData, columns[0], size);
+            CHECK(expected.size() > 1);
+            checkSameSeries(expected, rollups.candles(columns[0], size, std::numeric_limits<long long>::min(),
+                                                      std::numeric_limits<long long>::max()));
+        }
+    }
+    removeTestFiles(path);
+}
+
+TEST_CASE(rollup, yearWindowMatchesAggregateSlice) {
+    const std::string path = writeTestCsv("rollup_window");
+    {
+        std::vector<std::string> columns(1, "DE_temperature");
+        std::map<int, std::string> projection;
+        projection[1] = columns[0];
+        WeatherData weatherData(path, testColumnNames(), projection);
+        RollupPyramid rollups(columns);
+        rollups.build(weatherData);
+        const long long from = daysFromCivil(2019, 1, 1) * 86400;
+        const long long to = daysFromCivil(2020, 1, 1) * 86400;
+        for (BucketSize size : allSizes) {
+            CandleSeries all = aggregateSeries(weatherData, columns[0], size);
+            std::pair<size_t, size_t> range = all.timeRange(from, to);
+            checkSameSeries(all.slice(range.first, range.second), rollups.candles(columns[0], size, from, to));
+        }
+    }
+    removeTestFiles(path);
+}
+
+// Summaries over any range, including unbounded ones, equal a direct aggregation of the same readings.
+TEST_CASE(rollup, summarizeMatchesDirectStatistics) {
+    const std::string path = writeTestCsv("rollup_summary");
+    {
+        std::vector<std::string> columns(1, "AT_temperature");
+        std::map<int, std::string> projection;
+        projection[1] = columns[0];
+        WeatherData weatherData(path, testColumnNames(), projection);
+        RollupPyramid rollups(columns);
+        rollups.build(weatherData);
+        const std::vector<long long>& times = weatherData.timestamps();
+        const std::vector<double>& values = *weatherData.column(columns[0]);
+
+        const long long bounds[3][2] = {
+            {std::numeric_limits<long long>::min(), std::numeric_limits<long long>::max()},
+            {daysFromCivil(2018, 3, 14) * 86400 + 5 * 3600, daysFromCivil(2019, 11, 2) * 86400 + 17 * 3600},
+            {daysFromCivil(2018, 2, 1) * 86400, daysFromCivil(2018, 2, 1) * 86400}};
+        for (const auto& range : bounds) {
+            size_t count = 0;
+            double high = -std::numeric_limits<double>::infinity();
+            double sum = 0.0;
+            for (size_t i = 0; i < times.size(); ++i) {
+                if (times[i] >= range[0] && times[i] < range[1] && values[i] == values[i]) {
+                    ++count;
+                    high = std::max(high, values[i]);
+                    sum += values[i];
+                }
+            }
+            BucketStats summary = rollups.summarize(columns[0], range[0], range[1]);
+            CHECK(summary.count == count);
+            if (count > 0) {
+                CHECK_SAME(summary.high, high);
+                CHECK(std::abs(summary.mean - sum / count) < 1e-9);
+            }
+        }
+    }
+    removeTestFiles(path);
+}
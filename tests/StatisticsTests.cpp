@@ -0,0 +1,94 @@
+// StatisticsTests.cpp
+#include "Check.h"
+#include "TemperaturePredictor.h"
+#include "CrossCountryStats.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// Deterministic readings with a trend, a cycle and a large offset that strains naive sum-of-squares.
+std::vector<double> readings(size_t count, double offset) {
+    std::vector<double> values;
+    unsigned long long state = 7;
+    for (size_t i = 0; i < count; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        double noise = static_cast<double>((state >> 40) % 1000) / 500.0 - 1.0;
+        values.push_back(offset + 0.01 * i + 5.0 * std::sin(i / 9.0) + noise);
+    }
+    return values;
+}
+
+bool close(double a, double b, double tolerance) {
+    return std::fabs(a - b) <= tolerance * std::max(1.0, std::fabs(b));
+}
+
+} // namespace
+
+// A sliding window maintained with add/remove fits the same line as a predictor built from the window.
+TEST_CASE(statistics, predictorSlidingWindowMatchesRefit) {
+    std::vector<double> temperatures = readings(400, 1000.0);
+    const size_t window = 40;
+    TemperaturePredictor sliding;
+    for (size_t i = 0; i < temperatures.size(); ++i) {
+        sliding.addObservation(1980.0 + i, temperatures[i]);
+        if (i >= window) {
+            sliding.removeObservation(1980.0 + i - window, temperatures[i - window]);
+        }
+        if (i + 1 < window || i % 37 != 0) {
+            continue;
+        }
+        TemperaturePredictor refit;
+        for (size_t k = i + 1 - window; k <= i; ++k) {
+            refit.addObservation(1980.0 + k, temperatures[k]);
+        }
+        CHECK(sliding.observationCount() == window);
+        ArenaVector<Candlestick> expected = refit.predictTemperatures(2500, 2502);
+        ArenaVector<Candlestick> actual = sliding.predictTemperatures(2500, 2502);
+        CHECK(actual.size() == expected.size());
+        for (size_t k = 0; k < actual.size() && k < expected.size(); ++k) {
+            CHECK(close(actual[k].close, expected[k].close, 1e-9));
+            CHECK(close(actual[k].open, expected[k].open, 1e-9));
+        }
+    }
+}
+
+// Rolling Welford statistics against a two-pass computation of every window, with missing readings.
+TEST_CASE(statistics, rollingStatsMatchTwoPass) {
+    std::vector<double> values = readings(3000, 250.0);
+    for (size_t i = 0; i < values.size(); i += 11) {
+        values[i] = std::numeric_limits<double>::quiet_NaN();
+    }
+    for (size_t i = 1200; i < 1300; ++i) {
+        values[i] = std::numeric_limits<double>::quiet_NaN(); // Longer than the window: statistics go missing
+    }
+    const size_t window = 48;
+    RollingStats stats = rollingStats(values, window);
+    CHECK(stats.mean.size() == values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        size_t first = i + 1 >= window ? i + 1 - window : 0;
+        size_t count = 0;
+        double sum = 0.0;
+        for (size_t k = first; k <= i; ++k) {
+            if (!std::isnan(values[k])) {
+                ++count;
+                sum += values[k];
+            }
+        }
+        if (count == 0) {
+            CHECK(std::isnan(stats.mean[i]) && std::isnan(stats.stddev[i]));
+            continue;
+        }
+        double mean = sum / count;
+        double squares = 0.0;
+        for (size_t k = first; k <= i; ++k) {
+            if (!std::isnan(values[k])) {
+                squares += (values[k] - mean) * (values[k] - mean);
+            }
+        }
+        CHECK(close(stats.mean[i], mean, 1e-11));
+        CHECK(std::fabs(stats.stddev[i] - std::sqrt(squares / count)) < 1e-7);
+    }
+}
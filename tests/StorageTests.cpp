@@ -0,0 +1,105 @@
+// StorageTests.cpp
+#include "Check.h"
+#include "TestData.h"
+#include "ColumnSchema.h"
+#include "WeatherData.h"
+#include "WeatherSnapshot.h"
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace {
+
+// Encodes with the storage chooseColumnStorage picks and checks every value decodes to the same bits.
+ColumnStorage roundTrip(const std::vector<double>& values) {
+    ColumnStorage storage = chooseColumnStorage(values);
+    std::vector<char> encoded(3, 'x'); // Encoding appends after whatever the buffer holds
+    encodeColumn(values, storage, encoded);
+    CHECK(encoded.size() == 3 + values.size() * storageWidth(storage.type));
+    std::vector<double> decoded;
+    decodeColumn(encoded.data() + 3, values.size(), storage, decoded);
+    CHECK(decoded.size() == values.size());
+    for (size_t i = 0; i < values.size() && i < decoded.size(); ++i) {
+        CHECK_SAME(decoded[i], values[i]);
+    }
+    return storage;
+}
+
+} // namespace
+
+TEST_CASE(storage, scaledIntegersRoundTripExactly) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> tenths, thousandths, wide, fractions, arbitrary;
+    for (int i = -3000; i <= 3000; ++i) {
+        tenths.push_back(i / 10.0);
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.3f", i * 0.013); // As the CSV parser sees them
+        thousandths.push_back(std::strtod(text, nullptr));
+        wide.push_back(i * 1000.5);
+        fractions.push_back(i / 1024.0 + 1e-3);
+        arbitrary.push_back(i / 3.0);
+    }
+    // The exports hold missing fields and "-0.000", which have reserved codes
+    tenths.push_back(nan);
+    tenths.push_back(-0.0);
+    thousandths.push_back(-0.0);
+    thousandths.push_back(nan);
+
+    ColumnStorage storage = roundTrip(tenths);
+    CHECK(storage.type == StorageType::Int16 && storage.decimals == 1);
+    storage = roundTrip(thousandths);
+    CHECK(storage.type == StorageType::Int32 && storage.decimals == 3);
+    storage = roundTrip(wide);
+    CHECK(storage.type == StorageType::Int32 && storage.decimals == 1);
+    storage = roundTrip(fractions);
+    CHECK(storage.type == StorageType::Float64);
+    storage = roundTrip(arbitrary);
+    CHECK(storage.type == StorageType::Float64);
+
+    std::vector<double> floats(1, 0.1f);
+    floats.push_back(1e-30f);
+    CHECK(roundTrip(floats).type == StorageType::Float32);
+    CHECK(roundTrip(std::vector<double>()).type == StorageType::Int16);
+    CHECK(roundTrip(std::vector<double>(5, nan)).type == StorageType::Int16);
+}
+
+// Loading from the snapshot gives the same timestamps and values as parsing the CSV.
+TEST_CASE(storage, snapshotRoundTripMatchesCsv) {
+    const std::string path = writeCsvText("storage_snapshot",
+        "utc_timestamp,AT_temperature,DE_temperature,FR_temperature\n"
+        "2018-01-01T00:00:00Z,-0.000,1.25,0.1\n"
+        "2018-01-01T01:00:00Z,,1e3,0.30000000000000004\n"
+        "2018-01-01T02:00:00Z,-12.345,-0.5,\n"
+        "2018-01-01T03:00:00Z,40.001,,-7\n");
+    {
+        std::map<int, std::string> projection;
+        projection[1] = "AT_temperature";
+        projection[2] = "DE_temperature";
+        projection[3] = "FR_temperature";
+        std::vector<std::string> names;
+        names.push_back("utc_timestamp");
+        for (const auto& it : projection) {
+            names.push_back(it.second);
+        }
+        std::remove(snapshotPathFor(path).c_str());
+        WeatherData parsed(path, names, projection);
+        std::vector<std::string> stored;
+        SnapshotSource source;
+        CHECK(statSnapshotSource(path, source) && snapshotColumns(snapshotPathFor(path), source, names, stored));
+        CHECK(stored.size() == 3);
+        WeatherData cached(path, names, projection);
+
+        CHECK(parsed.timestamps() == cached.timestamps());
+        for (const auto& it : projection) {
+            const std::vector<double>& a = *parsed.column(it.second);
+            const std::vector<double>& b = *cached.column(it.second);
+            CHECK(a.size() == 4 && b.size() == 4);
+            for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+                CHECK_SAME(a[i], b[i]);
+            }
+        }
+    }
+    removeTestFiles(path);
+}
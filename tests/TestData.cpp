@@ -0,0 +1,69 @@
+// TestData.cpp
+#include "TestData.h"
+#include "Timestamp.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+std::vector<std::string> testColumnNames() {
+    std::vector<std::string> names;
+    names.push_back("utc_timestamp");
+    names.push_back("AT_temperature");
+    names.push_back("DE_temperature");
+    return names;
+}
+
+std::string writeTestCsv(const std::string& name, size_t rows) {
+    const std::string path = name + ".csv";
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    out << "utc_timestamp,AT_temperature,DE_temperature\n";
+    const long long start = daysFromCivil(2017, 12, 28) * 86400;
+    unsigned long long state = 12345;
+    for (size_t i = 0; i < rows; ++i) {
+        if (i >= 4000 && i < 4200) {
+            continue; // Eight days without rows
+        }
+        long long t = start + static_cast<long long>(i) * 3600;
+        long long year;
+        unsigned month, day;
+        civilFromDays(daysFromEpochSeconds(t), year, month, day);
+        long long second = t - daysFromEpochSeconds(t) * 86400;
+        char line[96];
+        std::snprintf(line, sizeof(line), "%04lld-%02u-%02uT%02lld:00:00Z", year, month, day, second / 3600);
+        out << line;
+        for (int c = 0; c < 2; ++c) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            if ((state >> 33) % 97 == 0) {
+                out << ",";
+                continue;
+            }
+            double noise = static_cast<double>((state >> 40) % 2000) / 1000.0 - 1.0;
+            double value = 8.0 + 10.0 * std::sin(i / 1400.0) + 4.0 * std::sin(i / 3.8) + noise + c;
+            std::snprintf(line, sizeof(line), ",%.3f", value);
+            out << line;
+        }
+        out << "\n";
+    }
+    return path;
+}
+
+std::string writeCsvText(const std::string& name, const std::string& contents) {
+    const std::string path = name + ".csv";
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out << contents;
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    return path;
+}
+
+void removeTestFiles(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + ".snapshot").c_str());
+    std::remove((path + ".rollup").c_str());
+    std::remove((path + ".wcol").c_str());
+}
@@ -0,0 +1,18 @@
+// TestData.h
+#pragma once
+#include <string>
+#include <vector>
+
+// Writes a small weather CSV with two temperature columns (AT, DE) and returns its path. Rows are hourly
+// from 2017-12-28, with a multi-day gap, some missing fields and three-decimal readings, so bucket edges,
+// gap candles and the first open are all exercised. The same name always gives the same file.
+std::string writeTestCsv(const std::string& name, size_t rows = 3 * 8760);
+
+// Writes `contents` to `name` + ".csv" and returns the path, for fixtures with unusual values.
+std::string writeCsvText(const std::string& name, const std::string& contents);
+
+// Removes the file and any cache files written next to it.
+void removeTestFiles(const std::string& path);
+
+// Header of the files writeTestCsv produces.
+std::vector<std::string> testColumnNames();
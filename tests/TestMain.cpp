@@ -0,0 +1,66 @@
+// TestMain.cpp
+#include "Check.h"
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+struct RegisteredTest {
+    const char* group;
+    const char* name;
+    TestFunction function;
+};
+
+std::vector<RegisteredTest>& registry() {
+    static std::vector<RegisteredTest> tests;
+    return tests;
+}
+
+size_t failures = 0;
+
+} // namespace
+
+int registerTest(const char* group, const char* name, TestFunction function) {
+    RegisteredTest test = {group, name, function};
+    registry().push_back(test);
+    return 0;
+}
+
+void reportFailure(const char* file, int line, const std::string& message) {
+    std::cout << "  " << file << ":" << line << ": " << message << "\n";
+    ++failures;
+}
+
+bool sameBits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+// Runs every case of the group named on the command line, or every case without one.
+
+int main(int argc, char* argv[]) {
+    const char* group = argc > 1 ? argv[1] : nullptr;
+    size_t run = 0, failed = 0;
+    for (const auto& test : registry()) {
+        if (group && std::strcmp(group, test.group) != 0) {
+            continue;
+        }
+        size_t before = failures;
+        try {
+            test.function();
+        } catch (const std::exception& e) {
+            reportFailure(test.group, 0, std::string("unexpected exception: ") + e.what());
+        }
+        ++run;
+        bool ok = failures == before;
+        failed += ok ? 0 : 1;
+        std::cout << (ok ? "ok     " : "FAILED ") << test.group << "." << test.name << "\n";
+    }
+    if (run == 0) {
+        std::cout << "No test cases in group " << (group ? group : "(all)") << "\n";
+        return 1;
+    }
+    std::cout << run - failed << " of " << run << " cases passed\n";
+    return failed == 0 ? 0 : 1;
+}